@@ -0,0 +1,237 @@
+/*******************************************************************************
+* Copyright  2026 Kerry S. Martin, martin@wild-wood.net
+* Free for usage without warranty, expressed or implied; attribution required
+*
+* Filename   : AutoScale.cpp
+* Class      : AutoScale
+* Description:
+*   AutoScale chooses the vertical range of an oscilloscope channel, with
+*   hysteresis and a memory of the ranges that settled.
+*
+* Created    : 10/16/2026
+* Modified   : 10/16/2026
+* Author     : Kerry S. Martin, martin@wild-wood.net
+*******************************************************************************/
+
+#include "AutoScale.h"
+#include <climits>
+#include <cmath>
+
+using namespace std;
+
+// auto-voltage-scale limits, as % of full-scale peak-to-peak voltage
+const double AutoScale::SEEK_MAX{ 1.000 };
+const double AutoScale::SEEK_MID{ 0.390 };
+const double AutoScale::SEEK_MIN{ 0.200 };
+const double AutoScale::SEEK_MARGIN{ 0.0275 };
+
+// range ratio a clipped signal moves up by (its amplitude is unknown)
+const double AutoScale::CLIP_JUMP{ 10.0 };
+
+// frequency regions the settled ranges are remembered by
+const double AutoScale::REGIONS_PER_DECADE{ 5.0 };
+
+
+/*******************************************************************************
+* Class      : AutoScale
+* Function   : AutoScale() constructor
+* Access     : public
+* Arguments  : none
+* Returns    : none
+* Description:
+*   Constructs an autoscale with no range settled and nothing remembered
+*/
+AutoScale::AutoScale() : state(State::UNKNOWN), region(INT_MIN), memory()
+{
+}
+
+
+/*******************************************************************************
+* Class      : AutoScale
+* Function   : Reset()
+* Access     : public
+* Arguments  : none
+* Returns    : none
+* Description:
+*   Forgets the ranges remembered, when the channel or its configuration
+*   (attenuation, coupling) has changed
+*/
+void AutoScale::Reset()
+{
+	state = State::UNKNOWN;
+	region = INT_MIN;
+	memory.clear();
+}
+
+
+/*******************************************************************************
+* Class      : AutoScale
+* Function   : Begin()
+* Access     : public
+* Arguments  : scope = oscilloscope driver
+*              ch    = oscilloscope channel
+*              f     = frequency of the point about to be measured
+*              vStim = stimulus amplitude (Vpp)
+*              scale = current scale of the channel, updated on return
+* Returns    : none
+* Description:
+*   Starts a point. If it falls in another frequency region than the last
+*   one, and a range settled there before, that range (scaled with the
+*   stimulus) is set and taken as settled.
+*/
+void AutoScale::Begin(ScopeDriver& scope, ScopeDriver::Channel ch, double f, double vStim, ScopeDriver::ScaleValues& scale)
+{
+	const int regionPoint = (f > 0.0) ? int(floor(REGIONS_PER_DECADE * log10(f))) : INT_MIN;
+
+	if (regionPoint == region)
+		return;
+
+	region = regionPoint;
+
+	auto it = memory.find(region);
+	if (it != memory.end() && vStim > 0.0)
+	{
+		const double vdiv = RoundUp125(it->second * vStim);
+
+		if (abs(vdiv - scale.vdiv) <= 1.0e-6 * vdiv || SetRange(scope, ch, vdiv, scale))
+			state = State::LOCKED;
+	}
+}
+
+
+/*******************************************************************************
+* Class      : AutoScale
+* Function   : Step()
+* Access     : public
+* Arguments  : scope = oscilloscope driver
+*              ch    = oscilloscope channel
+*              pkpk  = peak-to-peak value measured on the current range
+*              vStim = stimulus amplitude (Vpp)
+*              scale = current scale of the channel, updated on return
+* Returns    : +1 if the range was raised, -1 if it was lowered, 0 if it has
+*              settled (measure on it)
+* Description:
+*   Checks the signal against the band of the current state, and changes
+*   the range if it is outside. Call again after measuring on the new range
+*   until 0 is returned. A failed measurement (not finite) is measured as it
+*   is, as is a signal outside a range that cannot be changed any further.
+*/
+int AutoScale::Step(ScopeDriver& scope, ScopeDriver::Channel ch, double pkpk, double vStim, ScopeDriver::ScaleValues& scale)
+{
+	if (!isfinite(pkpk) || !(scale.vdiv > 0.0))
+		return 0;
+
+	// the lower bound drops to SEEK_MIN once settled (hysteresis)
+	const double dHigh = (SEEK_MAX - SEEK_MARGIN) * scale.pp;
+	const double dLow = (((state == State::LOCKED) ? SEEK_MIN : SEEK_MID) - SEEK_MARGIN) * scale.pp;
+
+	if (pkpk >= dLow && pkpk <= dHigh)
+	{
+		state = State::LOCKED;
+		if (vStim > 0.0 && region != INT_MIN)
+			memory[region] = scale.vdiv / vStim;
+		return 0;
+	}
+
+	// the most sensitive range holding the signal below SEEK_MAX, or a jump up when clipped (at the screen edge)
+	const double vdivLast = scale.vdiv;
+	double vdiv;
+
+	if (pkpk >= scale.pp)
+		vdiv = RoundUp125(vdivLast * CLIP_JUMP);
+	else if (pkpk > 0.0)
+		vdiv = RoundUp125(pkpk * vdivLast / dHigh);
+	else
+		vdiv = RoundUp125(vdivLast / CLIP_JUMP);
+
+	state = State::SEEK;
+
+	if (!SetRange(scope, ch, vdiv, scale))
+	{
+		// beyond the ranges of the channel: straight to the end range (three 1-2-5 steps
+		// per decade, of which the driver takes at most three at a time)
+		int steps = int(lround(3.0 * log10(vdiv / vdivLast)));
+		while (steps != 0)
+		{
+			const int adjust = (steps > 3) ? 3 : ((steps < -3) ? -3 : steps);
+			const double vdivBefore = scale.vdiv;
+
+			scope.AdjustChannelVolts(ch, adjust, scale);
+			steps -= adjust;
+
+			if (!(scale.vdiv > 0.0) || abs(scale.vdiv - vdivBefore) <= vdivBefore * 1.0e-6)
+				break;
+		}
+	}
+
+	if (scale.vdiv > vdivLast * (1.0 + 1.0e-6))
+		return +1;
+	if (scale.vdiv < vdivLast * (1.0 - 1.0e-6))
+		return -1;
+
+	// at the end of the ranges, nothing more can be done
+	state = State::LOCKED;
+	return 0;
+}
+
+
+/*******************************************************************************
+* Class      : AutoScale
+* Function   : GetState()
+* Access     : public
+* Arguments  : none
+* Returns    : the state of the autoscale
+*/
+AutoScale::State AutoScale::GetState() const
+{
+	return state;
+}
+
+
+/*******************************************************************************
+* Class      : AutoScale
+* Function   : SetRange()
+* Access     : private
+* Arguments  : scope = oscilloscope driver
+*              ch    = oscilloscope channel
+*              vdiv  = V/division to set, keeping the offset
+*              scale = receives the resulting scale
+* Returns    : true if the range was set (false if it is beyond the channel)
+*/
+bool AutoScale::SetRange(ScopeDriver& scope, ScopeDriver::Channel ch, double vdiv, ScopeDriver::ScaleValues& scale)
+{
+	if (!scope.SetChannelVoltsEx(ch, vdiv, scale.offset))
+		return false;
+
+	// read back the scale now in effect
+	scope.AdjustChannelVolts(ch, 0, scale);
+	return true;
+}
+
+
+/*******************************************************************************
+* Class      : AutoScale
+* Function   : RoundUp125()
+* Access     : private static
+* Arguments  : v = V/division (> 0)
+* Returns    : the smallest 1-2-5 value not below v
+*/
+double AutoScale::RoundUp125(double v)
+{
+	const double decade = pow(10.0, floor(log10(v)));
+	const double mantissa = v / decade;
+
+	if (mantissa <= 1.0 + 1.0e-6)
+		return decade;
+	if (mantissa <= 2.0 + 1.0e-6)
+		return 2.0 * decade;
+	if (mantissa <= 5.0 + 1.0e-6)
+		return 5.0 * decade;
+	return 10.0 * decade;
+}
+
+
+/*******************************************************************************
+* Copyright  2026 Kerry S. Martin, martin@wild-wood.net
+* Free for usage without warranty, expressed or implied; attribution required
+*******************************************************************************/
\ No newline at end of file
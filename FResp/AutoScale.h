@@ -0,0 +1,71 @@
+/*******************************************************************************
+* Copyright  2026 Kerry S. Martin, martin@wild-wood.net
+* Free for usage without warranty, expressed or implied; attribution required
+*
+* Filename   : AutoScale.h
+* Class      : AutoScale
+* Description:
+*   AutoScale chooses the vertical range of one oscilloscope channel for each
+*   point of a sweep, as a state machine:
+*     UNKNOWN  no range has settled yet (after Reset())
+*     SEEK     the range was just changed; it settles once the peak-to-peak
+*              value is between SEEK_MID and SEEK_MAX of full scale
+*     LOCKED   a range has settled, and is kept while the peak-to-peak value
+*              stays between SEEK_MIN and SEEK_MAX of full scale
+*   The gap between SEEK_MIN and SEEK_MID is the hysteresis band: a signal
+*   sitting near a range boundary does not switch ranges back and forth.
+*
+*   When the range must change, the new one is computed directly from the
+*   peak-to-peak value: the most sensitive 1-2-5 range that holds it below
+*   SEEK_MAX, which places it above SEEK_MID, so an unclipped signal settles
+*   in one adjustment. Only a signal at or beyond the edge of the screen is
+*   clipped; it has no known amplitude, and moves up CLIP_JUMP at a time. A
+*   range beyond the channel is replaced by the end range of the channel.
+*
+*   The range that settled is remembered for each frequency region
+*   (REGIONS_PER_DECADE per decade) relative to the stimulus amplitude, and
+*   recalled when a point falls in another region, so repeated sweeps, and
+*   sweeps measured out of frequency order, start each point near its range.
+*
+* Created    : 10/16/2026
+* Modified   : 10/16/2026
+* Author     : Kerry S. Martin, martin@wild-wood.net
+*******************************************************************************/
+#pragma once
+#include "ScopeDriver.h"
+#include <map>
+
+class AutoScale
+{
+public:
+	enum class State { UNKNOWN, SEEK, LOCKED };
+
+	AutoScale();
+
+	void Reset();
+	void Begin(ScopeDriver& scope, ScopeDriver::Channel ch, double f, double vStim, ScopeDriver::ScaleValues& scale);
+	int Step(ScopeDriver& scope, ScopeDriver::Channel ch, double pkpk, double vStim, ScopeDriver::ScaleValues& scale);
+	State GetState() const;
+
+	// constant settings
+	static const double SEEK_MAX;
+	static const double SEEK_MID;
+	static const double SEEK_MIN;
+	static const double SEEK_MARGIN;
+	static const double CLIP_JUMP;
+	static const double REGIONS_PER_DECADE;
+
+private:
+	State state;
+	int region;						// frequency region of the point being measured
+	std::map<int, double> memory;	// settled V/div per stimulus Vpp, by frequency region
+
+	bool SetRange(ScopeDriver& scope, ScopeDriver::Channel ch, double vdiv, ScopeDriver::ScaleValues& scale);
+	static double RoundUp125(double v);
+};
+
+
+/*******************************************************************************
+* Copyright  2026 Kerry S. Martin, martin@wild-wood.net
+* Free for usage without warranty, expressed or implied; attribution required
+*******************************************************************************/
\ No newline at end of file
@@ -0,0 +1,301 @@
+/*******************************************************************************
+* Copyright  2026 Kerry S. Martin, martin@wild-wood.net
+* Free for usage without warranty, expressed or implied; attribution required
+*
+* Filename   : ChannelCal.cpp
+* Class      : ChannelCal, CalTable, CalKey
+* Description:
+*   ChannelCal holds the bench calibration of the input/output channel
+*   mismatch, and corrects measurements with it.
+*
+*   File format (one record per line, fields separated by spaces):
+*     FRESP_CAL version
+*     TABLE  in.ch in.coup in.atten in.bwl out.ch out.coup out.atten out.bwl ttMeas
+*     CAL    freq dBgain time
+*            (one per point, following its TABLE record)
+*   Enumerations are written as their integer values.
+*
+* Created    : 10/16/2026
+* Modified   : 10/16/2026
+* Author     : Kerry S. Martin, martin@wild-wood.net
+*******************************************************************************/
+
+#include "ChannelCal.h"
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <limits>
+#include <sstream>
+
+using namespace std;
+
+const char* const ChannelCal::FILE_ID{ "FRESP_CAL" };
+const int ChannelCal::FILE_VERSION{ 1 };
+
+// number of significant digits needed to read back a double exactly
+constexpr auto CAL_PRECISION = numeric_limits<double>::max_digits10;
+
+
+/*******************************************************************************
+* Class      : CalKey
+* Function   : Matches()
+* Access     : public
+* Arguments  : key = setup to compare with
+* Returns    : true if a table measured with this setup is valid for key
+* Description:
+*   Compares every setting that changes the channel mismatch
+*/
+bool CalKey::Matches(CalKey const& key) const
+{
+	return input.ch == key.input.ch && input.coup == key.input.coup && input.atten == key.input.atten && input.bwl == key.input.bwl
+		&& output.ch == key.output.ch && output.coup == key.output.coup && output.atten == key.output.atten && output.bwl == key.output.bwl
+		&& ttMeas == key.ttMeas;
+}
+
+
+/*******************************************************************************
+* Class      : CalTable
+* Function   : Correct()
+* Access     : public
+* Arguments  : point = measured point, corrected on return
+* Returns    : none
+* Description:
+*   Removes the channel mismatch from a measured point: the gain and the
+*   output magnitude by the calibrated gain, and the phase or delay by the
+*   calibrated phase or delay. The correction is interpolated linearly in log
+*   frequency, and held at the end values outside the calibrated range. A
+*   corrected phase is wrapped to +/-180 degrees again.
+*/
+void CalTable::Correct(FRS& point) const
+{
+	if (points.empty())
+		return;
+
+	double dBgain;
+	double time;
+
+	auto upper = upper_bound(points.begin(), points.end(), point.freq, [](double f, CalPoint const& cp) { return f < cp.freq; });
+
+	if (upper == points.begin())
+	{
+		dBgain = points.front().dBgain;
+		time = points.front().time;
+	}
+	else if (upper == points.end())
+	{
+		dBgain = points.back().dBgain;
+		time = points.back().time;
+	}
+	else
+	{
+		CalPoint const& lower = *(upper - 1);
+		const double x = log(point.freq / lower.freq) / log(upper->freq / lower.freq);
+		dBgain = lower.dBgain + x * (upper->dBgain - lower.dBgain);
+		time = lower.time + x * (upper->time - lower.time);
+	}
+
+	point.dBgain -= dBgain;
+	point.mag_out *= pow(10.0, -dBgain / 20.0);
+	point.time -= time;
+
+	if (key.ttMeas == Ttype_t::PHASE)
+	{
+		if (point.time > 180.0)
+			point.time -= 360.0;
+		else if (point.time <= -180.0)
+			point.time += 360.0;
+	}
+}
+
+
+/*******************************************************************************
+* Class      : CalTable
+* Function   : Covers()
+* Access     : public
+* Arguments  : fStart, fStop = sweep frequency range
+* Returns    : true if the sweep is within the calibrated range
+* Description:
+*   Reports whether every frequency of a sweep can be interpolated, rather
+*   than held at the end of the calibrated range
+*/
+bool CalTable::Covers(double fStart, double fStop) const
+{
+	if (points.empty())
+		return false;
+
+	const double fLow = (fStart < fStop) ? fStart : fStop;
+	const double fHigh = (fStart < fStop) ? fStop : fStart;
+
+	return fLow >= points.front().freq && fHigh <= points.back().freq;
+}
+
+
+/*******************************************************************************
+* Class      : ChannelCal
+* Function   : Load()
+* Access     : public
+* Arguments  : filename = calibration file to read
+* Returns    : true if the whole file was read
+* Description:
+*   Reads the calibration tables of a bench, replacing any held. Reading stops
+*   at the first line that cannot be parsed, which fails the file (the tables
+*   before it are held).
+*/
+bool ChannelCal::Load(std::string filename)
+{
+	ifstream infile(filename);
+	string strLine;
+
+	tables.clear();
+
+	if (!infile.is_open())
+		return false;
+
+	// identification line
+	if (getline(infile, strLine))
+	{
+		istringstream iss(strLine);
+		string strId;
+		int version = 0;
+		if (!(iss >> strId >> version) || strId != FILE_ID || version > FILE_VERSION)
+			return false;
+	}
+	else
+	{
+		return false;
+	}
+
+	while (getline(infile, strLine))
+	{
+		istringstream iss(strLine);
+		string strRecord;
+
+		if (!(iss >> strRecord))
+			continue;   // blank line
+		else if (strRecord == "TABLE")
+		{
+			CalTable table;
+			int e1 = 0, e2 = 0, e3 = 0, e4 = 0, e5 = 0;
+
+			if (!(iss >> table.key.input.ch >> e1 >> table.key.input.atten >> e2 >> table.key.output.ch >> e3 >> table.key.output.atten >> e4 >> e5))
+				return false;
+
+			table.key.input.coup = Ctype_t(e1);
+			table.key.input.bwl = (e2 != 0);
+			table.key.output.coup = Ctype_t(e3);
+			table.key.output.bwl = (e4 != 0);
+			table.key.ttMeas = Ttype_t(e5);
+			tables.push_back(table);
+		}
+		else if (strRecord == "CAL" && !tables.empty())
+		{
+			CalPoint cp;
+
+			if (!(iss >> cp.freq >> cp.dBgain >> cp.time))
+				return false;
+
+			tables.back().points.push_back(cp);
+		}
+		else
+		{
+			return false;   // incomplete or unknown record
+		}
+	}
+
+	return true;
+}
+
+
+/*******************************************************************************
+* Class      : ChannelCal
+* Function   : Save()
+* Access     : public
+* Arguments  : filename = calibration file to write (an existing file is replaced)
+* Returns    : true if the file was written
+* Description:
+*   Writes every calibration table held
+*/
+bool ChannelCal::Save(std::string filename) const
+{
+	ofstream file(filename, ios::out | ios::trunc);
+
+	if (!file.is_open())
+		return false;
+
+	file << setprecision(CAL_PRECISION);
+	file << FILE_ID << " " << FILE_VERSION << "\n";
+
+	for (auto const& table : tables)
+	{
+		CalKey const& key = table.key;
+
+		file << "TABLE " << key.input.ch << " " << int(key.input.coup) << " " << key.input.atten << " " << int(key.input.bwl) << " "
+			<< key.output.ch << " " << int(key.output.coup) << " " << key.output.atten << " " << int(key.output.bwl) << " "
+			<< int(key.ttMeas) << "\n";
+
+		for (auto const& cp : table.points)
+			file << "CAL " << cp.freq << " " << cp.dBgain << " " << cp.time << "\n";
+	}
+
+	file.close();
+
+	return !file.fail();
+}
+
+
+/*******************************************************************************
+* Class      : ChannelCal
+* Function   : Store()
+* Access     : public
+* Arguments  : key  = setup the through sweep was measured with
+*              data = points of the through sweep
+* Returns    : none
+* Description:
+*   Makes a through sweep the calibration table of its setup, replacing any
+*   previous table of the same setup. Points that failed to measure are left
+*   out.
+*/
+void ChannelCal::Store(CalKey const& key, FRST const& data)
+{
+	CalTable table;
+	table.key = key;
+
+	for (auto const& point : data)
+	{
+		if (isfinite(point.freq) && point.freq > 0.0 && isfinite(point.dBgain) && isfinite(point.time))
+			table.points.push_back(CalPoint{ point.freq, point.dBgain, point.time });
+	}
+
+	sort(table.points.begin(), table.points.end(), [](CalPoint const& a, CalPoint const& b) { return a.freq < b.freq; });
+
+	tables.erase(remove_if(tables.begin(), tables.end(), [&key](CalTable const& t) { return t.key.Matches(key); }), tables.end());
+	tables.push_back(table);
+}
+
+
+/*******************************************************************************
+* Class      : ChannelCal
+* Function   : Find()
+* Access     : public
+* Arguments  : key = current setup
+* Returns    : the calibration table of the setup, or nullptr if there is none
+* Description:
+*   Looks up the calibration table valid for a setup
+*/
+CalTable const* ChannelCal::Find(CalKey const& key) const
+{
+	for (auto const& table : tables)
+	{
+		if (table.key.Matches(key) && !table.points.empty())
+			return &table;
+	}
+
+	return nullptr;
+}
+
+
+/*******************************************************************************
+* Copyright  2026 Kerry S. Martin, martin@wild-wood.net
+* Free for usage without warranty, expressed or implied; attribution required
+*******************************************************************************/
\ No newline at end of file
@@ -0,0 +1,80 @@
+/*******************************************************************************
+* Copyright  2026 Kerry S. Martin, martin@wild-wood.net
+* Free for usage without warranty, expressed or implied; attribution required
+*
+* Filename   : ChannelCal.h
+* Class      : ChannelCal, CalTable, CalKey
+* Description:
+*   ChannelCal holds the bench calibration: the mismatch between the input and
+*   output channels, measured once by a "through" sweep with both probes on
+*   the same signal, and applied as a correction to every later measurement
+*   with the same setup. The through sweep then only needs to be repeated when
+*   the bench setup changes.
+*
+*   Each CalTable is keyed by the setup it was measured with (CalKey: the
+*   channel, coupling, attenuation and bandwidth limit of both channels, and
+*   the measurement type), so one file holds the tables of every setup used
+*   on a bench. Corrections are interpolated linearly in log frequency between
+*   the calibrated points; outside the calibrated range the nearest end point
+*   is used.
+*
+* Created    : 10/16/2026
+* Modified   : 10/16/2026
+* Author     : Kerry S. Martin, martin@wild-wood.net
+*******************************************************************************/
+#pragma once
+#include "FreqResp.h"
+#include <string>
+#include <vector>
+
+// bench setup a calibration table is valid for
+struct CalKey
+{
+	Channel_Config input;
+	Channel_Config output;
+	Ttype_t ttMeas;
+
+	bool Matches(CalKey const& key) const;
+};
+
+// channel mismatch at one frequency
+struct CalPoint
+{
+	double freq;
+	double dBgain;		// output relative to input
+	double time;		// phase (degrees) or delay (seconds), per the key's ttMeas
+};
+
+
+class CalTable
+{
+public:
+	CalKey key;
+	std::vector<CalPoint> points;	// ascending frequency
+
+	void Correct(FRS& point) const;
+	bool Covers(double fStart, double fStop) const;
+};
+
+
+class ChannelCal
+{
+public:
+	bool Load(std::string filename);
+	bool Save(std::string filename) const;
+
+	void Store(CalKey const& key, FRST const& data);
+	CalTable const* Find(CalKey const& key) const;
+
+private:
+	std::vector<CalTable> tables;
+
+	static const char* const FILE_ID;
+	static const int FILE_VERSION;
+};
+
+
+/*******************************************************************************
+* Copyright  2026 Kerry S. Martin, martin@wild-wood.net
+* Free for usage without warranty, expressed or implied; attribution required
+*******************************************************************************/
\ No newline at end of file
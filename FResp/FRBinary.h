@@ -0,0 +1,298 @@
+/*******************************************************************************
+* Copyright  2026 Kerry S. Martin, martin@wild-wood.net
+* Free for usage without warranty, expressed or implied; attribution required
+*
+* Filename   : FRBinary.h
+* Class      : FRBinaryReader, FRBColumn
+* Description:
+*   Definition of the compact binary columnar frequency response file, and a
+*   header-only reader that memory-maps the file and gives zero-copy views of
+*   its columns. This header does not depend on the instrument classes, so it
+*   can be used stand-alone by post-processing tools.
+*
+*   File layout (little-endian, offsets from the start of the file):
+*     FRB_FileHeader        identification, point count, sweep configuration,
+*                           and a descriptor (id, type, offset) per column
+*     column data           one contiguous array per column, each starting on
+*                           an FRB_ALIGNMENT boundary, npoints elements each
+*
+*   Columns: freq, mag_in, mag_out, dBgain, time, sd_dBgain, sd_time, vstim
+*            (double), tunit (uint8_t), and with harmonic analysis fund, h2,
+*            h3, h4, h5 (V peak), thd, thdn (ratio) (double)
+*
+* Created    : 10/16/2026
+* Modified   : 10/16/2026
+* Author     : Kerry S. Martin, martin@wild-wood.net
+*******************************************************************************/
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <windows.h>
+
+constexpr char FRB_MAGIC[8] = { 'F', 'R', 'E', 'S', 'P', 'B', 'I', 'N' };
+constexpr uint32_t FRB_VERSION = 1;
+constexpr uint32_t FRB_MAX_COLUMNS = 16;
+constexpr uint64_t FRB_ALIGNMENT = 64;
+
+enum class FRB_ColumnId : uint32_t { NONE = 0, FREQ = 1, MAG_IN = 2, MAG_OUT = 3, DBGAIN = 4, TIME = 5, TUNIT = 6, SD_DBGAIN = 7, SD_TIME = 8, VSTIM = 9,
+	FUND = 10, H2 = 11, H3 = 12, H4 = 13, H5 = 14, THD = 15, THDN = 16 };
+enum class FRB_ColumnType : uint32_t { NONE = 0, F64 = 1, U8 = 2 };
+
+// sweep configuration, flattened to fixed-width fields (enumerations as their integer values)
+struct FRB_Config
+{
+	double fStart;
+	double fStop;
+	double vstim;
+	double vdc;
+	double in_atten;
+	double out_atten;
+	double vTrig;
+	double stable_screens;
+	int32_t sweep;
+	int32_t Npoints;
+	int32_t stim_ch;
+	int32_t vtStim;
+	int32_t in_ch;
+	int32_t in_coup;
+	int32_t in_bwl;
+	int32_t out_ch;
+	int32_t out_coup;
+	int32_t out_bwl;
+	int32_t trig_ch;
+	int32_t trig_edge;
+	int32_t trig_coup;
+	int32_t vtMeas;
+	int32_t ttMeas;
+	int32_t minDwell_msec;
+};
+
+struct FRB_Column
+{
+	FRB_ColumnId id;
+	FRB_ColumnType type;
+	uint64_t offset;
+};
+
+struct FRB_FileHeader
+{
+	char magic[8];
+	uint32_t version;
+	uint32_t header_size;
+	uint64_t npoints;
+	uint32_t ncolumns;
+	uint32_t reserved;
+	FRB_Config config;
+	FRB_Column columns[FRB_MAX_COLUMNS];
+};
+
+static_assert(sizeof(FRB_Config) == 128, "FRB_Config layout changed");
+static_assert(sizeof(FRB_FileHeader) == 32 + 128 + 16 * FRB_MAX_COLUMNS, "FRB_FileHeader layout changed");
+
+
+/*******************************************************************************
+* Function   : FRB_ColumnSize()
+* Arguments  : type = column element type
+* Returns    : size of one element in bytes, 0 for an unknown type
+* Description:
+*   Size of one element of the given column type
+*/
+inline size_t FRB_ColumnSize(FRB_ColumnType type)
+{
+	switch (type)
+	{
+	case FRB_ColumnType::F64:	return sizeof(double);
+	case FRB_ColumnType::U8:	return sizeof(uint8_t);
+	default:					return 0;
+	}
+}
+
+
+/*******************************************************************************
+* Class      : FRBColumn
+* Description:
+*   Read-only view of one column: a pointer into the mapped file and a count.
+*   The view is valid only while the FRBinaryReader that produced it is open.
+*/
+template<class T>
+class FRBColumn
+{
+public:
+	FRBColumn() : ptr(nullptr), count(0) {}
+	FRBColumn(T const* ptr, size_t count) : ptr(ptr), count(count) {}
+
+	T const* data() const { return ptr; }
+	size_t size() const { return count; }
+	bool empty() const { return count == 0; }
+	T const* begin() const { return ptr; }
+	T const* end() const { return ptr + count; }
+	T const& operator[](size_t i) const { return ptr[i]; }
+
+private:
+	T const* ptr;
+	size_t count;
+};
+
+
+/*******************************************************************************
+* Class      : FRBinaryReader
+* Description:
+*   Memory-maps a binary frequency response file for reading. The header and
+*   column descriptors are validated on Open(); columns are then returned as
+*   FRBColumn views without copying.
+*/
+class FRBinaryReader
+{
+public:
+	FRBinaryReader() : hFile(INVALID_HANDLE_VALUE), hMapping(NULL), pView(nullptr), nSize(0), header(nullptr) {}
+	~FRBinaryReader() { Close(); }
+	FRBinaryReader(FRBinaryReader const&) = delete;
+	FRBinaryReader& operator = (FRBinaryReader const&) = delete;
+
+	/***************************************************************************
+	* Function   : Open()
+	* Arguments  : szFilename = binary frequency response file
+	* Returns    : true if the file was mapped and its header is valid
+	*/
+	bool Open(char const* szFilename)
+	{
+		Close();
+
+		hFile = CreateFileA(szFilename, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+		if (hFile == INVALID_HANDLE_VALUE)
+			return false;
+
+		LARGE_INTEGER liSize;
+		if (!GetFileSizeEx(hFile, &liSize) || uint64_t(liSize.QuadPart) < sizeof(FRB_FileHeader))
+		{
+			Close();
+			return false;
+		}
+		nSize = size_t(liSize.QuadPart);
+
+		hMapping = CreateFileMappingA(hFile, NULL, PAGE_READONLY, 0, 0, NULL);
+		if (hMapping != NULL)
+			pView = MapViewOfFile(hMapping, FILE_MAP_READ, 0, 0, 0);
+
+		if (pView == nullptr || !Validate(static_cast<FRB_FileHeader const*>(pView)))
+		{
+			Close();
+			return false;
+		}
+
+		header = static_cast<FRB_FileHeader const*>(pView);
+		return true;
+	}
+
+	/***************************************************************************
+	* Function   : Close()
+	* Description: unmaps and closes the file, invalidating all column views
+	*/
+	void Close()
+	{
+		if (pView != nullptr)
+			UnmapViewOfFile(pView);
+		if (hMapping != NULL)
+			CloseHandle(hMapping);
+		if (hFile != INVALID_HANDLE_VALUE)
+			CloseHandle(hFile);
+
+		hFile = INVALID_HANDLE_VALUE;
+		hMapping = NULL;
+		pView = nullptr;
+		nSize = 0;
+		header = nullptr;
+	}
+
+	bool IsOpen() const { return header != nullptr; }
+	size_t Points() const { return header ? size_t(header->npoints) : 0; }
+	FRB_Config const& Config() const { return header->config; }
+
+	FRBColumn<double> Freq() const { return ColumnF64(FRB_ColumnId::FREQ); }
+	FRBColumn<double> MagIn() const { return ColumnF64(FRB_ColumnId::MAG_IN); }
+	FRBColumn<double> MagOut() const { return ColumnF64(FRB_ColumnId::MAG_OUT); }
+	FRBColumn<double> dBGain() const { return ColumnF64(FRB_ColumnId::DBGAIN); }
+	FRBColumn<double> Time() const { return ColumnF64(FRB_ColumnId::TIME); }
+	FRBColumn<double> SdGain() const { return ColumnF64(FRB_ColumnId::SD_DBGAIN); }
+	FRBColumn<double> SdTime() const { return ColumnF64(FRB_ColumnId::SD_TIME); }
+	FRBColumn<double> VStim() const { return ColumnF64(FRB_ColumnId::VSTIM); }
+	FRBColumn<double> Fund() const { return ColumnF64(FRB_ColumnId::FUND); }
+	FRBColumn<double> H2() const { return ColumnF64(FRB_ColumnId::H2); }
+	FRBColumn<double> H3() const { return ColumnF64(FRB_ColumnId::H3); }
+	FRBColumn<double> H4() const { return ColumnF64(FRB_ColumnId::H4); }
+	FRBColumn<double> H5() const { return ColumnF64(FRB_ColumnId::H5); }
+	FRBColumn<double> Thd() const { return ColumnF64(FRB_ColumnId::THD); }
+	FRBColumn<double> Thdn() const { return ColumnF64(FRB_ColumnId::THDN); }
+	FRBColumn<uint8_t> TimeUnit() const { return ColumnU8(FRB_ColumnId::TUNIT); }
+
+	/***************************************************************************
+	* Function   : ColumnF64(), ColumnU8()
+	* Arguments  : id = column identifier
+	* Returns    : view of the column, or an empty view if it is not present
+	*/
+	FRBColumn<double> ColumnF64(FRB_ColumnId id) const
+	{
+		FRB_Column const* pCol = Find(id, FRB_ColumnType::F64);
+		return pCol ? FRBColumn<double>(reinterpret_cast<double const*>(Base() + pCol->offset), Points()) : FRBColumn<double>();
+	}
+
+	FRBColumn<uint8_t> ColumnU8(FRB_ColumnId id) const
+	{
+		FRB_Column const* pCol = Find(id, FRB_ColumnType::U8);
+		return pCol ? FRBColumn<uint8_t>(reinterpret_cast<uint8_t const*>(Base() + pCol->offset), Points()) : FRBColumn<uint8_t>();
+	}
+
+private:
+	HANDLE hFile;
+	HANDLE hMapping;
+	void const* pView;
+	size_t nSize;
+	FRB_FileHeader const* header;
+
+	char const* Base() const { return static_cast<char const*>(pView); }
+
+	FRB_Column const* Find(FRB_ColumnId id, FRB_ColumnType type) const
+	{
+		if (header == nullptr)
+			return nullptr;
+
+		for (uint32_t i = 0; i < header->ncolumns; ++i)
+		{
+			if (header->columns[i].id == id && header->columns[i].type == type)
+				return &header->columns[i];
+		}
+
+		return nullptr;
+	}
+
+	// check the identification, and that every column lies within the file and is aligned
+	bool Validate(FRB_FileHeader const* pHeader) const
+	{
+		if (memcmp(pHeader->magic, FRB_MAGIC, sizeof(FRB_MAGIC)) != 0)
+			return false;
+		if (pHeader->version > FRB_VERSION || pHeader->header_size < sizeof(FRB_FileHeader))
+			return false;
+		if (pHeader->ncolumns > FRB_MAX_COLUMNS)
+			return false;
+
+		for (uint32_t i = 0; i < pHeader->ncolumns; ++i)
+		{
+			FRB_Column const& col = pHeader->columns[i];
+			const size_t nElement = FRB_ColumnSize(col.type);
+
+			if (nElement != 0 && col.offset % nElement != 0)
+				return false;
+			if (col.offset > nSize || pHeader->npoints > (nSize - col.offset) / (nElement ? nElement : 1))
+				return false;
+		}
+
+		return true;
+	}
+};
+
+
+/*******************************************************************************
+* Copyright  2026 Kerry S. Martin, martin@wild-wood.net
+* Free for usage without warranty, expressed or implied; attribution required
+*******************************************************************************/
\ No newline at end of file
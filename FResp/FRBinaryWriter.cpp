@@ -0,0 +1,178 @@
+/*******************************************************************************
+* Copyright  2026 Kerry S. Martin, martin@wild-wood.net
+* Free for usage without warranty, expressed or implied; attribution required
+*
+* Filename   : FRBinaryWriter.cpp
+* Class      : FRBinaryWriter
+* Description:
+*   Writes frequency response results to the binary columnar file format
+*   defined in FRBinary.h.
+*
+* Created    : 10/16/2026
+* Modified   : 10/16/2026
+* Author     : Kerry S. Martin, martin@wild-wood.net
+*******************************************************************************/
+
+#include "FRBinaryWriter.h"
+#include <fstream>
+#include <vector>
+
+using namespace std;
+
+
+/*******************************************************************************
+* Class      : FRBinaryWriter
+* Function   : Align()
+* Access     : private static
+* Arguments  : offset = file offset
+* Returns    : offset rounded up to the next FRB_ALIGNMENT boundary
+* Description:
+*   Rounds a column offset up so that each column starts on a cache line.
+*/
+uint64_t FRBinaryWriter::Align(uint64_t offset)
+{
+	return (offset + FRB_ALIGNMENT - 1) / FRB_ALIGNMENT * FRB_ALIGNMENT;
+}
+
+
+/*******************************************************************************
+* Class      : FRBinaryWriter
+* Function   : MakeConfig()
+* Access     : public static
+* Arguments  : freq, stim, input, output, trig, meas, dwell = sweep configuration
+* Returns    : the configuration in the fixed-width file representation
+* Description:
+*   Flattens the sweep configuration for the file header.
+*/
+FRB_Config FRBinaryWriter::MakeConfig(Freq_Config const& freq, Stim_Config const& stim, Channel_Config const& input, Channel_Config const& output, Trig_Config const& trig, Meas_Config const& meas, Dwell_Config const& dwell)
+{
+	FRB_Config config;
+
+	memset(&config, 0, sizeof(config));
+
+	config.fStart = freq.fStart;
+	config.fStop = freq.fStop;
+	config.sweep = int32_t(freq.sweep);
+	config.Npoints = int32_t(freq.Npoints);
+	config.stim_ch = int32_t(stim.ch);
+	config.vtStim = int32_t(stim.vtStim);
+	config.vstim = stim.vstim;
+	config.vdc = stim.vdc;
+	config.in_ch = int32_t(input.ch);
+	config.in_coup = int32_t(input.coup);
+	config.in_atten = input.atten;
+	config.in_bwl = input.bwl ? 1 : 0;
+	config.out_ch = int32_t(output.ch);
+	config.out_coup = int32_t(output.coup);
+	config.out_atten = output.atten;
+	config.out_bwl = output.bwl ? 1 : 0;
+	config.trig_ch = int32_t(trig.ch);
+	config.trig_edge = int32_t(trig.edge);
+	config.trig_coup = int32_t(trig.coup);
+	config.vTrig = trig.vTrig;
+	config.vtMeas = int32_t(meas.vtMeas);
+	config.ttMeas = int32_t(meas.ttMeas);
+	config.stable_screens = dwell.stable_screens;
+	config.minDwell_msec = int32_t(dwell.minDwell_msec);
+
+	return config;
+}
+
+
+/*******************************************************************************
+* Class      : FRBinaryWriter
+* Function   : Write()
+* Access     : public static
+* Arguments  : filename = binary file to write (an existing file is replaced)
+*              data     = frequency response results
+*              freq, stim, input, output, trig, meas, dwell = sweep configuration
+* Returns    : true if the file was written successfully
+* Description:
+*   Writes the header followed by the freq, mag_in, mag_out, dBgain, time,
+*   sd_dBgain, sd_time, vstim, and tunit columns. A sweep with harmonic
+*   analysis also has the fund, h2 to h5, thd and thdn columns.
+*/
+bool FRBinaryWriter::Write(std::string filename, FRST const& data, Freq_Config const& freq, Stim_Config const& stim, Channel_Config const& input, Channel_Config const& output, Trig_Config const& trig, Meas_Config const& meas, Dwell_Config const& dwell)
+{
+	const size_t npoints = data.size();
+	FRB_FileHeader header;
+
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, FRB_MAGIC, sizeof(FRB_MAGIC));
+	header.version = FRB_VERSION;
+	header.header_size = sizeof(FRB_FileHeader);
+	header.npoints = npoints;
+	header.config = MakeConfig(freq, stim, input, output, trig, meas, dwell);
+
+	// the double columns, in file order
+	struct { FRB_ColumnId id; double FRS::* member; } const f64_columns[] =
+	{
+		{ FRB_ColumnId::FREQ,	&FRS::freq },
+		{ FRB_ColumnId::MAG_IN,	&FRS::mag_in },
+		{ FRB_ColumnId::MAG_OUT,&FRS::mag_out },
+		{ FRB_ColumnId::DBGAIN,	&FRS::dBgain },
+		{ FRB_ColumnId::TIME,	&FRS::time },
+		{ FRB_ColumnId::SD_DBGAIN,	&FRS::sd_dBgain },
+		{ FRB_ColumnId::SD_TIME,	&FRS::sd_time },
+		{ FRB_ColumnId::VSTIM,	&FRS::vstim },
+		{ FRB_ColumnId::FUND,	&FRS::fund },	// harmonic analysis columns last
+		{ FRB_ColumnId::H2,		&FRS::h2 },
+		{ FRB_ColumnId::H3,		&FRS::h3 },
+		{ FRB_ColumnId::H4,		&FRS::h4 },
+		{ FRB_ColumnId::H5,		&FRS::h5 },
+		{ FRB_ColumnId::THD,	&FRS::thd },
+		{ FRB_ColumnId::THDN,	&FRS::thdn }
+	};
+	constexpr size_t nHarmonicColumns = 7;
+	constexpr size_t nF64Max = sizeof(f64_columns) / sizeof(f64_columns[0]);
+	static_assert(nF64Max + 1 <= FRB_MAX_COLUMNS, "too many columns for the file header");
+	const size_t nF64 = meas.is_harmonics ? nF64Max : nF64Max - nHarmonicColumns;
+
+	// lay out the columns
+	uint64_t offset = Align(sizeof(FRB_FileHeader));
+	for (size_t i = 0; i < nF64; ++i)
+	{
+		header.columns[header.ncolumns++] = { f64_columns[i].id, FRB_ColumnType::F64, offset };
+		offset = Align(offset + npoints * sizeof(double));
+	}
+	header.columns[header.ncolumns++] = { FRB_ColumnId::TUNIT, FRB_ColumnType::U8, offset };
+
+	ofstream file(filename, ios::out | ios::trunc | ios::binary);
+	if (!file.is_open())
+		return false;
+
+	const char padding[FRB_ALIGNMENT] = {};
+	uint64_t position = 0;
+
+	// write the header, then each column preceded by padding up to its offset
+	file.write(reinterpret_cast<char const*>(&header), sizeof(header));
+	position = sizeof(header);
+
+	vector<double> f64(npoints);
+	for (uint32_t i = 0; i + 1 < header.ncolumns; ++i)
+	{
+		for (size_t n = 0; n < npoints; ++n)
+			f64[n] = data[n].*(f64_columns[i].member);
+
+		file.write(padding, streamsize(header.columns[i].offset - position));
+		file.write(reinterpret_cast<char const*>(f64.data()), streamsize(npoints * sizeof(double)));
+		position = header.columns[i].offset + npoints * sizeof(double);
+	}
+
+	vector<uint8_t> u8(npoints);
+	for (size_t n = 0; n < npoints; ++n)
+		u8[n] = uint8_t(data[n].tunit);
+
+	file.write(padding, streamsize(header.columns[header.ncolumns - 1].offset - position));
+	file.write(reinterpret_cast<char const*>(u8.data()), streamsize(npoints));
+
+	file.close();
+
+	return !file.fail();
+}
+
+
+/*******************************************************************************
+* Copyright  2026 Kerry S. Martin, martin@wild-wood.net
+* Free for usage without warranty, expressed or implied; attribution required
+*******************************************************************************/
\ No newline at end of file
@@ -0,0 +1,35 @@
+/*******************************************************************************
+* Copyright  2026 Kerry S. Martin, martin@wild-wood.net
+* Free for usage without warranty, expressed or implied; attribution required
+*
+* Filename   : FRBinaryWriter.h
+* Class      : FRBinaryWriter
+* Description:
+*   Writes frequency response results to the binary columnar file format
+*   defined in FRBinary.h. Values are stored exactly as measured (no text
+*   conversion), one contiguous column per FRS member.
+*
+* Created    : 10/16/2026
+* Modified   : 10/16/2026
+* Author     : Kerry S. Martin, martin@wild-wood.net
+*******************************************************************************/
+#pragma once
+#include "FreqResp.h"
+#include "FRBinary.h"
+#include <string>
+
+class FRBinaryWriter
+{
+public:
+	static bool Write(std::string filename, FRST const& data, Freq_Config const& freq, Stim_Config const& stim, Channel_Config const& input, Channel_Config const& output, Trig_Config const& trig, Meas_Config const& meas, Dwell_Config const& dwell);
+	static FRB_Config MakeConfig(Freq_Config const& freq, Stim_Config const& stim, Channel_Config const& input, Channel_Config const& output, Trig_Config const& trig, Meas_Config const& meas, Dwell_Config const& dwell);
+
+private:
+	static uint64_t Align(uint64_t offset);
+};
+
+
+/*******************************************************************************
+* Copyright  2026 Kerry S. Martin, martin@wild-wood.net
+* Free for usage without warranty, expressed or implied; attribution required
+*******************************************************************************/
\ No newline at end of file
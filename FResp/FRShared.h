@@ -0,0 +1,263 @@
+/*******************************************************************************
+* Copyright  2026 Kerry S. Martin, martin@wild-wood.net
+* Free for usage without warranty, expressed or implied; attribution required
+*
+* Filename   : FRShared.h
+* Class      : FRSharedReader
+* Description:
+*   Definition of the shared memory ring FResp publishes its results to while
+*   a sweep runs, and a header-only reader for the processes that watch it
+*   (live plots, analysis). This header does not depend on the instrument
+*   classes, so it can be used stand-alone, like FRBinary.h.
+*
+*   The ring is a named file mapping (FRM_MappingName()). One FResp process
+*   writes it; any number of readers map it read-only and never block the
+*   writer, so a slow or stalled viewer cannot delay a sweep.
+*
+*   Memory layout:
+*     FRM_Header            identification, the current sweep (number, first
+*                           point, state, configuration) under a seqlock, and
+*                           the count of points published
+*     FRM_Slot[ring_points] one point per slot, each under its own seqlock;
+*                           point n is in slot n % ring_points
+*
+*   Point numbers increase across sweeps. A seqlock counter is odd while its
+*   data is being written; point n is complete in its slot when the counter
+*   is 2n+2. A reader copies the data, then checks that the counter did not
+*   change, so it never sees a partly written point. A reader that falls
+*   more than ring_points behind has lost the points overwritten since.
+*
+* Created    : 10/16/2026
+* Modified   : 10/16/2026
+* Author     : Kerry S. Martin, martin@wild-wood.net
+*******************************************************************************/
+#pragma once
+#include "FRBinary.h"
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+constexpr char FRM_MAGIC[8] = { 'F', 'R', 'E', 'S', 'P', 'S', 'H', 'M' };
+constexpr uint32_t FRM_VERSION = 1;
+constexpr uint32_t FRM_RING_POINTS = 4096;
+constexpr char FRM_NAME_PREFIX[] = "Local\\FResp_";
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "the seqlock counters must be lock-free to be shared between processes");
+
+enum class FRM_State : uint32_t { IDLE = 0, RUNNING = 1, DONE = 2 };
+enum class FRM_Read { OK, PENDING, OVERRUN };
+
+// one point, flattened to fixed-width fields (see FRS)
+struct FRM_Point
+{
+	double freq;
+	double mag_in;
+	double mag_out;
+	double dBgain;
+	double time;
+	double sd_dBgain;
+	double sd_time;
+	double vstim;
+	double fund;
+	double h2;
+	double h3;
+	double h4;
+	double h5;
+	double thd;
+	double thdn;
+	uint32_t count;
+	uint8_t tunit;
+	uint8_t is_harmonics;
+	uint8_t reserved[2];
+};
+
+// the sweep being published
+struct FRM_Sweep
+{
+	uint64_t sweep;			// sweeps started since the ring was created (0 = none yet)
+	uint64_t first;			// number of the first point of the sweep
+	FRM_State state;
+	uint32_t reserved;
+	FRB_Config config;
+};
+
+struct alignas(64) FRM_Slot
+{
+	std::atomic<uint64_t> seq;
+	uint64_t reserved;
+	FRM_Point point;
+};
+
+struct alignas(64) FRM_Header
+{
+	char magic[8];
+	uint32_t version;
+	uint32_t header_size;
+	uint32_t ring_points;
+	uint32_t slot_size;
+	std::atomic<uint64_t> sweep_seq;
+	FRM_Sweep sweep;
+	alignas(64) std::atomic<uint64_t> head;	// points published, all sweeps
+};
+
+static_assert(sizeof(FRM_Point) == 128, "FRM_Point layout changed");
+static_assert(sizeof(FRM_Slot) == 192, "FRM_Slot layout changed");
+static_assert(sizeof(FRM_Sweep) == 24 + sizeof(FRB_Config), "FRM_Sweep layout changed");
+
+
+/*******************************************************************************
+* Function   : FRM_MappingName(), FRM_MappingSize()
+* Arguments  : szName = name of the ring, as given to FResp (shm:name)
+* Description:
+*   Name of the file mapping of a ring, and the size of the mapping
+*/
+inline std::string FRM_MappingName(char const* szName)
+{
+	return std::string(FRM_NAME_PREFIX) + szName;
+}
+
+inline size_t FRM_MappingSize()
+{
+	return sizeof(FRM_Header) + size_t(FRM_RING_POINTS) * sizeof(FRM_Slot);
+}
+
+
+/*******************************************************************************
+* Class      : FRSharedReader
+* Description:
+*   Maps the ring of a running FResp read-only. Head() tells how many points
+*   have been published; ReadSweep() and Read() copy the sweep and a point
+*   out of the ring once they are complete. Nothing is written to the ring,
+*   so any number of readers can watch it.
+*/
+class FRSharedReader
+{
+public:
+	FRSharedReader() : hMapping(NULL), pView(nullptr), header(nullptr), slots(nullptr) {}
+	~FRSharedReader() { Close(); }
+	FRSharedReader(FRSharedReader const&) = delete;
+	FRSharedReader& operator = (FRSharedReader const&) = delete;
+
+	/***************************************************************************
+	* Function   : Open()
+	* Arguments  : szName = name of the ring, as given to FResp (shm:name)
+	* Returns    : true if the ring exists and its header is valid
+	*/
+	bool Open(char const* szName)
+	{
+		Close();
+
+		hMapping = OpenFileMappingA(FILE_MAP_READ, FALSE, FRM_MappingName(szName).c_str());
+		if (hMapping != NULL)
+			pView = MapViewOfFile(hMapping, FILE_MAP_READ, 0, 0, 0);
+
+		if (pView == nullptr || !Validate(static_cast<FRM_Header const*>(pView)))
+		{
+			Close();
+			return false;
+		}
+
+		header = static_cast<FRM_Header const*>(pView);
+		slots = reinterpret_cast<FRM_Slot const*>(static_cast<char const*>(pView) + header->header_size);
+		return true;
+	}
+
+	/***************************************************************************
+	* Function   : Close()
+	* Description: unmaps the ring
+	*/
+	void Close()
+	{
+		if (pView != nullptr)
+			UnmapViewOfFile(pView);
+		if (hMapping != NULL)
+			CloseHandle(hMapping);
+
+		hMapping = NULL;
+		pView = nullptr;
+		header = nullptr;
+		slots = nullptr;
+	}
+
+	bool IsOpen() const { return header != nullptr; }
+	uint64_t Head() const { return header ? header->head.load(std::memory_order_acquire) : 0; }
+
+	/***************************************************************************
+	* Function   : ReadSweep()
+	* Arguments  : sweep = receives the sweep being published
+	* Returns    : true if a consistent copy was read (false if the sweep
+	*              kept changing, try again)
+	*/
+	bool ReadSweep(FRM_Sweep& sweep) const
+	{
+		for (int attempt = 0; header != nullptr && attempt < 100; ++attempt)
+		{
+			const uint64_t seq = header->sweep_seq.load(std::memory_order_acquire);
+			if (seq & 1)
+				continue;
+
+			memcpy(&sweep, &header->sweep, sizeof(sweep));
+			std::atomic_thread_fence(std::memory_order_acquire);
+
+			if (header->sweep_seq.load(std::memory_order_relaxed) == seq)
+				return true;
+		}
+
+		return false;
+	}
+
+	/***************************************************************************
+	* Function   : Read()
+	* Arguments  : n     = number of the point
+	*              point = receives the point
+	* Returns    : OK, PENDING if the point is not published yet, or OVERRUN if
+	*              it has already been overwritten
+	*/
+	FRM_Read Read(uint64_t n, FRM_Point& point) const
+	{
+		const uint64_t head = Head();
+
+		if (n >= head)
+			return FRM_Read::PENDING;
+		if (head - n > header->ring_points)
+			return FRM_Read::OVERRUN;
+
+		FRM_Slot const& slot = slots[n % header->ring_points];
+		const uint64_t seq = slot.seq.load(std::memory_order_acquire);
+		if (seq != 2 * n + 2)
+			return (seq < 2 * n + 2) ? FRM_Read::PENDING : FRM_Read::OVERRUN;
+
+		memcpy(&point, &slot.point, sizeof(point));
+		std::atomic_thread_fence(std::memory_order_acquire);
+
+		return (slot.seq.load(std::memory_order_relaxed) == seq) ? FRM_Read::OK : FRM_Read::OVERRUN;
+	}
+
+private:
+	HANDLE hMapping;
+	void const* pView;
+	FRM_Header const* header;
+	FRM_Slot const* slots;
+
+	// check the identification, and that the ring lies within the mapping
+	bool Validate(FRM_Header const* pHeader) const
+	{
+		MEMORY_BASIC_INFORMATION mbi;
+
+		if (VirtualQuery(pHeader, &mbi, sizeof(mbi)) == 0 || mbi.RegionSize < sizeof(FRM_Header))
+			return false;
+		if (memcmp(pHeader->magic, FRM_MAGIC, sizeof(FRM_MAGIC)) != 0)
+			return false;
+		if (pHeader->version > FRM_VERSION || pHeader->header_size < sizeof(FRM_Header) || pHeader->slot_size != sizeof(FRM_Slot) || pHeader->ring_points == 0)
+			return false;
+
+		return mbi.RegionSize >= pHeader->header_size + uint64_t(pHeader->ring_points) * pHeader->slot_size;
+	}
+};
+
+
+/*******************************************************************************
+* Copyright  2026 Kerry S. Martin, martin@wild-wood.net
+* Free for usage without warranty, expressed or implied; attribution required
+*******************************************************************************/
\ No newline at end of file
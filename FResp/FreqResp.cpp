@@ -9,16 +9,28 @@
 *   as a full sweep, or as a series of calls or each frequency step.
 *
 *   Implements a measurement of frequency response using a Rigol function
-*   generator and a Siglent oscilloscope.
+*   generator and a Siglent oscilloscope, through the drivers chosen for the
+*   attached models (see ScopeDriver and GeneratorDriver).
 *
 * Created    : 05/26/2020
-* Modified   : 01/01/2023
+* Modified   : 10/16/2026
 * Author     : Kerry S. Martin, martin@wild-wood.net
 *******************************************************************************/
 #include "FreqResp.h"
+#include "AutoScale.h"
+#include "ChannelCal.h"
+#include "HarmonicAnalysis.h"
+#include "LimitMask.h"
+#include "SweepCheckpoint.h"
+#include "SweepPlan.h"
+#include "TransferFit.h"
+#include <algorithm>
+#include <fstream>
 #include <string>
 #include <regex>
 #include <cmath>
+#include <future>
+#include <limits>
 #include <WinSock2.h>
 #include <windows.h>
 
@@ -27,13 +39,68 @@
 using namespace std;
 
 
-// auto-voltage-scale limits, as % of full-scale peak-to-peak voltage
-const double FreqResp::SEEK_MAX{ 1.000 };
-const double FreqResp::SEEK_MID{ 0.390 };
-const double FreqResp::SEEK_MIN{ 0.200 };
-const double FreqResp::SEEK_MARGIN{ 0.0275 };
-const double FreqResp::FREQ_FUDGE{ 1.001 };
-const double FreqResp::MEAS_CYCLES{ 4.0 };
+// most vertical range changes of a channel at one point (an unclipped signal
+// settles in one; a clipped one moves up AutoScale::CLIP_JUMP at a time)
+const int FreqResp::SCALE_ADJUST_MAX{ 6 };
+
+// number of times a point is re-measured after recovering a lost connection
+const int FreqResp::RECOVER_ATTEMPTS{ 2 };
+
+// averaging: fewest readings that give a usable spread, and the least time between readings
+const unsigned int FreqResp::AVG_MIN_READINGS{ 3 };
+const unsigned long FreqResp::AVG_MIN_INTERVAL_MSEC{ 50 };
+
+// adaptive capture length: noise, as the excess of peak-to-peak over amplitude,
+// below which the capture is shortened and above which it is lengthened
+const double FreqResp::NOISE_LOW{ 0.03 };
+const double FreqResp::NOISE_HIGH{ 0.10 };
+
+// hardware sweep: spare time in each step, and extra time allowed for the sequence to complete
+const double FreqResp::HW_MARGIN_SEC{ 0.05 };
+const double FreqResp::HW_TIMEOUT_SEC{ 5.0 };
+
+// search: coarse grid density, and the golden-section ratio ((sqrt(5)-1)/2)
+const double FreqResp::SEARCH_POINTS_PER_DECADE{ 3.0 };
+const double FreqResp::SEARCH_GOLDEN{ 0.6180339887498949 };
+
+// stimulus leveling: the output is held within this ratio of its target, the
+// generator's smallest amplitude, and the most amplitude changes at one point
+const double FreqResp::LEVEL_WINDOW{ 2.0 };
+const double FreqResp::LEVEL_MIN_VPP{ 0.002 };
+const int FreqResp::LEVEL_ADJUST_MAX{ 2 };
+
+// harmonic analysis: most points of the output waveform read back at each point
+const unsigned int FreqResp::HARMONIC_POINTS_MAX{ 20000 };
+
+
+/*******************************************************************************
+* Class      : RunningStats
+* Description:
+*   Running mean and standard deviation of a series of readings, updated one
+*   reading at a time (Welford's method) so no readings are kept.
+*/
+class RunningStats
+{
+public:
+	RunningStats() : n(0), mean(0.0), m2(0.0) {}
+
+	void Add(double x)
+	{
+		++n;
+		const double delta = x - mean;
+		mean += delta / n;
+		m2 += delta * (x - mean);
+	}
+
+	unsigned int Count() const { return n; }
+	double Mean() const { return mean; }
+	double StdDev() const { return (n > 1) ? sqrt(m2 / (n - 1)) : 0.0; }
+
+private:
+	unsigned int n;
+	double mean;
+	double m2;
+};
 
 
 /*******************************************************************************
@@ -47,7 +114,8 @@ const double FreqResp::MEAS_CYCLES{ 4.0 };
 *   setup is done with a subsequent call to Init().
 */
 FreqResp::FreqResp() :
-	stimulus(), oscope()
+	checkpoint(new SweepCheckpoint()), plan(new SweepPlan()), calTable(nullptr), maskFailures(0), stimulus(), oscope(),
+	autoOutput(new AutoScale()), autoInput(new AutoScale())
 {
 	data = FRST();
 	initialized = false;
@@ -97,11 +165,22 @@ FreqResp::~FreqResp()
 FRRET FreqResp::Close()
 {
 	// detach from the instruments - these will do nothing if they had failed to attach
-	oscope.Detach();
-	stimulus.Detach();
+	if (oscope)
+		oscope->Detach();
+	if (stimulus)
+		stimulus->Detach();
+	oscope.reset();
+	stimulus.reset();
 
 	// reset the data set to empty
 	data = FRST();
+	checkpoint->Close();
+	plan->Clear();
+	cal.reset();
+	calTable = nullptr;
+	mask.reset();
+	order.clear();
+	fit.reset();
 
 	// clear these flags to prevent starting a sweep (without initializing first) or grabbing data
 	initialized = false;
@@ -125,6 +204,8 @@ FRRET FreqResp::Close()
 * Returns    : FRRET result (see documentation for FRRET above)
 * Description:
 *   Initializes the instruments and prepares for subsequent measurements.
+*   The instruments are attached concurrently, so the time taken is that of
+*   the slowest instrument rather than the sum of both.
 */
 FRRET FreqResp::Init(char const* szOscope, char const* szSigGen, Freq_Config const& _freq, Stim_Config const& _stim, Channel_Config const& _input, Channel_Config const& _output, Trig_Config const& _trig, Meas_Config const& _meas, Dwell_Config const& _dwell)
 {
@@ -148,20 +229,7 @@ FRRET FreqResp::Init(char const* szOscope, char const* szSigGen, Freq_Config con
 	// sanity checking
 	// ---------------
 
-	if (isnan(freq.fStart) || isnan(freq.fStop))
-		nReturnVal = FRRET_INVALID_FREQUENCY;
-	if (freq.fStart <= 0.0)
-		nReturnVal = FRRET_INVALID_FREQUENCY;
-	if (freq.fStop <= freq.fStart)
-		nReturnVal = FRRET_INVALID_FREQUENCY;
-
-	if (isnan(stim.vdc) || isnan(stim.vstim))
-		nReturnVal = FRRET_INVALID_STIM;
-	if (stim.vstim <= 0.0)
-		nReturnVal = FRRET_INVALID_STIM;
-
-	if (isnan(trig.vTrig))
-		nReturnVal = FRRET_INVALID_TRIG;
+	nReturnVal = Validate(freq, stim, trig);
 
 	if (nReturnVal < FRRET_SUCCESS)
 		return nReturnVal;
@@ -170,43 +238,28 @@ FRRET FreqResp::Init(char const* szOscope, char const* szSigGen, Freq_Config con
 	// default value initialization
 	// ----------------------------
 
-	measEdge = Oscilloscope::MeasDelParam::FRR;   // only used if measurement is set to delay (not for phase)
+	measEdge = ScopeDriver::MeasDelParam::FRR;   // only used if measurement is set to delay (not for phase)
 	avMeasure = 1.0;
 
+	// --------------------------------------------
+	// attach to both instruments at the same time
+	// --------------------------------------------
+	const string strSigGen = szSigGen;
+	// each is identified, and driven by the driver of its model
+	auto futSigGen = async(launch::async, [this, &strSigGen]() { stimulus = GeneratorDriver::Open(strSigGen); return stimulus != nullptr; });
+	oscope = ScopeDriver::Open(szOscope);
+	const bool bOscope = (oscope != nullptr);
+	const bool bSigGen = futSigGen.get();
+
 	// -----------------------
 	// stimulus initialization
 	// -----------------------
 
-	switch (stim.ch)
-	{
-	case 1: default:
-		sgChannel = SineGenerator::Channel::CH1;
-		break;
-	case 2:
-		sgChannel = SineGenerator::Channel::CH2;
-		break;
-	}
-
-	switch (stim.vtStim)
-	{
-	case Vtype_t::VPK:
-		vStim = 2.0 * abs(stim.vstim);  // express in Vpp = 2.0*Vpk
-		break;
-	case Vtype_t::VPP: default:
-		vStim = abs(stim.vstim);
-		break;
-	}
-
-	// attach to and configure the sine wave generator
-	if (stimulus.Attach(szSigGen))
-	{
-		stimulus.SetChannel(sgChannel, freq.fStart, vStim, stim.vdc, 0.0);
-		stimulus.SetChannelOutput(sgChannel, true);
-	}
+	// configure the sine wave generator
+	if (bSigGen)
+		ConfigureStimulus(freq.fStart);
 	else
-	{
 		nReturnVal = FRRET_INIT_SINEGEN;
-	}
 
 	if (nReturnVal < FRRET_SUCCESS)
 		return nReturnVal;
@@ -214,171 +267,45 @@ FRRET FreqResp::Init(char const* szOscope, char const* szSigGen, Freq_Config con
 	// ---------------------------
 	// oscilloscope initialization
 	// ---------------------------
-	if (oscope.Attach(szOscope))
-	{
-		// initialize oscilloscope measurement
-		switch (input.ch)
-		{
-		case 1: default:
-			osChannelInput = Oscilloscope::Channel::CH1;
-			break;
-		case 2:
-			osChannelInput = Oscilloscope::Channel::CH2;
-			break;
-		case 3:
-			osChannelInput = Oscilloscope::Channel::CH3;
-			break;
-		case 4:
-			osChannelInput = Oscilloscope::Channel::CH4;
-			break;
-		}
-
-		switch (output.ch)
-		{
-		case 1:
-			osChannelOutput = Oscilloscope::Channel::CH1;
-			break;
-		case 2: default:
-			osChannelOutput = Oscilloscope::Channel::CH2;
-			break;
-		case 3:
-			osChannelOutput = Oscilloscope::Channel::CH3;
-			break;
-		case 4:
-			osChannelOutput = Oscilloscope::Channel::CH4;
-			break;
-		}
-
-		switch (trig.ch)
-		{
-		case 1:
-			osChannelTrig = Oscilloscope::Channel::CH1;
-			break;
-		case 2: default:
-			osChannelTrig = Oscilloscope::Channel::CH2;
-			break;
-		case 3:
-			osChannelTrig = Oscilloscope::Channel::CH3;
-			break;
-		case 4:
-			osChannelTrig = Oscilloscope::Channel::CH4;
-			break;
-		}
-
-		oscope.SetChannelEnable(osChannelInput, true);
-		if (input.bwl)
-			oscope.SetChannelBWL(osChannelInput, Oscilloscope::BWLimit::BWL_ON);
-		else
-			oscope.SetChannelBWL(osChannelInput, Oscilloscope::BWLimit::BWL_FULL);
-		if (input.atten == 10.0)
-			oscope.SetChannelAtten(osChannelInput, Oscilloscope::ChAtten::AT_10X);
-		else
-			oscope.SetChannelAtten(osChannelInput, Oscilloscope::ChAtten::AT_1X);
-		oscope.SetChannelVoltsEx(osChannelInput, 1.0, 0.0);
-		oscope.SetChannelEnable(osChannelOutput, true);
-		if (output.bwl)
-			oscope.SetChannelBWL(osChannelOutput, Oscilloscope::BWLimit::BWL_ON);
-		else
-			oscope.SetChannelBWL(osChannelOutput, Oscilloscope::BWLimit::BWL_FULL);
-		if (output.atten == 10.0)
-			oscope.SetChannelAtten(osChannelOutput, Oscilloscope::ChAtten::AT_10X);
-		else
-			oscope.SetChannelAtten(osChannelOutput, Oscilloscope::ChAtten::AT_1X);
-
-		oscope.SetChannelVoltsEx(osChannelOutput, 1.0, 0.0);
-		switch (input.coup)
-		{
-		case Ctype_t::AC: default:
-			oscope.SetChannelCoupling(osChannelInput, Oscilloscope::Coupling::AC);
-			break;
-		case Ctype_t::DC:
-			oscope.SetChannelCoupling(osChannelInput, Oscilloscope::Coupling::DC);
-			break;
-		}
-		switch (output.coup)
-		{
-		case Ctype_t::AC: default:
-			oscope.SetChannelCoupling(osChannelOutput, Oscilloscope::Coupling::AC);
-			break;
-		case Ctype_t::DC:
-			oscope.SetChannelCoupling(osChannelOutput, Oscilloscope::Coupling::DC);
-			break;
-		}
-
-		Oscilloscope::EdgeType trigEdge;
-		switch (trig.edge)
-		{
-		case Etype_t::RISE: default:
-			trigEdge = Oscilloscope::EdgeType::RISING;
-			measEdge = Oscilloscope::MeasDelParam::FRR;
-			break;
-		case Etype_t::FALL:
-			trigEdge = Oscilloscope::EdgeType::FALLING;
-			measEdge = Oscilloscope::MeasDelParam::FFF;
-			break;
-		}
-
-		Oscilloscope::Coupling trigCoup;
-		switch (trig.coup)
-		{
-		case Ctype_t::AC: default:
-			trigCoup = Oscilloscope::Coupling::AC;
-			break;
-		case Ctype_t::DC:
-			trigCoup = Oscilloscope::Coupling::DC;
-			break;
-
-		}
-		oscope.SetTriggerMode(Oscilloscope::TriggerMode::AUTO);
-		oscope.SetEdgeTrigger(osChannelTrig, trigEdge, trig.vTrig, trigCoup, false);
-
-		// both VPP and VPK use AMPL, which is essentially peak-to-peak with some noise reduction
-		// but VPK returns 0.5 x AMPL whereas VPP returns 1.0 x AMPL
-		mpMeasure = Oscilloscope::MeasParam::AMPL;
-
-		switch (meas.vtMeas)
-		{
-		case Vtype_t::VPK: default:
-			avMeasure = 0.5;
-			break;
-		case Vtype_t::VPP:
-			avMeasure = 1.0;
-			break;
-		}
-	}
+	if (bOscope)
+		ConfigureOscilloscope();
 	else
-	{
 		nReturnVal = FRRET_INIT_OSCILLOSCOPE;
-	}
 
 	if (nReturnVal < FRRET_SUCCESS)
 		return nReturnVal;
 
+	// ----------------------------------------------------------
+	// sweep plan (frequencies, timebases, dwell, and commands)
+	// (needs both instruments attached)
+	// ----------------------------------------------------------
+	if (!plan->Build(freq, dwell, *oscope, *stimulus, sgChannel))
+		return FRRET_INVALID_FREQUENCY;
+
 	// ----------------------
 	// initialization wrap-up
 	// ----------------------
 
 	initialized = true;
 
-	// set the phase/delay type
-	if (meas.ttMeas == Ttype_t::DELAY)
-		tunit = TUNIT::DELAY;
-	else
-		tunit = TUNIT::PHASE;
-
 	// get initial scale settings (call with adjust == 0)
-	oscope.AdjustChannelVolts(osChannelOutput, 0, osScaleOutput);
-	oscope.AdjustChannelVolts(osChannelInput, 0, osScaleInput);
+	oscope->AdjustChannelVolts(osChannelOutput, 0, osScaleOutput);
+	oscope->AdjustChannelVolts(osChannelInput, 0, osScaleInput);
+	autoOutput->Reset();
+	autoInput->Reset();
 
-	// set the initial sweep frequency
-	f = freq.fStart;
+	// start at the first step of the plan, with the default capture length
+	iStep = 0;
+	iCapture = SweepPlan::CAPTURE_DEFAULT;
+	maskFailures = 0;
+	order.clear();
 
 	// perform and discard one measurement at the initial frequency
 	// (the initial measurement is often incorrect)
 	// TODO: this is just a temporary work-around until the root-cause
 	// can be fixed
 	FRS unused;
-	MeasureFreq(f, unused);
+	MeasureFreq((*plan)[iStep], unused);
 
 	return nReturnVal;
 }
@@ -386,97 +313,123 @@ FRRET FreqResp::Init(char const* szOscope, char const* szSigGen, Freq_Config con
 
 /*******************************************************************************
 * Class      : FreqResp
-* Function   : Sweep()
+* Function   : Reconfigure()
 * Access     : public
-* Arguments  : none
+* Arguments  : _freq   = config of frequency sweep
+*              _stim   = config of stimulus generator
+*              _input  = config of oscope channel connected to DUT input
+*              _output = config of oscope channel connected to DUT output
+*              _trig   = config of oscope triggering
+*              _meas   = config of oscope measurement
+*              _dwell  = config of algorithm dwell time at each frequency
 * Returns    : FRRET result (see documentation for FRRET above)
 * Description:
-*   Performs the entire frequency response sweep. The results can be obtained
-*   afterward by a call to the FRST conversion operator.
+*   Prepares another response measurement on the instruments attached by
+*   Init(), without detaching or repeating the default instrument setup.
+*   Only the parts of the configuration that differ from the previous
+*   measurement are sent to the instruments. The results of the previous
+*   measurement are discarded and any checkpoint file is closed. The settling
+*   measurement of Init() is repeated only when the stimulus or a measured
+*   channel has changed.
 */
-FRRET FreqResp::Sweep()
+FRRET FreqResp::Reconfigure(Freq_Config const& _freq, Stim_Config const& _stim, Channel_Config const& _input, Channel_Config const& _output, Trig_Config const& _trig, Meas_Config const& _meas, Dwell_Config const& _dwell)
 {
 	if (!initialized)
 		return FRRET_NOT_INITIALIZED;
 
-	FRRET nReturnVal = FRRET_SUCCESS;
-
-	// restart from the first frequency
-	completed = false;
-	f = freq.fStart;
-
-	while (!completed)
-	{
-		FRS unused;
-		nReturnVal = MeasureNext(unused);
+	FRRET nReturnVal = Validate(_freq, _stim, _trig);
 
-		if (nReturnVal < FRRET_SUCCESS)
-			break;
-	}
+	if (nReturnVal < FRRET_SUCCESS)
+		return nReturnVal;
 
-	return nReturnVal;
-}
+	const ScopeDriver::Channel chInput = GetOscChannel(_input.ch, ScopeDriver::Channel::CH1);
+	const ScopeDriver::Channel chOutput = GetOscChannel(_output.ch, ScopeDriver::Channel::CH2);
+	const ScopeDriver::Channel chTrig = GetOscChannel(_trig.ch, ScopeDriver::Channel::CH2);
 
+	const bool bStim = !SameConfig(stim, _stim);
+	const bool bInput = !SameConfig(input, _input) || chInput != osChannelInput;
+	const bool bOutput = !SameConfig(output, _output) || chOutput != osChannelOutput;
+	const bool bTrig = !SameConfig(trig, _trig) || chTrig != osChannelTrig;
+	bool bSettle = bStim || bInput || bOutput;
 
-/*******************************************************************************
-* Class      : FreqResp
-* Function   : MeasureNext()
-* Access     : public
-* Arguments  : result = ref to FRS object to receive the freq measurement result
-* Returns    : FRRET result (see documentation for FRRET above)
-* Description:
-*   Performs one step of the frequency response measurement. Used when intermediate
-*   results are needed, for instance if updating a plot real-time.
-*/
-FRRET FreqResp::MeasureNext(FRS& result)
-{
-	FRRET nReturnVal = FRRET_SUCCESS;
+	freq = _freq;
+	stim = _stim;
+	input = _input;
+	output = _output;
+	trig = _trig;
+	meas = _meas;
+	dwell = _dwell;
 
-	if (!initialized)
+	// a channel no longer measured is turned off, so it does not share the sample rate and memory
+	for (ScopeDriver::Channel chPrevious : { osChannelInput, osChannelOutput })
 	{
-		nReturnVal = FRRET_NOT_INITIALIZED;
+		if (chPrevious != chInput && chPrevious != chOutput)
+			oscope->SetChannelEnable(chPrevious, false);
 	}
-	else if (completed)
+
+	osChannelInput = chInput;
+	osChannelOutput = chOutput;
+	osChannelTrig = chTrig;
+
+	// the stimulus starts at the new start frequency in either case
+	if (bStim)
 	{
-		nReturnVal = FRRET_COMPLETE;
+		const GeneratorDriver::Channel sgPrevious = sgChannel;
+		ConfigureStimulus(freq.fStart);
+		if (sgChannel != sgPrevious)
+			stimulus->SetChannelOutput(sgPrevious, false);
 	}
 	else
-	{
-		FRS frs_result;
-
-		nReturnVal = MeasureFreq(f, frs_result);
+		stimulus->SetChannelFreq(sgChannel, freq.fStart);
 
-		if (nReturnVal >= FRRET_SUCCESS)
-		{
-			result = frs_result;
-			data.push_back(frs_result);
+	// a leveled sweep starts again at the configured amplitude
+	if (!bStim && vStim != StimulusVpp())
+	{
+		vStim = StimulusVpp();
+		bSettle = true;
+		stimulus->SetChannel(sgChannel, numeric_limits<double>::quiet_NaN(), vStim, numeric_limits<double>::quiet_NaN(), numeric_limits<double>::quiet_NaN());
+	}
 
-			// get the next frequency, depending upon the sweep type
-			if (freq.sweep == Sweep_t::LOG)
-			{
-				f = f * exp(log(10.0) / freq.Npoints);
+	if (bInput)
+	{
+		ConfigureChannel(osChannelInput, input);
+		oscope->AdjustChannelVolts(osChannelInput, 0, osScaleInput);
+		autoInput->Reset();
+	}
+	if (bOutput)
+	{
+		ConfigureChannel(osChannelOutput, output);
+		oscope->AdjustChannelVolts(osChannelOutput, 0, osScaleOutput);
+		autoOutput->Reset();
+	}
+	if (bTrig)
+		ConfigureTrigger();
+	ConfigureMeasurement();
 
-				// look for completion condition
-				if (f > FREQ_FUDGE * freq.fStop)
-					completed = true;
-			}
-			else if (freq.sweep == Sweep_t::LIN)
-			{
-				f = f + (freq.fStop - freq.fStart) / (freq.Npoints - 1);
+	if (!IsConnected())
+		return FRRET_CONNECTION_LOST;
 
-				// look for completion condition
-				if (f > FREQ_FUDGE * freq.fStop)
-					completed = true;
-			}
-			else
-			{
-				// unknown test - no change to frequency - completed now
-				completed = true;
-			}
+	if (!plan->Build(freq, dwell, *oscope, *stimulus, sgChannel))
+		return FRRET_INVALID_FREQUENCY;
 
-			if (completed)
-				nReturnVal = FRRET_COMPLETE;
-		}
+	data = FRST();
+	checkpoint->Close();
+	completed = false;
+	iStep = 0;
+	maskFailures = 0;
+	order.clear();		// the order of the new plan is set by UseMask() or UseFit()
+	fit.reset();
+
+	// the calibration table follows the channel setup
+	if (cal)
+		calTable = cal->Find(CalibrationKey());
+	iCapture = SweepPlan::CAPTURE_DEFAULT;
+
+	// perform and discard one measurement at the initial frequency (see Init)
+	if (bSettle)
+	{
+		FRS unused;
+		MeasureFreq((*plan)[iStep], unused);
 	}
 
 	return nReturnVal;
@@ -485,71 +438,33 @@ FRRET FreqResp::MeasureNext(FRS& result)
 
 /*******************************************************************************
 * Class      : FreqResp
-* Function   : MeasureFreq()
-* Access     : private
-* Arguments  : f      = frequency at which response will be measured
-*              result = ref to FRS object to receive the freq measurement result
+* Function   : Validate()
+* Access     : private static
+* Arguments  : freq, stim, trig = configuration to check
 * Returns    : FRRET result (see documentation for FRRET above)
 * Description:
-*   Performs one step of the frequency response measurement.
+*   Sanity checks the configuration before it is applied to the instruments
 */
-FRRET FreqResp::MeasureFreq(double f, FRS& result)
+FRRET FreqResp::Validate(Freq_Config const& freq, Stim_Config const& stim, Trig_Config const& trig)
 {
 	FRRET nReturnVal = FRRET_SUCCESS;
-	const double Tideal = MEAS_CYCLES / f;
-	const double Tactual = oscope.SetTimebase(Tideal);
-
-	// set the test frequency
-	stimulus.SetChannelFreq(sgChannel, f);
-
-	// dwell here to allow the circuit transient response to stablize
-	DWORD dwDelay = DWORD(1000 * (dwell.stable_screens * Tactual));
-	if (dwDelay < dwell.minDwell_msec)
-		dwDelay = dwell.minDwell_msec;
-	Sleep(dwDelay); // milliseconds
-
-	bool bLoopDone = false;
-	int adjust_in = 0;
-	int adjust_out = 0;
-	double mag_in = 0.0, mag_out = 0.0, time_meas = 0.0;
-
-	int alternate_count = 0;
-	do
-	{
-		// Detection of "hunting" for a scale
-		int adjust_in_last = adjust_in;
-		int adjust_out_last = adjust_out;
 
-		// get the measurements and do an auto-scale step for input and output
-		mag_in = avMeasure * MeasureAndScaleInput(oscope, osChannelInput, mpMeasure, osScaleInput, adjust_in);
-		mag_out = avMeasure * MeasureAndScaleInput(oscope, osChannelOutput, mpMeasure, osScaleOutput, adjust_out);
-
-		if (adjust_in_last * adjust_in < 0 || adjust_out_last * adjust_out < 0)
-		{	// either in or out (or both) switched direction, count this towards limit
-			alternate_count = alternate_count + 1;
-		}
-
-		if ((adjust_in == 0 && adjust_out == 0) || alternate_count >= 3)
-		{	// no adjustments were made to the scaling or we are hunting for a scale...
-			// either way, measure phase|delay and exit the loop
-			if (meas.ttMeas == Ttype_t::DELAY)
-				time_meas = oscope.MeasureDelay(osChannelInput, osChannelOutput, measEdge);
-			else
-				time_meas = oscope.MeasureDelay(osChannelInput, osChannelOutput, Oscilloscope::MeasDelParam::PHA);
-			bLoopDone = true;
-		}
+	if (isnan(freq.fStart) || isnan(freq.fStop))
+		nReturnVal = FRRET_INVALID_FREQUENCY;
+	if (freq.fStart <= 0.0)
+		nReturnVal = FRRET_INVALID_FREQUENCY;
+	if (freq.fStop <= freq.fStart)
+		nReturnVal = FRRET_INVALID_FREQUENCY;
 
-	} while (!bLoopDone);
+	if (isnan(stim.vdc) || isnan(stim.vstim))
+		nReturnVal = FRRET_INVALID_STIM;
+	if (stim.vstim <= 0.0)
+		nReturnVal = FRRET_INVALID_STIM;
+	if (!isnan(stim.vlevel) && !(stim.vlevel > 0.0 && stim.vmax >= LEVEL_MIN_VPP))
+		nReturnVal = FRRET_INVALID_STIM;
 
-	const double mag_gain = abs(mag_out / mag_in);
-	const double dB_gain = 20.0 * log10(mag_gain);
-	
-	result.freq = f;
-	result.mag_in = mag_in;
-	result.mag_out = mag_out;
-	result.dBgain = dB_gain;
-	result.time = time_meas;
-	result.tunit = tunit;
+	if (isnan(trig.vTrig))
+		nReturnVal = FRRET_INVALID_TRIG;
 
 	return nReturnVal;
 }
@@ -557,54 +472,1611 @@ FRRET FreqResp::MeasureFreq(double f, FRS& result)
 
 /*******************************************************************************
 * Class      : FreqResp
-* Function   : operator FRST const&
-* Access     : public
-* Arguments  : none
-* Returns    : reference to FRST object
+* Function   : SameConfig()
+* Access     : private static
+* Arguments  : a, b = configurations to compare
+* Returns    : true if every setting of a and b is the same
 * Description:
-*   FRST conversion operator. Used to obtain the frequency response results.
+*   Used by Reconfigure() to send only the settings that changed
 */
-FreqResp::operator FRST const& () const
+bool FreqResp::SameConfig(Stim_Config const& a, Stim_Config const& b)
 {
-	return data;
+	return a.ch == b.ch && a.vtStim == b.vtStim && a.vstim == b.vstim && a.vdc == b.vdc
+		&& (a.vlevel == b.vlevel || (isnan(a.vlevel) && isnan(b.vlevel))) && a.vmax == b.vmax;
+}
+
+bool FreqResp::SameConfig(Channel_Config const& a, Channel_Config const& b)
+{
+	return a.ch == b.ch && a.coup == b.coup && a.atten == b.atten && a.bwl == b.bwl;
+}
+
+bool FreqResp::SameConfig(Trig_Config const& a, Trig_Config const& b)
+{
+	return a.ch == b.ch && a.edge == b.edge && a.coup == b.coup && a.vTrig == b.vTrig;
 }
 
 
 /*******************************************************************************
-* Function   : MeasureAndScaleInput()
-* Arguments  : oscope    = reference to oscilloscope object
-*              ch        = oscilloscope channel
-*              mpMeasure = type of measurement parameter to return
-*              scale     = reference to scale structure, holds scale info on return
-*              adjust    = reference to adjustment value, holds actual applied adjust on return
-* Returns    : measurement value; scale and adjust references receive data on return
+* Class      : FreqResp
+* Function   : ConfigureStimulus()
+* Access     : private
+* Arguments  : fStim    = frequency to apply to the stimulus channel
+*              bRestore = true to apply the current amplitude (vStim) again,
+*                         instead of the configured one
+* Returns    : none
 * Description:
-*   This function implements channel measurement and auto-scaling adjustment.
-*   The adjust reference on entry contains the last adjustment (-3 to +3) made.
-*   Initialize to 0 on the first call to this function.
-*   On exit, it contanis the number of steps the vertical scale was adjusted, or contains
-*   0 if no adjustment was made. Call this function repeatedly until the adjust parameter
-*   is 0.
-*   The return value is the actual measurement.
+*   Applies the stimulus configuration to the attached sine wave generator.
+*   Used by Init(), and by Recover() to restore the generator after
+*   reconnecting: a leveled sweep continues at the amplitude it had reached,
+*   which the vertical scales and the autoscale ranges were found with.
 */
-double FreqResp::MeasureAndScaleInput(Oscilloscope& oscope, Oscilloscope::Channel ch, Oscilloscope::MeasParam mpMeasure, Oscilloscope::ScaleValues& scale, int& adjust)
+void FreqResp::ConfigureStimulus(double fStim, bool bRestore)
 {
-	// adjust is set to 0 when all adjustments have been completed
-	// keep calling this until adjustments have been completed
-
-	// get the measurements
-	const double mag = oscope.Measure(ch, mpMeasure);
-	const int last_adjust = adjust;
-	const double mag_pkpk = (mpMeasure == Oscilloscope::MeasParam::PKPK) ? mag : oscope.Measure(ch, Oscilloscope::MeasParam::PKPK);
-
-	if (mag_pkpk > (SEEK_MAX - SEEK_MARGIN) * scale.pp)
-		adjust = oscope.AdjustChannelVolts(ch, +1, scale);
-	else if (mag_pkpk < (SEEK_MIN - SEEK_MARGIN) * scale.pp)
-		adjust = oscope.AdjustChannelVolts(ch, -2, scale);
-	else if (mag_pkpk < (SEEK_MID - SEEK_MARGIN) * scale.pp)
-		adjust = oscope.AdjustChannelVolts(ch, -1, scale);
+	switch (stim.ch)
+	{
+	case 1: default:
+		sgChannel = GeneratorDriver::Channel::CH1;
+		break;
+	case 2:
+		sgChannel = GeneratorDriver::Channel::CH2;
+		break;
+	}
+
+	if (!bRestore || !(vStim > 0.0))
+		vStim = StimulusVpp();
+
+	stimulus->SetChannel(sgChannel, fStim, vStim, stim.vdc, 0.0);
+	stimulus->SetChannelOutput(sgChannel, true);
+}
+
+
+/*******************************************************************************
+* Class      : FreqResp
+* Function   : StimulusVpp()
+* Access     : private
+* Arguments  : none
+* Returns    : configured stimulus amplitude (Vpp)
+* Description:
+*   Converts the stimulus amplitude of the configuration to Vpp. A leveled
+*   sweep starts at this amplitude, limited to the leveling maximum.
+*/
+double FreqResp::StimulusVpp() const
+{
+	double vpp;
+
+	switch (stim.vtStim)
+	{
+	case Vtype_t::VPK:
+		vpp = 2.0 * abs(stim.vstim);  // express in Vpp = 2.0*Vpk
+		break;
+	case Vtype_t::VPP: default:
+		vpp = abs(stim.vstim);
+		break;
+	}
+
+	if (!isnan(stim.vlevel) && vpp > stim.vmax)
+		vpp = stim.vmax;
+
+	return vpp;
+}
+
+
+/*******************************************************************************
+* Class      : FreqResp
+* Function   : Level()
+* Access     : private
+* Arguments  : vOut = output amplitude measured (Vpp)
+* Returns    : true if the stimulus amplitude was changed
+* Description:
+*   Stimulus leveling: if the output has left the window of LEVEL_WINDOW
+*   around its target, scales the stimulus amplitude to bring it back to the
+*   target, within LEVEL_MIN_VPP and the leveling maximum. An output lost in
+*   the noise raises the stimulus to the maximum. Both vertical scales are
+*   moved by the same ratio in 1-2-5 steps, so the autoscale starts near its
+*   result. The gain is unaffected, as the input channel measures the
+*   stimulus.
+*/
+bool FreqResp::Level(double vOut)
+{
+	if (isnan(stim.vlevel))
+		return false;
+
+	if (vOut >= stim.vlevel / LEVEL_WINDOW && vOut <= stim.vlevel * LEVEL_WINDOW)
+		return false;
+
+	double vNew = (vOut > 0.0) ? vStim * stim.vlevel / vOut : stim.vmax;
+	if (vNew > stim.vmax)
+		vNew = stim.vmax;
+	if (vNew < LEVEL_MIN_VPP)
+		vNew = LEVEL_MIN_VPP;
+
+	// at the limit already
+	if (abs(vNew - vStim) <= 1.0e-3 * vStim)
+		return false;
+
+	const double NaN = numeric_limits<double>::quiet_NaN();
+	stimulus->SetChannel(sgChannel, NaN, vNew, NaN, NaN);
+
+	// three 1-2-5 steps per decade
+	const int steps = int(lround(3.0 * log10(vNew / vStim)));
+	if (steps != 0)
+	{
+		oscope->AdjustChannelVolts(osChannelInput, steps, osScaleInput);
+		oscope->AdjustChannelVolts(osChannelOutput, steps, osScaleOutput);
+	}
+
+	vStim = vNew;
+
+	return true;
+}
+
+
+/*******************************************************************************
+* Class      : FreqResp
+* Function   : ConfigureOscilloscope()
+* Access     : private
+* Arguments  : none
+* Returns    : none
+* Description:
+*   Applies the channel, trigger, and measurement configuration to the attached
+*   oscilloscope. Used by Init(), and by Recover() to restore the oscilloscope
+*   after reconnecting.
+*/
+void FreqResp::ConfigureOscilloscope()
+{
+	// initialize oscilloscope measurement
+	osChannelInput = GetOscChannel(input.ch, ScopeDriver::Channel::CH1);
+	osChannelOutput = GetOscChannel(output.ch, ScopeDriver::Channel::CH2);
+	osChannelTrig = GetOscChannel(trig.ch, ScopeDriver::Channel::CH2);
+
+	ConfigureChannel(osChannelInput, input);
+	ConfigureChannel(osChannelOutput, output);
+	ConfigureTrigger();
+	ConfigureMeasurement();
+}
+
+
+/*******************************************************************************
+* Class      : FreqResp
+* Function   : ConfigureChannel()
+* Access     : private
+* Arguments  : ch     = oscilloscope channel
+*              config = channel configuration
+* Returns    : none
+* Description:
+*   Enables and configures one oscilloscope channel, starting at 1V/div
+*/
+void FreqResp::ConfigureChannel(ScopeDriver::Channel ch, Channel_Config const& config)
+{
+	oscope->SetChannelEnable(ch, true);
+	if (config.bwl)
+		oscope->SetChannelBWL(ch, ScopeDriver::BWLimit::BWL_ON);
+	else
+		oscope->SetChannelBWL(ch, ScopeDriver::BWLimit::BWL_FULL);
+	if (config.atten == 10.0)
+		oscope->SetChannelAtten(ch, ScopeDriver::ChAtten::AT_10X);
+	else
+		oscope->SetChannelAtten(ch, ScopeDriver::ChAtten::AT_1X);
+	oscope->SetChannelVoltsEx(ch, 1.0, 0.0);
+
+	switch (config.coup)
+	{
+	case Ctype_t::AC: default:
+		oscope->SetChannelCoupling(ch, ScopeDriver::Coupling::AC);
+		break;
+	case Ctype_t::DC:
+		oscope->SetChannelCoupling(ch, ScopeDriver::Coupling::DC);
+		break;
+	}
+}
+
+
+/*******************************************************************************
+* Class      : FreqResp
+* Function   : ConfigureTrigger()
+* Access     : private
+* Arguments  : tHoldoff = trigger holdoff time (seconds), 0 for none
+* Returns    : none
+* Description:
+*   Applies the trigger configuration, and selects the matching delay edges
+*/
+void FreqResp::ConfigureTrigger(double tHoldoff)
+{
+	ScopeDriver::EdgeType trigEdge;
+	switch (trig.edge)
+	{
+	case Etype_t::RISE: default:
+		trigEdge = ScopeDriver::EdgeType::RISING;
+		measEdge = ScopeDriver::MeasDelParam::FRR;
+		break;
+	case Etype_t::FALL:
+		trigEdge = ScopeDriver::EdgeType::FALLING;
+		measEdge = ScopeDriver::MeasDelParam::FFF;
+		break;
+	}
+
+	ScopeDriver::Coupling trigCoup;
+	switch (trig.coup)
+	{
+	case Ctype_t::AC: default:
+		trigCoup = ScopeDriver::Coupling::AC;
+		break;
+	case Ctype_t::DC:
+		trigCoup = ScopeDriver::Coupling::DC;
+		break;
+
+	}
+	oscope->SetTriggerMode(ScopeDriver::TriggerMode::AUTO);
+	oscope->SetEdgeTrigger(osChannelTrig, trigEdge, trig.vTrig, trigCoup, tHoldoff > 0.0, tHoldoff);
+}
+
+
+/*******************************************************************************
+* Class      : FreqResp
+* Function   : ConfigureMeasurement()
+* Access     : private
+* Arguments  : none
+* Returns    : none
+* Description:
+*   Selects the measurement parameter and scaling (no instrument commands)
+*/
+void FreqResp::ConfigureMeasurement()
+{
+	// both VPP and VPK use AMPL, which is essentially peak-to-peak with some noise reduction
+	// but VPK returns 0.5 x AMPL whereas VPP returns 1.0 x AMPL
+	mpMeasure = ScopeDriver::MeasParam::AMPL;
+
+	switch (meas.vtMeas)
+	{
+	case Vtype_t::VPK: default:
+		avMeasure = 0.5;
+		break;
+	case Vtype_t::VPP:
+		avMeasure = 1.0;
+		break;
+	}
+
+	// set the phase/delay type
+	if (meas.ttMeas == Ttype_t::DELAY)
+		tunit = TUNIT::DELAY;
+	else
+		tunit = TUNIT::PHASE;
+
+	// shortest usable capture: an edge delay needs one cycle, while the phase
+	// and the amplitude histogram of a Vpk measurement need two
+	if (meas.ttMeas == Ttype_t::DELAY && meas.vtMeas == Vtype_t::VPP)
+		iCaptureMin = 0;
+	else
+		iCaptureMin = 1;
+}
+
+
+/*******************************************************************************
+* Class      : FreqResp
+* Function   : GetOscChannel()
+* Access     : private static
+* Arguments  : ch        = channel number 1-4
+*              chDefault = channel used for any other number
+* Returns    : the oscilloscope channel
+* Description:
+*   Maps a configured channel number to an oscilloscope channel
+*/
+ScopeDriver::Channel FreqResp::GetOscChannel(int ch, ScopeDriver::Channel chDefault)
+{
+	switch (ch)
+	{
+	case 1:
+		return ScopeDriver::Channel::CH1;
+	case 2:
+		return ScopeDriver::Channel::CH2;
+	case 3:
+		return ScopeDriver::Channel::CH3;
+	case 4:
+		return ScopeDriver::Channel::CH4;
+	default:
+		return chDefault;
+	}
+}
+
+
+/*******************************************************************************
+* Class      : FreqResp
+* Function   : IsConnected()
+* Access     : private
+* Arguments  : none
+* Returns    : true if both instruments are communicating, false otherwise
+* Description:
+*   Checks the connection health of both instruments.
+*/
+bool FreqResp::IsConnected() const
+{
+	return stimulus && stimulus->IsConnected() && oscope && oscope->IsConnected();
+}
+
+
+/*******************************************************************************
+* Class      : FreqResp
+* Function   : Recover()
+* Access     : private
+* Arguments  : none
+* Returns    : FRRET result (see documentation for FRRET above)
+* Description:
+*   Reconnects any instrument whose connection was lost and replays the last
+*   known configuration: the stimulus at the current frequency, and the
+*   oscilloscope channels, trigger, and vertical scales. The sweep may then
+*   continue from the current frequency. Both instruments are reconnected
+*   concurrently if both were lost.
+*/
+FRRET FreqResp::Recover()
+{
+	FRRET nReturnVal = FRRET_SUCCESS;
+
+	const bool bStimLost = !stimulus->IsConnected();
+	const bool bOscopeLost = !oscope->IsConnected();
+
+	future<bool> futSigGen;
+	if (bStimLost)
+		futSigGen = async(launch::async, [this]() { return stimulus->Reconnect(); });
+	const bool bOscope = !bOscopeLost || oscope->Reconnect();
+	const bool bSigGen = !bStimLost || futSigGen.get();
+
+	if (bStimLost)
+	{
+		if (bSigGen)
+			ConfigureStimulus((*plan)[iStep].freq, true);
+		else
+			nReturnVal = FRRET_CONNECTION_LOST;
+	}
+
+	if (nReturnVal >= FRRET_SUCCESS && bOscopeLost)
+	{
+		if (bOscope)
+		{
+			ConfigureOscilloscope();
+
+			// restore the vertical scales found by the auto-scaling, then refresh them
+			if (osScaleInput.vdiv > 0.0)
+				oscope->SetChannelVoltsEx(osChannelInput, osScaleInput.vdiv, osScaleInput.offset);
+			if (osScaleOutput.vdiv > 0.0)
+				oscope->SetChannelVoltsEx(osChannelOutput, osScaleOutput.vdiv, osScaleOutput.offset);
+			oscope->AdjustChannelVolts(osChannelOutput, 0, osScaleOutput);
+			oscope->AdjustChannelVolts(osChannelInput, 0, osScaleInput);
+		}
+		else
+		{
+			nReturnVal = FRRET_CONNECTION_LOST;
+		}
+	}
+
+	return nReturnVal;
+}
+
+
+/*******************************************************************************
+* Class      : FreqResp
+* Function   : Sweep()
+* Access     : public
+* Arguments  : none
+* Returns    : FRRET result (see documentation for FRRET above)
+* Description:
+*   Performs the entire frequency response sweep. The results can be obtained
+*   afterward by a call to the FRST conversion operator.
+*/
+FRRET FreqResp::Sweep()
+{
+	if (!initialized)
+		return FRRET_NOT_INITIALIZED;
+
+	FRRET nReturnVal = FRRET_SUCCESS;
+
+	// restart from the first step of the plan
+	completed = false;
+	iStep = 0;
+	maskFailures = 0;
+
+	while (!completed)
+	{
+		FRS unused;
+		nReturnVal = MeasureNext(unused);
+
+		if (nReturnVal < FRRET_SUCCESS)
+			break;
+	}
+
+	return nReturnVal;
+}
+
+
+/*******************************************************************************
+* Class      : FreqResp
+* Function   : HardwareSweep()
+* Access     : public
+* Arguments  : none
+* Returns    : FRRET result (see documentation for FRRET above), FRRET_COMPLETE
+*              when the sweep was measured, FRRET_HW_SWEEP if it could not be
+*              measured this way (measure it with Sweep() or MeasureNext())
+* Description:
+*   Measures the whole sweep with no instrument traffic per point. The
+*   generator runs its own stepped sweep, holding each frequency for tStep,
+*   while the oscilloscope captures one sequence segment per step: the
+*   trigger holdoff of tStep spaces the segments, and the first is armed
+*   once the first step has settled. The segments are then measured as
+*   history frames in a single pipelined batch.
+*
+*   One timebase serves every step, so it is chosen for the lowest
+*   frequency, and the vertical scales are fixed for the sweep, taken as the
+*   larger of the autoscale results at the first and last steps; use this
+*   where the response stays within that range. Requires a linear sweep
+*   (the generator's stepped sweep is evenly spaced) and a step time within
+*   the oscilloscope's longest holdoff. The segments are timed by the holdoff
+*   alone, so each step also allows for the drift of the whole sweep (one
+*   cycle of the lowest frequency per step): with a 1.5 s holdoff, a sweep of
+*   nSteps / fStart above about 1.4 s is not measured this way. Requires
+*   models with the capabilities (CAP_NATIVE_SWEEP generator, CAP_SEGMENTED
+*   oscilloscope). The stimulus amplitude is fixed for the sweep, and only
+*   the last segment's waveform could be read back, so a leveled sweep or one
+*   with harmonic analysis is not measured this way. Each step is captured
+*   once, so neither is an averaged sweep.
+*/
+FRRET FreqResp::HardwareSweep()
+{
+	if (!initialized)
+		return FRRET_NOT_INITIALIZED;
+
+	if (!stimulus->Supports(CAP_NATIVE_SWEEP) || !oscope->Supports(CAP_SEGMENTED))
+		return FRRET_HW_SWEEP;
+
+	const size_t nSteps = plan->Size();
+
+	if (freq.sweep != Sweep_t::LIN || nSteps < 2 || nSteps > stimulus->SweepStepsMax() || !isnan(stim.vlevel) || meas.is_harmonics || meas.nAvgMax > 1)
+		return FRRET_HW_SWEEP;
+
+	SweepStep const& first = (*plan)[0];
+	SweepStep const& last = (*plan)[nSteps - 1];
+
+	// one capture for every step: the default number of cycles of the lowest
+	// frequency, sampled fast enough for the highest
+	SweepCapture const& capture = first.capture[SweepPlan::CAPTURE_DEFAULT];
+	const ScopeDriver::MemDepth mdepthSweep = oscope->FindMemoryDepth(capture.tcapture, SweepPlan::SAMPLES_PER_CYCLE * last.freq);
+
+	// the capture is centred on the trigger; the first is armed after the
+	// settling time and half a capture, and each step allows for the trigger
+	// waiting up to one cycle per step (at the lowest frequency) to accumulate
+	const double tArm = capture.dwell_msec / 1000.0 + capture.tcapture / 2.0;
+	const double tStep = tArm + capture.tcapture / 2.0 + nSteps / first.freq + HW_MARGIN_SEC;
+
+	if (tStep > oscope->HoldoffMax())
+		return FRRET_HW_SWEEP;
+
+	// vertical scales: the larger of the autoscale results at both ends
+	FRS unused;
+	MeasureFreq(last, unused);
+	const ScopeDriver::ScaleValues scaleInLast = osScaleInput;
+	const ScopeDriver::ScaleValues scaleOutLast = osScaleOutput;
+	MeasureFreq(first, unused);
+
+	if (scaleInLast.vdiv > osScaleInput.vdiv)
+	{
+		oscope->SetChannelVoltsEx(osChannelInput, scaleInLast.vdiv, scaleInLast.offset);
+		osScaleInput = scaleInLast;
+	}
+	if (scaleOutLast.vdiv > osScaleOutput.vdiv)
+	{
+		oscope->SetChannelVoltsEx(osChannelOutput, scaleOutLast.vdiv, scaleOutLast.offset);
+		osScaleOutput = scaleOutLast;
+	}
+
+	// segmented capture, one segment per step
+	oscope->SetCapture(capture.tdiv, mdepthSweep, 0.0);
+	ConfigureTrigger(tStep);
+	oscope->SetSequence((unsigned int)nSteps);
+
+	bool bResult = stimulus->SetStepSweep(sgChannel, first.freq, last.freq, (unsigned int)nSteps, nSteps * tStep);
+	if (bResult)
+		bResult = stimulus->TriggerSweep(sgChannel);
+	if (bResult)
+	{
+		Sleep((DWORD)(1000.0 * tArm));
+		oscope->SetTriggerMode(ScopeDriver::TriggerMode::SINGLE);
+		bResult = oscope->WaitForStop(nSteps * tStep + HW_TIMEOUT_SEC);
+	}
+
+	vector<ScopeDriver::FrameMeas> frames;
+	if (bResult)
+	{
+		const ScopeDriver::MeasDelParam delParam = (meas.ttMeas == Ttype_t::DELAY) ? measEdge : ScopeDriver::MeasDelParam::PHA;
+		bResult = oscope->MeasureFrames((unsigned int)nSteps, osChannelInput, osChannelOutput, mpMeasure, delParam, frames);
+	}
+
+	// back to point-by-point operation
+	stimulus->StopSweep(sgChannel);
+	stimulus->SetChannelFreq(sgChannel, freq.fStart);
+	oscope->SetSequence(0);
+	ConfigureTrigger();
+
+	if (!IsConnected())
+		return FRRET_CONNECTION_LOST;
+	if (!bResult || frames.size() != nSteps)
+		return FRRET_HW_SWEEP;
+
+	data = FRST();
+	for (size_t k = 0; k < nSteps; ++k)
+	{
+		FRS point;
+		point.freq = (*plan)[k].freq;
+		point.mag_in = avMeasure * frames[k].in;
+		point.mag_out = avMeasure * frames[k].out;
+		point.dBgain = 20.0 * log10(abs(point.mag_out / point.mag_in));
+		point.time = frames[k].delay;
+		point.tunit = tunit;
+		point.sd_dBgain = 0.0;
+		point.sd_time = 0.0;
+		point.count = 1;
+		point.vstim = vStim;
+		point.is_harmonics = false;
+		point.fund = point.h2 = point.h3 = point.h4 = point.h5 = point.thd = point.thdn = numeric_limits<double>::quiet_NaN();
+
+		if (calTable != nullptr)
+			calTable->Correct(point);
+
+		if (mask && !mask->Check(point))
+			maskFailures = maskFailures + 1;
+
+		data.push_back(point);
+
+		if (checkpoint->IsOpen())
+			checkpoint->WritePoint(point, plan->Frequency(k + 1));
+	}
+
+	// the model is fitted to the whole sweep at once
+	if (fit)
+		fit->Update(data);
+
+	iStep = nSteps;
+	completed = true;
+
+	return FRRET_COMPLETE;
+}
+
+/*******************************************************************************
+* Class      : FreqResp
+* Function   : Search()
+* Access     : public
+* Arguments  : search = characteristics to find, and the search limits
+*              found  = receives the characteristics (NaN if not found)
+* Returns    : FRRET result (see documentation for FRRET above), FRRET_COMPLETE
+*              when the search is done
+* Description:
+*   Converges on characteristics of the response instead of sweeping it. A
+*   coarse log grid of SEARCH_POINTS_PER_DECADE from fStart to fStop brackets
+*   each characteristic, which is then narrowed on the live measurement:
+*     bandwidth: bisection (in log f) of the first fall of the gain through
+*                dBcorner below the gain at fStart
+*     peak:      golden-section search around the largest coarse gain, if it
+*                is between fStart and fStop (not at either end)
+*     crossover: bisection of the first fall through 0 dB, with the phase
+*                margin from the phase interpolated to the crossover
+*   Each search ends when its bracket is within the frequency tolerance, or
+*   when nPointsMax points have been measured; the corner and crossover are
+*   then interpolated within the last bracket. The points visited are the
+*   results, in order of frequency, from the FRST conversion operator.
+*/
+FRRET FreqResp::Search(Search_Config const& search, FR_Characteristics& found)
+{
+	const double NaN = numeric_limits<double>::quiet_NaN();
+	found = { NaN, NaN, NaN, NaN, NaN, NaN };
+
+	if (!initialized)
+		return FRRET_NOT_INITIALIZED;
+
+	data = FRST();
+	completed = false;
+	iStep = 0;
+
+	FRRET nReturnVal = FRRET_SUCCESS;
+
+	// coarse grid over the sweep range, at least both ends and the middle
+	const double decades = log10(freq.fStop / freq.fStart);
+	const size_t nCoarse = max(size_t(3), size_t(ceil(SEARCH_POINTS_PER_DECADE * decades)) + 1);
+	vector<FRS> coarse(nCoarse);
+
+	for (size_t k = 0; k < nCoarse && nReturnVal >= FRRET_SUCCESS; ++k)
+		nReturnVal = MeasureSearch(freq.fStart * pow(10.0, decades * k / (nCoarse - 1)), coarse[k]);
+
+	// bandwidth corner
+	if (nReturnVal >= FRRET_SUCCESS && (search.features & SEARCH_BANDWIDTH))
+	{
+		const double dBtarget = coarse[0].dBgain + search.dBcorner;
+		found.dBref = coarse[0].dBgain;
+
+		for (size_t k = 1; k < nCoarse; ++k)
+		{
+			if (coarse[k].dBgain <= dBtarget)
+			{
+				FRS above = coarse[k - 1];
+				FRS below = coarse[k];
+				double phase;
+
+				nReturnVal = BisectFall(dBtarget, search, above, below);
+				if (nReturnVal >= FRRET_SUCCESS)
+					found.fCorner = InterpolateFall(dBtarget, above, below, phase);
+				break;
+			}
+		}
+	}
+
+	// peak
+	if (nReturnVal >= FRRET_SUCCESS && (search.features & SEARCH_PEAK))
+	{
+		size_t kMax = 0;
+		for (size_t k = 1; k < nCoarse; ++k)
+		{
+			if (coarse[k].dBgain > coarse[kMax].dBgain)
+				kMax = k;
+		}
+
+		if (kMax > 0 && kMax + 1 < nCoarse)
+		{
+			// golden-section search (in log f) between the neighbours of the largest gain
+			FRS best = coarse[kMax];
+			double ua = log10(coarse[kMax - 1].freq);
+			double ub = log10(coarse[kMax + 1].freq);
+			double uc = ub - SEARCH_GOLDEN * (ub - ua);
+			double ud = ua + SEARCH_GOLDEN * (ub - ua);
+			FRS c, d;
+
+			nReturnVal = MeasureSearch(pow(10.0, uc), c);
+			if (nReturnVal >= FRRET_SUCCESS)
+				nReturnVal = MeasureSearch(pow(10.0, ud), d);
+
+			while (nReturnVal >= FRRET_SUCCESS)
+			{
+				if (c.dBgain > best.dBgain)
+					best = c;
+				if (d.dBgain > best.dBgain)
+					best = d;
+
+				if (ub - ua <= log10(1.0 + search.fTolerance) || data.size() >= search.nPointsMax)
+					break;
+
+				if (c.dBgain > d.dBgain)
+				{
+					// the peak is in [a, d]
+					ub = ud;
+					ud = uc;
+					d = c;
+					uc = ub - SEARCH_GOLDEN * (ub - ua);
+					nReturnVal = MeasureSearch(pow(10.0, uc), c);
+				}
+				else
+				{
+					// the peak is in [c, b]
+					ua = uc;
+					uc = ud;
+					c = d;
+					ud = ua + SEARCH_GOLDEN * (ub - ua);
+					nReturnVal = MeasureSearch(pow(10.0, ud), d);
+				}
+			}
+
+			if (nReturnVal >= FRRET_SUCCESS)
+			{
+				found.fPeak = best.freq;
+				found.dBpeak = best.dBgain;
+			}
+		}
+	}
+
+	// unity gain crossover
+	if (nReturnVal >= FRRET_SUCCESS && (search.features & SEARCH_CROSSOVER))
+	{
+		for (size_t k = 1; k < nCoarse; ++k)
+		{
+			if (coarse[k - 1].dBgain > 0.0 && coarse[k].dBgain <= 0.0)
+			{
+				FRS above = coarse[k - 1];
+				FRS below = coarse[k];
+				double phase;
+
+				nReturnVal = BisectFall(0.0, search, above, below);
+				if (nReturnVal >= FRRET_SUCCESS)
+				{
+					found.fCrossover = InterpolateFall(0.0, above, below, phase);
+					found.phaseMargin = remainder(180.0 + phase, 360.0);
+				}
+				break;
+			}
+		}
+	}
+
+	if (nReturnVal < FRRET_SUCCESS)
+		return nReturnVal;
+
+	sort(data.begin(), data.end(), [](FRS const& a, FRS const& b) { return a.freq < b.freq; });
+
+	iStep = plan->Size();
+	completed = true;
+
+	return FRRET_COMPLETE;
+}
+
+
+/*******************************************************************************
+* Class      : FreqResp
+* Function   : MeasureSearch()
+* Access     : private
+* Arguments  : f      = frequency to measure
+*              result = receives the measurement
+* Returns    : FRRET result (see documentation for FRRET above)
+* Description:
+*   Measures one point chosen by a search, and adds it to the results
+*/
+FRRET FreqResp::MeasureSearch(double f, FRS& result)
+{
+	const FRRET nReturnVal = MeasurePoint(plan->Step(f, *oscope, *stimulus, sgChannel), result);
+
+	if (nReturnVal >= FRRET_SUCCESS)
+		data.push_back(result);
+
+	return nReturnVal;
+}
+
+
+/*******************************************************************************
+* Class      : FreqResp
+* Function   : BisectFall()
+* Access     : private
+* Arguments  : dBtarget = gain the response falls through
+*              search   = search limits
+*              above    = lower frequency of the bracket (gain above dBtarget), updated
+*              below    = upper frequency of the bracket (gain at or below dBtarget), updated
+* Returns    : FRRET result (see documentation for FRRET above)
+* Description:
+*   Narrows a bracket of a fall through dBtarget by measuring at its centre
+*   (in log f) until it is within the frequency tolerance, or until the most
+*   points of the search have been measured
+*/
+FRRET FreqResp::BisectFall(double dBtarget, Search_Config const& search, FRS& above, FRS& below)
+{
+	FRRET nReturnVal = FRRET_SUCCESS;
+
+	while (below.freq > (1.0 + search.fTolerance) * above.freq && data.size() < search.nPointsMax)
+	{
+		FRS mid;
+		nReturnVal = MeasureSearch(sqrt(above.freq * below.freq), mid);
+		if (nReturnVal < FRRET_SUCCESS)
+			break;
+
+		if (mid.dBgain > dBtarget)
+			above = mid;
+		else
+			below = mid;
+	}
+
+	return nReturnVal;
+}
+
+
+/*******************************************************************************
+* Class      : FreqResp
+* Function   : InterpolateFall()
+* Access     : private static
+* Arguments  : dBtarget = gain the response falls through
+*              above    = lower frequency of the bracket (gain above dBtarget)
+*              below    = upper frequency of the bracket (gain at or below dBtarget)
+*              phase    = receives the phase at the crossing (degrees)
+* Returns    : frequency of the crossing
+* Description:
+*   Interpolates the crossing of dBtarget linearly in dB against log f, and
+*   the phase there (unwrapped across the bracket)
+*/
+double FreqResp::InterpolateFall(double dBtarget, FRS const& above, FRS const& below, double& phase)
+{
+	const double t = (above.dBgain - dBtarget) / (above.dBgain - below.dBgain);
+	const double phaseAbove = PointPhase(above);
+
+	phase = phaseAbove + t * remainder(PointPhase(below) - phaseAbove, 360.0);
+
+	return pow(10.0, log10(above.freq) + t * (log10(below.freq) - log10(above.freq)));
+}
+
+
+/*******************************************************************************
+* Class      : FreqResp
+* Function   : PointPhase()
+* Access     : private static
+* Arguments  : point = measured point
+* Returns    : phase of the output relative to the input (degrees)
+* Description:
+*   Returns the phase of a point, converting a delay measurement to phase
+*/
+double FreqResp::PointPhase(FRS const& point)
+{
+	if (point.tunit == TUNIT::PHASE)
+		return point.time;
+	else
+		return -360.0 * point.freq * point.time;
+}
+
+
+/*******************************************************************************
+* Class      : FreqResp
+* Function   : Checkpoint()
+* Access     : public
+* Arguments  : szCheckpoint = checkpoint filename
+* Returns    : FRRET result (see documentation for FRRET above)
+* Description:
+*   Starts recording the sweep progress to a new checkpoint file. The sweep
+*   configuration is written immediately and each completed point is appended
+*   by MeasureNext(). Call after Init().
+*/
+FRRET FreqResp::Checkpoint(char const* szCheckpoint)
+{
+	if (!initialized)
+		return FRRET_NOT_INITIALIZED;
+
+	if (!checkpoint->Create(szCheckpoint, freq, stim, input, output, trig, meas, dwell))
+		return FRRET_INVALID_CHECKPOINT;
+
+	return FRRET_SUCCESS;
+}
+
+
+/*******************************************************************************
+* Class      : FreqResp
+* Function   : Resume()
+* Access     : public
+* Arguments  : szCheckpoint = checkpoint filename
+* Returns    : FRRET result (see documentation for FRRET above)
+*              FRRET_COMPLETE if the checkpoint already holds the whole sweep
+* Description:
+*   Restores the points completed in a checkpoint file and continues from the
+*   frequency following the last completed point, appending new points to the
+*   same file. Call after Init() using the configuration stored in the
+*   checkpoint (see SweepCheckpoint::Load()), then continue with MeasureNext().
+*/
+FRRET FreqResp::Resume(char const* szCheckpoint)
+{
+	if (!initialized)
+		return FRRET_NOT_INITIALIZED;
+
+	Freq_Config ckFreq;
+	Stim_Config ckStim;
+	Channel_Config ckInput;
+	Channel_Config ckOutput;
+	Trig_Config ckTrig;
+	Meas_Config ckMeas;
+	Dwell_Config ckDwell;
+	FRST ckData;
+	double fNext;
+
+	if (!SweepCheckpoint::Load(szCheckpoint, ckFreq, ckStim, ckInput, ckOutput, ckTrig, ckMeas, ckDwell, ckData, fNext))
+		return FRRET_INVALID_CHECKPOINT;
+
+	// the remaining frequencies are only valid for the same sweep and measurement
+	if (ckFreq.fStart != freq.fStart || ckFreq.fStop != freq.fStop || ckFreq.sweep != freq.sweep || ckFreq.Npoints != freq.Npoints)
+		return FRRET_INVALID_CHECKPOINT;
+	if (ckMeas.vtMeas != meas.vtMeas || ckMeas.ttMeas != meas.ttMeas || ckMeas.is_harmonics != meas.is_harmonics)
+		return FRRET_INVALID_CHECKPOINT;
+
+	if (!checkpoint->Append(szCheckpoint))
+		return FRRET_INVALID_CHECKPOINT;
+
+	data = ckData;
+	iStep = plan->FindStep(fNext);
+	completed = (iStep >= plan->Size());
+
+	return completed ? FRRET_COMPLETE : FRRET_SUCCESS;
+}
+
+
+/*******************************************************************************
+* Class      : FreqResp
+* Function   : UseCalibration()
+* Access     : public
+* Arguments  : szCalFile = bench calibration filename, nullptr or empty for none
+* Returns    : FRRET result (see documentation for FRRET above)
+*              FRRET_CAL_EXTRAPOLATED if the sweep extends beyond the table
+* Description:
+*   Corrects the following measurements with the calibration table of the
+*   current setup from a bench calibration file (see ChannelCal). The table
+*   is selected again by Reconfigure() when the setup changes. Call after
+*   Init().
+*/
+FRRET FreqResp::UseCalibration(char const* szCalFile)
+{
+	if (!initialized)
+		return FRRET_NOT_INITIALIZED;
+
+	calTable = nullptr;
+
+	if (szCalFile == nullptr || *szCalFile == 0)
+	{
+		cal.reset();
+		return FRRET_SUCCESS;
+	}
+
+	cal.reset(new ChannelCal());
+	if (!cal->Load(szCalFile))
+	{
+		cal.reset();
+		return FRRET_INVALID_CALIBRATION;
+	}
+
+	calTable = cal->Find(CalibrationKey());
+	if (calTable == nullptr)
+		return FRRET_NO_CALIBRATION;
+
+	return calTable->Covers(freq.fStart, freq.fStop) ? FRRET_SUCCESS : FRRET_CAL_EXTRAPOLATED;
+}
+
+
+/*******************************************************************************
+* Class      : FreqResp
+* Function   : SaveCalibration()
+* Access     : public
+* Arguments  : szCalFile = bench calibration filename
+* Returns    : FRRET result (see documentation for FRRET above)
+* Description:
+*   Stores the completed sweep as the calibration table of the current setup
+*   in a bench calibration file, keeping the tables of other setups. The
+*   sweep must be a through sweep (input and output probes on the same
+*   signal) measured without a calibration in use. A file that exists but
+*   cannot be read completely is not replaced, since its unread tables would
+*   be lost.
+*/
+FRRET FreqResp::SaveCalibration(char const* szCalFile)
+{
+	if (!initialized)
+		return FRRET_NOT_INITIALIZED;
+
+	if (!completed || calTable != nullptr)
+		return FRRET_INVALID_CALIBRATION;
+
+	// a missing file is started empty
+	ChannelCal bench;
+	if (!bench.Load(szCalFile) && ifstream(szCalFile).is_open())
+		return FRRET_INVALID_CALIBRATION;
+	bench.Store(CalibrationKey(), data);
+
+	if (!bench.Save(szCalFile))
+		return FRRET_INVALID_CALIBRATION;
+
+	return FRRET_SUCCESS;
+}
+
+
+/*******************************************************************************
+* Class      : FreqResp
+* Function   : UseMask()
+* Access     : public
+* Arguments  : szMaskFile = limit mask filename (nullptr or empty for none)
+*              bOrder     = measure the steps where the mask is tightest first
+* Returns    : FRRET result (see documentation for FRRET above)
+* Description:
+*   Checks every point measured from now on against the limit mask, counting
+*   the points outside it (see MaskFailures()); points already measured, such
+*   as those restored by Resume(), are checked immediately. The order is not
+*   changed while a checkpoint is recorded, since a checkpoint resumes from a
+*   frequency, nor once the sweep has started.
+*/
+FRRET FreqResp::UseMask(char const* szMaskFile, bool bOrder)
+{
+	if (!initialized)
+		return FRRET_NOT_INITIALIZED;
+
+	maskFailures = 0;
+	order.clear();
+
+	if (szMaskFile == nullptr || *szMaskFile == 0)
+	{
+		mask.reset();
+		return FRRET_SUCCESS;
+	}
+
+	mask.reset(new LimitMask());
+	if (!mask->Load(szMaskFile))
+	{
+		mask.reset();
+		return FRRET_INVALID_MASK;
+	}
+
+	for (auto const& point : data)
+	{
+		if (!mask->Check(point))
+			maskFailures = maskFailures + 1;
+	}
+
+	if (bOrder && !checkpoint->IsOpen() && iStep == 0)
+	{
+		vector<double> freqs;
+		for (auto const& step : *plan)
+			freqs.push_back(step.freq);
+
+		order = mask->Order(freqs);
+	}
+
+	return FRRET_SUCCESS;
+}
+
+
+/*******************************************************************************
+* Class      : FreqResp
+* Function   : MaskFailures()
+* Access     : public
+* Arguments  : none
+* Returns    : number of points of the sweep outside the limit mask
+* Description:
+*   Reports the pass/fail result of the sweep (0 = pass) when a mask is in use
+*/
+unsigned int FreqResp::MaskFailures() const
+{
+	return maskFailures;
+}
+
+/*******************************************************************************
+* Class      : FreqResp
+* Function   : UseFit()
+* Access     : public
+* Arguments  : _fit = orders of the model and the convergence tolerance
+*                     (nPoles 0 for no model)
+* Returns    : FRRET result (see documentation for FRRET above)
+* Description:
+*   Fits a rational model to the points as they are measured. Once the model
+*   has stopped changing the sweep is complete, and the remaining steps are
+*   not measured (see Model()). The steps are measured coarse to fine so the
+*   points fitted span the sweep, unless a checkpoint is recorded, a mask
+*   order is in use, or the sweep has started.
+*/
+FRRET FreqResp::UseFit(Fit_Config const& _fit)
+{
+	if (!initialized)
+		return FRRET_NOT_INITIALIZED;
+
+	fit.reset();
+
+	if (_fit.nPoles == 0)
+		return FRRET_SUCCESS;
+
+	if (_fit.nPoles > TransferFit::ORDER_MAX || _fit.nZeros > _fit.nPoles || !(_fit.tolerance > 0.0))
+		return FRRET_INVALID_FIT;
+
+	fit.reset(new TransferFit(_fit));
+
+	if (order.empty() && !checkpoint->IsOpen() && iStep == 0)
+		order = plan->CoarseToFine();
+
+	return FRRET_SUCCESS;
+}
+
+
+/*******************************************************************************
+* Class      : FreqResp
+* Function   : Model()
+* Access     : public
+* Arguments  : model = receives the last model fitted
+* Returns    : true if a model has been fitted
+* Description:
+*   Returns the model fitted to the sweep, with its coefficients, poles and
+*   zeros. model.converged tells whether the sweep ended on convergence.
+*/
+bool FreqResp::Model(FR_Model& model) const
+{
+	if (!fit || fit->Model().nPoints == 0)
+		return false;
+
+	model = fit->Model();
+	return true;
+}
+
+
+
+/*******************************************************************************
+* Class      : FreqResp
+* Function   : CalibrationKey()
+* Access     : private
+* Arguments  : none
+* Returns    : the setup a calibration table must match
+* Description:
+*   Returns the settings of the current setup that change the channel mismatch
+*/
+CalKey FreqResp::CalibrationKey() const
+{
+	return CalKey{ input, output, meas.ttMeas };
+}
+
+
+/*******************************************************************************
+* Class      : FreqResp
+* Function   : MeasureNext()
+* Access     : public
+* Arguments  : result = ref to FRS object to receive the freq measurement result
+* Returns    : FRRET result (see documentation for FRRET above)
+* Description:
+*   Performs one step of the frequency response measurement. Used when intermediate
+*   results are needed, for instance if updating a plot real-time. With a limit
+*   mask in use, a point outside it returns FRRET_MASK_FAIL (the sweep may be
+*   continued), except the last, which returns FRRET_COMPLETE (see
+*   MaskFailures()). With a mask order, the steps are measured in that order
+*   and the results are sorted by frequency once the sweep is complete. With
+*   a model fitted (see UseFit()), the sweep is complete once it converges.
+*/
+FRRET FreqResp::MeasureNext(FRS& result)
+{
+	FRRET nReturnVal = FRRET_SUCCESS;
+
+	if (!initialized)
+	{
+		nReturnVal = FRRET_NOT_INITIALIZED;
+	}
+	else if (completed)
+	{
+		nReturnVal = FRRET_COMPLETE;
+	}
+	else
+	{
+		FRS frs_result;
+
+		nReturnVal = MeasurePoint((*plan)[order.empty() ? iStep : order[iStep]], frs_result);
+
+		if (nReturnVal >= FRRET_SUCCESS)
+		{
+			result = frs_result;
+			data.push_back(frs_result);
+
+			// advance to the next step of the plan
+			iStep = iStep + 1;
+			completed = (iStep >= plan->Size());
+
+			// record the completed point and the frequency to resume from
+			if (checkpoint->IsOpen())
+				checkpoint->WritePoint(frs_result, plan->Frequency(iStep));
+
+			if (mask && !mask->Check(frs_result))
+			{
+				maskFailures = maskFailures + 1;
+				nReturnVal = FRRET_MASK_FAIL;
+			}
+
+			// the remaining steps are not needed once the model has converged
+			if (fit && fit->Update(data))
+				completed = true;
+
+			if (completed)
+			{
+				if (!order.empty())
+					sort(data.begin(), data.end(), [](FRS const& a, FRS const& b) { return a.freq < b.freq; });
+				nReturnVal = FRRET_COMPLETE;
+			}
+		}
+	}
+
+	return nReturnVal;
+}
+
+
+/*******************************************************************************
+* Class      : FreqResp
+* Function   : MeasurePoint()
+* Access     : private
+* Arguments  : step   = precomputed step to measure
+*              result = receives the measurement, corrected for the channel mismatch
+* Returns    : FRRET result (see documentation for FRRET above)
+* Description:
+*   Measures one step. A measurement made while a connection was lost is
+*   invalid: the instruments are reconnected, their configuration restored,
+*   and the step measured again.
+*/
+FRRET FreqResp::MeasurePoint(SweepStep const& step, FRS& result)
+{
+	FRRET nReturnVal = MeasureFreq(step, result);
+
+	for (int nRecover = 0; nReturnVal >= FRRET_SUCCESS && !IsConnected(); ++nRecover)
+	{
+		if (nRecover >= RECOVER_ATTEMPTS)
+			nReturnVal = FRRET_CONNECTION_LOST;
+		else
+			nReturnVal = Recover();
+
+		if (nReturnVal >= FRRET_SUCCESS)
+			nReturnVal = MeasureFreq(step, result);
+	}
+
+	// remove the channel mismatch
+	if (nReturnVal >= FRRET_SUCCESS && calTable != nullptr)
+		calTable->Correct(result);
+
+	return nReturnVal;
+}
+
+
+/*******************************************************************************
+* Class      : FreqResp
+* Function   : MeasureFreq()
+* Access     : private
+* Arguments  : step   = step of the sweep plan at which response will be measured
+*              result = ref to FRS object to receive the freq measurement result
+* Returns    : FRRET result (see documentation for FRRET above)
+* Description:
+*   Performs one step of the frequency response measurement. Once the scale
+*   has settled, further readings are averaged if meas.nAvgMax > 1, until the
+*   confidence intervals of the gain and phase are within the tolerances or
+*   nAvgMax readings have been taken. Quiet points stop at AVG_MIN_READINGS.
+*/
+FRRET FreqResp::MeasureFreq(SweepStep const& step, FRS& result)
+{
+	FRRET nReturnVal = FRRET_SUCCESS;
+	SweepCapture const& capture = step.capture[iCapture];
+
+	// set the timebase and memory depth (only what changed), and the test frequency
+	oscope->SetCapture(capture.tdiv, capture.mdepth);
+	stimulus->SendCommand(step.strFreqCommand);
+
+	// dwell here to allow the circuit transient response to stablize
+	Sleep(capture.dwell_msec); // milliseconds
+
+	bool bLoopDone = false;
+	int adjust_in = 0;
+	int adjust_out = 0;
+	double mag_in = 0.0, mag_out = 0.0, time_meas = 0.0;
+	double pkpk_in = 0.0, pkpk_out = 0.0;
+
+	// start each channel on the range remembered for this frequency, if any
+	autoInput->Begin(*oscope, osChannelInput, step.freq, vStim, osScaleInput);
+	autoOutput->Begin(*oscope, osChannelOutput, step.freq, vStim, osScaleOutput);
+
+	int scale_count = 0;
+	int level_count = 0;
+	do
+	{
+		// get the measurements and do an auto-scale step for input and output
+		mag_in = avMeasure * MeasureAndScaleInput(*oscope, osChannelInput, mpMeasure, *autoInput, vStim, osScaleInput, adjust_in, pkpk_in);
+		mag_out = avMeasure * MeasureAndScaleInput(*oscope, osChannelOutput, mpMeasure, *autoOutput, vStim, osScaleOutput, adjust_out, pkpk_out);
+
+		// stimulus leveling: bring an output that is not clipped back into its
+		// window first, then let the stimulus settle and scale to it
+		if (level_count < LEVEL_ADJUST_MAX && adjust_out <= 0 && Level(mag_out / avMeasure))
+		{
+			level_count = level_count + 1;
+			scale_count = 0;
+			adjust_in = 0;
+			adjust_out = 0;
+			Sleep(capture.dwell_msec);
+			continue;
+		}
+
+		if (adjust_in != 0 || adjust_out != 0)
+			scale_count = scale_count + 1;
+
+		if ((adjust_in == 0 && adjust_out == 0) || scale_count >= SCALE_ADJUST_MAX)
+		{	// both ranges have settled (or a clipped signal ran out of adjustments)...
+			// either way, measure phase|delay and exit the loop
+			time_meas = MeasureTime();
+			bLoopDone = true;
+		}
+
+	} while (!bLoopDone);
+
+	// choose the capture length for the next point from the noise seen at this one
+	const double noise_in = NoiseRatio(mag_in / avMeasure, pkpk_in);
+	const double noise_out = NoiseRatio(mag_out / avMeasure, pkpk_out);
+	AdaptCapture((noise_in > noise_out) ? noise_in : noise_out);
+
+	// averaging; phase readings are unwrapped around the first one so a phase
+	// near +/-180 degrees does not average to 0
+	RunningStats statIn, statOut, statGain, statTime;
+	const double time_first = time_meas;
+	const unsigned int nMax = (meas.nAvgMax > 1) ? meas.nAvgMax : 1;
+	const double tolTime = (tunit == TUNIT::PHASE) ? meas.tolPhase_deg : meas.tolPhase_deg / (360.0 * step.freq);
+	const unsigned long msecCapture = (unsigned long)ceil(1000.0 * capture.tcapture);
+	const unsigned long msecReading = (msecCapture > AVG_MIN_INTERVAL_MSEC) ? msecCapture : AVG_MIN_INTERVAL_MSEC;
+
+	for (;;)
+	{
+		if (tunit == TUNIT::PHASE)
+		{
+			if (time_meas - time_first > 180.0)
+				time_meas -= 360.0;
+			else if (time_meas - time_first < -180.0)
+				time_meas += 360.0;
+		}
+
+		statIn.Add(mag_in);
+		statOut.Add(mag_out);
+		statGain.Add(20.0 * log10(abs(mag_out / mag_in)));
+		statTime.Add(time_meas);
+
+		const unsigned int n = statGain.Count();
+		if (n >= nMax)
+			break;
+		if (n >= AVG_MIN_READINGS
+			&& ConfidenceHalfWidth(statGain.StdDev(), n) <= meas.tolGain_dB
+			&& ConfidenceHalfWidth(statTime.StdDev(), n) <= tolTime)
+			break;
+
+		// wait for a new acquisition, then take the next reading at the settled scale
+		Sleep(msecReading);
+		MeasureReading(mag_in, mag_out, time_meas);
+	}
+
+	double time_mean = statTime.Mean();
+	if (tunit == TUNIT::PHASE)
+	{
+		if (time_mean > 180.0)
+			time_mean -= 360.0;
+		else if (time_mean <= -180.0)
+			time_mean += 360.0;
+	}
+
+	const double mag_gain = abs(statOut.Mean() / statIn.Mean());
+	const double dB_gain = 20.0 * log10(mag_gain);
+	
+	result.freq = step.freq;
+	result.mag_in = statIn.Mean();
+	result.mag_out = statOut.Mean();
+	result.dBgain = dB_gain;
+	result.time = time_mean;
+	result.tunit = tunit;
+	result.sd_dBgain = statGain.StdDev();
+	result.sd_time = statTime.StdDev();
+	result.count = statGain.Count();
+	result.vstim = vStim;
+
+	AnalyzeHarmonics(step.freq, result);
+
+	return nReturnVal;
+}
+
+
+/*******************************************************************************
+* Class      : FreqResp
+* Function   : MeasureTime()
+* Access     : private
+* Arguments  : none
+* Returns    : phase (degrees) or delay (seconds) of the output relative to the input
+* Description:
+*   Measures phase or delay, as selected by the measurement configuration
+*/
+double FreqResp::MeasureTime()
+{
+	if (meas.ttMeas == Ttype_t::DELAY)
+		return oscope->MeasureDelay(osChannelInput, osChannelOutput, measEdge);
+	else
+		return oscope->MeasureDelay(osChannelInput, osChannelOutput, ScopeDriver::MeasDelParam::PHA);
+}
+
+
+/*******************************************************************************
+* Class      : FreqResp
+* Function   : MeasureReading()
+* Access     : private
+* Arguments  : mag_in    = receives the input amplitude
+*              mag_out   = receives the output amplitude
+*              time_meas = receives the phase (degrees) or delay (seconds)
+* Returns    : none
+* Description:
+*   Takes one reading of a point at the settled scales, by the fastest way
+*   the oscilloscope model supports: with CAP_MULTI_QUERY the three
+*   measurements are read in one transmission, otherwise one at a time.
+*/
+void FreqResp::MeasureReading(double& mag_in, double& mag_out, double& time_meas)
+{
+	if (oscope->Supports(CAP_MULTI_QUERY))
+	{
+		ScopeDriver::FrameMeas reading;
+		const ScopeDriver::MeasDelParam delParam = (meas.ttMeas == Ttype_t::DELAY) ? measEdge : ScopeDriver::MeasDelParam::PHA;
+
+		oscope->MeasureSet(osChannelInput, osChannelOutput, mpMeasure, delParam, reading);
+		mag_in = avMeasure * reading.in;
+		mag_out = avMeasure * reading.out;
+		time_meas = reading.delay;
+	}
 	else
-		adjust = 0;
+	{
+		mag_in = avMeasure * oscope->Measure(osChannelInput, mpMeasure);
+		mag_out = avMeasure * oscope->Measure(osChannelOutput, mpMeasure);
+		time_meas = MeasureTime();
+	}
+}
+
+/*******************************************************************************
+* Class      : FreqResp
+* Function   : AnalyzeHarmonics()
+* Access     : private
+* Arguments  : f      = frequency of the point
+*              result = receives the harmonics, THD and THD+N of the output
+* Returns    : none
+* Description:
+*   Reads back the output waveform of the last capture of the point and
+*   analyzes its distortion on the host (see HarmonicAnalysis.h). Nothing is
+*   captured again, so this costs only the transfer of the waveform. The
+*   fields are NaN if the analysis was not requested, the oscilloscope model
+*   cannot read waveforms, or the capture is too short or too slow for it.
+*/
+void FreqResp::AnalyzeHarmonics(double f, FRS& result)
+{
+	const double NaN = numeric_limits<double>::quiet_NaN();
+	double amplitude[HarmonicAnalysis::N_HARMONICS] = { NaN, NaN, NaN, NaN, NaN };
+	double thd = NaN;
+	double thdn = NaN;
+
+	result.is_harmonics = meas.is_harmonics;
+
+	if (meas.is_harmonics && oscope->Supports(CAP_BINARY_WAVEFORM))
+	{
+		vector<double> volts;
+		double tSample = 0.0;
+
+		if (oscope->ReadWaveform(osChannelOutput, HARMONIC_POINTS_MAX, volts, tSample))
+			HarmonicAnalysis::Analyze(volts, tSample, f, amplitude, thd, thdn);
+	}
+
+	result.fund = amplitude[0];
+	result.h2 = amplitude[1];
+	result.h3 = amplitude[2];
+	result.h4 = amplitude[3];
+	result.h5 = amplitude[4];
+	result.thd = thd;
+	result.thdn = thdn;
+}
+
+
+
+/*******************************************************************************
+* Class      : FreqResp
+* Function   : ConfidenceHalfWidth()
+* Access     : private static
+* Arguments  : sd = standard deviation of the readings
+*              n  = number of readings
+* Returns    : half-width of the 95% confidence interval of the mean
+* Description:
+*   Uses Student's t for the few readings typical of averaging at one point
+*/
+double FreqResp::ConfidenceHalfWidth(double sd, unsigned int n)
+{
+	// two-sided 95% t values for 1 to 30 degrees of freedom
+	static const double t95[] =
+	{
+		12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+		2.201, 2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+		2.080, 2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042
+	};
+	const unsigned int nT95 = sizeof(t95) / sizeof(t95[0]);
+
+	if (n < 2)
+		return numeric_limits<double>::infinity();
+
+	const double t = (n - 1 <= nT95) ? t95[n - 2] : 1.960;
+	return t * sd / sqrt(double(n));
+}
+
+
+/*******************************************************************************
+* Class      : FreqResp
+* Function   : NoiseRatio()
+* Access     : private static
+* Arguments  : ampl = amplitude (AMPL) of a channel
+*              pkpk = peak-to-peak (PKPK) of the same channel
+* Returns    : noise relative to the amplitude, 0 for a clean sine
+* Description:
+*   Estimates the noise on a channel from readings already taken: AMPL comes
+*   from the histogram top and base, which noise hardly moves, while PKPK
+*   includes the noise peaks. An unusable reading counts as very noisy.
+*/
+double FreqResp::NoiseRatio(double ampl, double pkpk)
+{
+	if (!(ampl > 0.0) || isnan(pkpk))
+		return numeric_limits<double>::infinity();
+
+	const double noise = (pkpk - ampl) / ampl;
+	return (noise > 0.0) ? noise : 0.0;
+}
+
+
+/*******************************************************************************
+* Class      : FreqResp
+* Function   : AdaptCapture()
+* Access     : private
+* Arguments  : noise = noise ratio measured at the current point (see NoiseRatio)
+* Returns    : none
+* Description:
+*   Chooses the capture length for the next point. A clean signal halves the
+*   number of cycles captured, down to the least the measurement type needs,
+*   so low frequencies capture no longer than necessary; a noisy one doubles
+*   it so the amplitude and phase are estimated over more cycles. Between
+*   NOISE_LOW and NOISE_HIGH the capture length is kept.
+*/
+void FreqResp::AdaptCapture(double noise)
+{
+	if (noise > NOISE_HIGH)
+	{
+		if (iCapture + 1 < SWEEP_CAPTURE_LEVELS)
+			++iCapture;
+	}
+	else if (noise < NOISE_LOW)
+	{
+		if (iCapture > iCaptureMin)
+			--iCapture;
+	}
+
+	if (iCapture < iCaptureMin)
+		iCapture = iCaptureMin;
+}
+
+
+/*******************************************************************************
+* Class      : FreqResp
+* Function   : operator FRST const&
+* Access     : public
+* Arguments  : none
+* Returns    : reference to FRST object
+* Description:
+*   FRST conversion operator. Used to obtain the frequency response results.
+*/
+FreqResp::operator FRST const& () const
+{
+	return data;
+}
+
+
+/*******************************************************************************
+* Class      : FreqResp
+* Function   : Plan()
+* Access     : public
+* Arguments  : none
+* Returns    : reference to the sweep plan
+* Description:
+*   The steps precomputed by Init(). Use to inspect the sweep or estimate its
+*   duration; Sweep() executes the same plan each time it is called.
+*/
+SweepPlan const& FreqResp::Plan() const
+{
+	return *plan;
+}
+
+
+/*******************************************************************************
+* Class      : FreqResp
+* Function   : IsOrdered()
+* Access     : public
+* Arguments  : none
+* Returns    : true if the steps are measured out of plan order
+* Description:
+*   Reports whether MeasureNext() returns the points in a mask order or coarse
+*   to fine (see UseMask() and UseFit()) rather than in frequency order. The
+*   results are sorted by frequency once the sweep is complete.
+*/
+bool FreqResp::IsOrdered() const
+{
+	return !order.empty();
+}
+
+
+/*******************************************************************************
+* Function   : MeasureAndScaleInput()
+* Arguments  : scope     = reference to oscilloscope driver
+*              ch        = oscilloscope channel
+*              mpMeasure = type of measurement parameter to return
+*              autoscale = range choice of the channel (see AutoScale)
+*              vStim     = stimulus amplitude (Vpp), for the ranges remembered
+*              scale     = reference to scale structure, holds scale info on return
+*              adjust    = reference, receives the direction the range was changed
+*              mag_pkpk  = reference, receives the peak-to-peak value on return
+* Returns    : measurement value; scale, adjust and mag_pkpk references receive data on return
+* Description:
+*   This function implements channel measurement and auto-scaling adjustment.
+*   On exit, adjust is +1 or -1 if the vertical range was raised or lowered,
+*   or 0 if the range has settled. Call this function repeatedly until the
+*   adjust parameter is 0.
+*   The return value is the actual measurement.
+*/
+double FreqResp::MeasureAndScaleInput(ScopeDriver& scope, ScopeDriver::Channel ch, ScopeDriver::MeasParam mpMeasure, AutoScale& autoscale, double vStim, ScopeDriver::ScaleValues& scale, int& adjust, double& mag_pkpk)
+{
+	// get the measurements
+	const double mag = scope.Measure(ch, mpMeasure);
+	mag_pkpk = (mpMeasure == ScopeDriver::MeasParam::PKPK) ? mag : scope.Measure(ch, ScopeDriver::MeasParam::PKPK);
+
+	adjust = autoscale.Step(scope, ch, mag_pkpk, vStim, scale);
 
 	return mag;
 }
@@ -6,19 +6,23 @@
 * Class      : FreqResp
 * Description:
 *   FreqResp is a class that implements frequency response measurement either
-*   as a full sweep, or as a series of calls or each frequency step.
+*   as a full sweep, or as a series of calls or each frequency step, or as a
+*   search converging on characteristics of the response (the bandwidth
+*   corner, the peak, and the unity gain crossover) in a few points.
 *
 *   Implements a measurement of frequency response using a Rigol function
 *   generator and a Siglent oscilloscope.
 *
 * Created    : 05/26/2020
-* Modified   : 01/01/2023
+* Modified   : 10/16/2026
 * Author     : Kerry S. Martin, martin@wild-wood.net
 *******************************************************************************/
 #pragma once
-#include "Oscilloscope.h"
-#include "SineGenerator.h"
+#include "ScopeDriver.h"
+#include "GeneratorDriver.h"
+#include <complex>
 #include <vector>
+#include <memory>
 
 enum class Sweep_t { LOG, LIN };
 enum class Vtype_t { VPP, VPK };
@@ -26,11 +30,21 @@ enum class Ttype_t { PHASE, DELAY };
 enum class Ctype_t { DC, AC };
 enum class Etype_t { RISE, FALL };
 enum class TUNIT { PHASE, DELAY };
+enum class Fail_t { CONTINUE, NEXT, ABORT };
 
 struct File_Config
 {
 	bool is_echo;
 	std::string filename;
+	std::string checkpoint;		// checkpoint filename (empty for none)
+	bool is_resume;				// resume the sweep recorded in the checkpoint
+	std::string binfilename;	// binary columnar results filename (empty for none)
+	std::string shmname;		// shared memory ring to publish the results to (empty for none)
+	std::string calfile;		// bench calibration filename (empty for none)
+	bool is_calibrate;			// measure the calibration (a through sweep) into calfile
+	std::string maskfile;		// gain/phase limit mask filename (empty for none)
+	Fail_t onfail;				// on the first point outside the mask: finish the sweep, stop it, or stop the batch
+	bool is_mask_order;			// measure the frequencies where the mask is tightest first
 };
 
 
@@ -48,6 +62,8 @@ struct Stim_Config
 	Vtype_t vtStim;
 	double vstim;
 	double vdc;
+	double vlevel;		// leveling: output amplitude held (Vpp, NaN = no leveling)
+	double vmax;		// leveling: largest stimulus amplitude (Vpp)
 };
 
 struct Channel_Config
@@ -66,10 +82,66 @@ struct Trig_Config
 	double vTrig;
 };
 
+// rational model of the response, fitted while sweeping (see TransferFit.h)
+struct Fit_Config
+{
+	unsigned int nPoles;		// order of the denominator (0 = no fit)
+	unsigned int nZeros;		// order of the numerator
+	double tolerance;			// sweep ends once the poles, zeros and gain move less than this ratio (ex/ 0.01)
+};
+
 struct Meas_Config
 {
 	Vtype_t vtMeas;
 	Ttype_t ttMeas;
+	unsigned int nAvgMax;	// most readings averaged at each point (1 = a single reading)
+	double tolGain_dB;		// averaging stops once the 95% confidence intervals of the gain
+	double tolPhase_deg;	// and phase (or the delay, as a phase) are within +/- these
+	bool is_hwsweep;		// sweep with the generator's stepped sweep and scope segments
+	bool is_harmonics;		// analyze the harmonics of the output at each point (CAP_BINARY_WAVEFORM)
+	unsigned int search;	// characteristics to search for instead of sweeping (Search_t flags)
+	Fit_Config fit;			// rational model to fit while sweeping (nPoles 0 = none)
+};
+
+// characteristics of the response found by FreqResp::Search() (bit flags)
+enum Search_t : unsigned int
+{
+	SEARCH_NONE = 0x00,
+	SEARCH_BANDWIDTH = 0x01,	// corner where the gain first falls dBcorner below the gain at fStart
+	SEARCH_PEAK = 0x02,			// largest gain, between fStart and fStop
+	SEARCH_CROSSOVER = 0x04		// first fall through unity gain, and the phase margin there
+};
+
+struct Search_Config
+{
+	unsigned int features;		// Search_t flags
+	double dBcorner;			// gain of the bandwidth corner relative to the gain at fStart (ex/ -3.0)
+	double fTolerance;			// search ends once the bracket is within this ratio of frequency (ex/ 0.01)
+	unsigned int nPointsMax;	// most points measured, the coarse grid included
+};
+
+// characteristics found by a search (NaN if not searched for or not found)
+struct FR_Characteristics
+{
+	double fCorner;			// bandwidth corner (Hz)
+	double dBref;			// gain at fStart the corner is relative to (dB)
+	double fPeak;			// frequency of the largest gain (Hz)
+	double dBpeak;			// largest gain (dB)
+	double fCrossover;		// unity gain crossover (Hz)
+	double phaseMargin;		// 180 deg plus the phase at the crossover (deg)
+};
+
+// fitted model H(s) = num(s)/den(s), s in rad/s, coefficients in ascending powers of s
+struct FR_Model
+{
+	std::vector<double> num;
+	std::vector<double> den;					// den[0] = 1
+	std::vector<std::complex<double>> zeros;	// rad/s
+	std::vector<std::complex<double>> poles;
+	double rms_dB;			// fit error over the points measured
+	double rms_deg;
+	unsigned int nPoints;	// points fitted
+	bool converged;			// the model stopped changing before the end of the sweep
 };
 
 struct Dwell_Config
@@ -87,6 +159,18 @@ public:
 	double dBgain;
 	double time;
 	TUNIT tunit;
+	double sd_dBgain;		// standard deviation of the averaged readings (0 for one reading)
+	double sd_time;
+	unsigned int count;		// number of readings averaged
+	double vstim;			// stimulus amplitude the point was measured with (Vpp)
+	bool is_harmonics;		// the harmonics of the output were analyzed
+	double fund;			// output amplitude of the fundamental, and of harmonics 2 to 5 (V peak; NaN if the analysis failed)
+	double h2;
+	double h3;
+	double h4;
+	double h5;
+	double thd;				// THD and THD+N of the output (ratio to the fundamental; NaN if the analysis failed)
+	double thdn;
 };
 
 typedef std::vector<FRS> FRST;
@@ -95,6 +179,8 @@ typedef std::vector<FRS> FRST;
 typedef signed int FRRET;
 constexpr auto FRRET_SUCCESS = 0;
 constexpr auto FRRET_COMPLETE = 1;
+constexpr auto FRRET_CAL_EXTRAPOLATED = 2;		// calibration in use, but the sweep extends beyond its range
+constexpr auto FRRET_MASK_FAIL = 3;				// point measured, but outside the limit mask
 constexpr auto FRRET_NOT_INITIALIZED = -1;
 constexpr auto FRRET_ALREADY_INITIALIZED = -2;
 constexpr auto FRRET_INVALID_FREQUENCY = -3;
@@ -102,6 +188,23 @@ constexpr auto FRRET_INVALID_STIM = -4;
 constexpr auto FRRET_INVALID_TRIG = -5;
 constexpr auto FRRET_INIT_OSCILLOSCOPE = -10;
 constexpr auto FRRET_INIT_SINEGEN = -11;
+constexpr auto FRRET_CONNECTION_LOST = -12;
+constexpr auto FRRET_INVALID_CHECKPOINT = -13;
+constexpr auto FRRET_HW_SWEEP = -14;			// hardware sweep not possible for this sweep, or failed
+constexpr auto FRRET_INVALID_CALIBRATION = -15;
+constexpr auto FRRET_NO_CALIBRATION = -16;		// calibration file has no table for this setup
+constexpr auto FRRET_INVALID_MASK = -17;
+constexpr auto FRRET_INVALID_FIT = -18;
+
+class AutoScale;
+class SweepCheckpoint;
+class ChannelCal;
+class CalTable;
+class LimitMask;
+class TransferFit;
+struct CalKey;
+class SweepPlan;
+struct SweepStep;
 
 
 class FreqResp
@@ -114,10 +217,33 @@ public:
 	operator FRST const& () const;
 
 	FRRET Init(char const* szOscope, char const* szSigGen, Freq_Config const& freq, Stim_Config const& stim, Channel_Config const& input, Channel_Config const& output, Trig_Config const& trig, Meas_Config const& meas, Dwell_Config const& dwell);
+	FRRET Reconfigure(Freq_Config const& freq, Stim_Config const& stim, Channel_Config const& input, Channel_Config const& output, Trig_Config const& trig, Meas_Config const& meas, Dwell_Config const& dwell);
 	FRRET MeasureNext(FRS& result);
 	FRRET Sweep();
+	FRRET HardwareSweep();
+	FRRET Search(Search_Config const& search, FR_Characteristics& found);
 	FRRET Close();
 
+	// checkpointing of sweep progress (call after Init)
+	FRRET Checkpoint(char const* szCheckpoint);
+	FRRET Resume(char const* szCheckpoint);
+
+	// channel mismatch calibration (call after Init)
+	FRRET UseCalibration(char const* szCalFile);
+	FRRET SaveCalibration(char const* szCalFile);
+
+	// pass/fail limit mask (call after Init, and after Resume)
+	FRRET UseMask(char const* szMaskFile, bool bOrder);
+	unsigned int MaskFailures() const;
+
+	// rational model fitted while sweeping (call after Init, and after Checkpoint)
+	FRRET UseFit(Fit_Config const& fit);
+	bool Model(FR_Model& model) const;
+
+	// the precomputed steps of the sweep (built by Init, reused by Sweep)
+	SweepPlan const& Plan() const;
+	bool IsOrdered() const;
+
 private:
 	// status indicators
 	bool initialized;
@@ -125,6 +251,14 @@ private:
 
 	// frequency response data
 	FRST data;
+	std::unique_ptr<SweepCheckpoint> checkpoint;
+	std::unique_ptr<SweepPlan> plan;
+	std::unique_ptr<ChannelCal> cal;
+	CalTable const* calTable;		// table of cal for the current setup, nullptr if none
+	std::unique_ptr<LimitMask> mask;
+	unsigned int maskFailures;		// points of the sweep outside the mask
+	std::vector<size_t> order;		// plan steps in the order measured (empty for plan order)
+	std::unique_ptr<TransferFit> fit;
 
 	// parameters supplied to init
 	Freq_Config freq;
@@ -135,35 +269,73 @@ private:
 	Meas_Config meas;
 	Dwell_Config dwell;
 
-	// instruments
-	SineGenerator stimulus;
-	Oscilloscope oscope;
+	// instruments (drivers chosen for the attached models)
+	std::unique_ptr<GeneratorDriver> stimulus;
+	std::unique_ptr<ScopeDriver> oscope;
 
 	// algorithm variables
-	double f;
-	SineGenerator::Channel sgChannel;
-	Oscilloscope::Channel osChannelInput;
-	Oscilloscope::Channel osChannelOutput;
-	Oscilloscope::Channel osChannelTrig;
-	Oscilloscope::MeasParam mpMeasure;
-	Oscilloscope::MeasDelParam measEdge;
+	size_t iStep;
+	size_t iCapture;		// capture level (SweepPlan::CAPTURE_CYCLES) used for the next point
+	size_t iCaptureMin;		// shortest capture level usable for the measurement type
+	GeneratorDriver::Channel sgChannel;
+	ScopeDriver::Channel osChannelInput;
+	ScopeDriver::Channel osChannelOutput;
+	ScopeDriver::Channel osChannelTrig;
+	ScopeDriver::MeasParam mpMeasure;
+	ScopeDriver::MeasDelParam measEdge;
 	double avMeasure;
 	double vStim;
 	TUNIT tunit;
-	Oscilloscope::ScaleValues osScaleOutput;
-	Oscilloscope::ScaleValues osScaleInput;
+	ScopeDriver::ScaleValues osScaleOutput;
+	ScopeDriver::ScaleValues osScaleInput;
+	std::unique_ptr<AutoScale> autoOutput;		// vertical range choice of each channel
+	std::unique_ptr<AutoScale> autoInput;
 
 	// constant settings
-	static const double SEEK_MAX;
-	static const double SEEK_MID;
-	static const double SEEK_MIN;
-	static const double SEEK_MARGIN;
-	static const double FREQ_FUDGE;
-	static const double MEAS_CYCLES;
+	static const int SCALE_ADJUST_MAX;
+	static const int RECOVER_ATTEMPTS;
+	static const unsigned int AVG_MIN_READINGS;
+	static const unsigned long AVG_MIN_INTERVAL_MSEC;
+	static const double NOISE_LOW;
+	static const double NOISE_HIGH;
+	static const double HW_MARGIN_SEC;
+	static const double HW_TIMEOUT_SEC;
+	static const double SEARCH_POINTS_PER_DECADE;
+	static const double SEARCH_GOLDEN;
+	static const double LEVEL_WINDOW;
+	static const double LEVEL_MIN_VPP;
+	static const int LEVEL_ADJUST_MAX;
+	static const unsigned int HARMONIC_POINTS_MAX;
 
 private:
-	FRRET MeasureFreq(double f, FRS& result);
-	static double MeasureAndScaleInput(Oscilloscope& oscope, Oscilloscope::Channel ch, Oscilloscope::MeasParam mpMeasure, Oscilloscope::ScaleValues& scale, int& adjust);
+	void ConfigureStimulus(double fStim, bool bRestore = false);
+	double StimulusVpp() const;
+	bool Level(double vOut);
+	void ConfigureOscilloscope();
+	void ConfigureChannel(ScopeDriver::Channel ch, Channel_Config const& config);
+	void ConfigureTrigger(double tHoldoff = 0.0);
+	void ConfigureMeasurement();
+	static ScopeDriver::Channel GetOscChannel(int ch, ScopeDriver::Channel chDefault);
+	static FRRET Validate(Freq_Config const& freq, Stim_Config const& stim, Trig_Config const& trig);
+	static bool SameConfig(Stim_Config const& a, Stim_Config const& b);
+	static bool SameConfig(Channel_Config const& a, Channel_Config const& b);
+	static bool SameConfig(Trig_Config const& a, Trig_Config const& b);
+	bool IsConnected() const;
+	CalKey CalibrationKey() const;
+	FRRET Recover();
+	FRRET MeasurePoint(SweepStep const& step, FRS& result);
+	FRRET MeasureFreq(SweepStep const& step, FRS& result);
+	FRRET MeasureSearch(double f, FRS& result);
+	FRRET BisectFall(double dBtarget, Search_Config const& search, FRS& above, FRS& below);
+	static double InterpolateFall(double dBtarget, FRS const& above, FRS const& below, double& phase);
+	static double PointPhase(FRS const& point);
+	double MeasureTime();
+	void MeasureReading(double& mag_in, double& mag_out, double& time_meas);
+	void AnalyzeHarmonics(double f, FRS& result);
+	static double ConfidenceHalfWidth(double sd, unsigned int n);
+	void AdaptCapture(double noise);
+	static double NoiseRatio(double ampl, double pkpk);
+	static double MeasureAndScaleInput(ScopeDriver& scope, ScopeDriver::Channel ch, ScopeDriver::MeasParam mpMeasure, AutoScale& autoscale, double vStim, ScopeDriver::ScaleValues& scale, int& adjust, double& mag_pkpk);
 };
 
 
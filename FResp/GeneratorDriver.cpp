@@ -0,0 +1,174 @@
+/*******************************************************************************
+* Copyright  2026 Kerry S. Martin, martin@wild-wood.net
+* Free for usage without warranty, expressed or implied; attribution required
+*
+* Filename   : GeneratorDriver.cpp
+* Class      : GeneratorDriver
+* Description:
+*   GeneratorDriver is the interface FreqResp uses to control a signal
+*   generator, and the table of the supported models and their drivers.
+*
+* Created    : 10/16/2026
+* Modified   : 10/16/2026
+* Author     : Kerry S. Martin, martin@wild-wood.net
+*******************************************************************************/
+
+#include "GeneratorDriver.h"
+#include "SineGenerator.h"
+#include "Socket_Instrument.h"
+
+using namespace std;
+
+// driver constructors for the model table
+static GeneratorDriver* CreateRigolDG() { return new SineGenerator(); }
+
+
+/*******************************************************************************
+* Class      : GeneratorDriver
+* Member     : GeneratorModels table
+* Access     : private static constant
+* Arguments  : n/a
+* Returns    : n/a
+* Description:
+*   Supported models, matched in order against the *IDN? manufacturer
+*   (pattern found) and model (pattern matches all of it). The last entry
+*   matches any instrument.
+*/
+const GeneratorDriver::GeneratorModel GeneratorDriver::GeneratorModels[]
+{
+	// Rigol DG800 and DG900 (one command set)
+	{ "rigol",   "DG[89][0-9]{2}.*",	CAP_MULTI_QUERY | CAP_NATIVE_SWEEP,	CreateRigolDG },
+
+	// any other model: the DG800 commands, with no optional capabilities
+	{ "",        ".*",					CAP_NONE,							CreateRigolDG }
+};
+
+
+/*******************************************************************************
+* Class      : GeneratorDriver
+* Member     : nGeneratorModels constant
+* Access     : private static constant
+* Arguments  : n/a
+* Returns    : n/a
+* Description:
+*   Number of entries in the GeneratorModels[] table
+*/
+const unsigned int GeneratorDriver::nGeneratorModels{ sizeof(GeneratorModels) / sizeof(GeneratorModel) };
+
+
+/*******************************************************************************
+* Class      : GeneratorDriver
+* Function   : GeneratorDriver() constructor
+* Access     : public
+* Arguments  : none
+* Returns    : none
+* Description:
+*   Constructs a driver with no identification and no optional capabilities.
+*   Open() sets them from the model table.
+*/
+GeneratorDriver::GeneratorDriver() : ident(), caps(CAP_NONE)
+{
+}
+
+
+/*******************************************************************************
+* Class      : GeneratorDriver
+* Function   : Open()
+* Access     : public static
+* Arguments  : resource = resource name string for instrument (ex/ "192.168.0.197:5555")
+* Returns    : the attached driver, or nullptr if the instrument could not be
+*              attached
+* Description:
+*   Connects to the signal generator at resource, identifies it on that
+*   connection, and creates the driver of its model, which takes over the
+*   connection. An instrument that does not answer *IDN?, or whose answer
+*   cannot be parsed, gets the driver of the last entry (no optional
+*   capabilities).
+*/
+std::unique_ptr<GeneratorDriver> GeneratorDriver::Open(std::string resource)
+{
+	Socket_Instrument connection;
+	vector<string> responses;
+	InstrumentIdent id;
+
+	if (!connection.Attach(resource))
+		return nullptr;
+
+	// the response is read up to its newline, however it is split between receives
+	if (!connection.QueryBatch({ "*IDN?" }, responses) || !id.Parse(responses[0]))
+	{
+		id = InstrumentIdent();
+
+		// an unanswered query leaves the connection unusable (see QueryBatch())
+		if (!connection.IsConnected() && !connection.Reconnect())
+			return nullptr;
+	}
+
+	for (unsigned int i = 0; i < nGeneratorModels; ++i)
+	{
+		if (id.Matches(GeneratorModels[i].manufacturer, GeneratorModels[i].model))
+		{
+			unique_ptr<GeneratorDriver> driver(GeneratorModels[i].create());
+			driver->ident = id;
+			driver->caps = GeneratorModels[i].caps;
+
+			if (!driver->Attach(connection))
+				driver.reset();
+
+			return driver;
+		}
+	}
+
+	return nullptr;
+}
+
+
+/*******************************************************************************
+* Class      : GeneratorDriver
+* Function   : Ident()
+* Access     : public
+* Arguments  : none
+* Returns    : identification of the attached model
+* Description:
+*   Returns the *IDN? fields read by Open()
+*/
+InstrumentIdent const& GeneratorDriver::Ident() const
+{
+	return ident;
+}
+
+
+/*******************************************************************************
+* Class      : GeneratorDriver
+* Function   : Caps()
+* Access     : public
+* Arguments  : none
+* Returns    : capabilities of the attached model (InstrCap flags)
+* Description:
+*   Returns the optional capabilities of the model
+*/
+unsigned int GeneratorDriver::Caps() const
+{
+	return caps;
+}
+
+
+/*******************************************************************************
+* Class      : GeneratorDriver
+* Function   : Supports()
+* Access     : public
+* Arguments  : cap = InstrCap flag(s)
+* Returns    : true if the model has every capability in cap
+* Description:
+*   Tests for optional capabilities of the model
+*/
+bool GeneratorDriver::Supports(unsigned int cap) const
+{
+	return (caps & cap) == cap;
+}
+
+
+/*******************************************************************************
+* Copyright  2026 Kerry S. Martin, martin@wild-wood.net
+* Free for usage without warranty, expressed or implied; attribution required
+*******************************************************************************/
\ No newline at end of file
@@ -0,0 +1,81 @@
+/*******************************************************************************
+* Copyright  2026 Kerry S. Martin, martin@wild-wood.net
+* Free for usage without warranty, expressed or implied; attribution required
+*
+* Filename   : GeneratorDriver.h
+* Class      : GeneratorDriver
+* Description:
+*   GeneratorDriver is the interface FreqResp uses to control a signal
+*   generator. Each supported model has a driver implementing it
+*   (SineGenerator is the driver for the Rigol DG800 and DG900).
+*
+*   Open() connects to the instrument once, reads its *IDN? on that
+*   connection, and creates the driver of the first matching entry of the
+*   model table, with the capabilities of that model (see InstrumentModel.h),
+*   which takes over the connection. A model that is not in the table, or
+*   that does not identify itself, is driven by the last entry.
+*
+* Created    : 10/16/2026
+* Modified   : 10/16/2026
+* Author     : Kerry S. Martin, martin@wild-wood.net
+*******************************************************************************/
+#pragma once
+#include "InstrumentModel.h"
+#include <memory>
+#include <string>
+
+class Socket_Instrument;
+
+class GeneratorDriver
+{
+public:
+	GeneratorDriver();
+	virtual ~GeneratorDriver() {}
+
+	// creates and attaches the driver for the model at resource (nullptr on failure)
+	static std::unique_ptr<GeneratorDriver> Open(std::string resource);
+
+	// model identification and capabilities
+	InstrumentIdent const& Ident() const;
+	unsigned int Caps() const;
+	bool Supports(unsigned int cap) const;
+
+	enum class Channel { CH1, CH2 };
+
+	// connection to an instrument
+	virtual bool Attach(std::string resource) = 0;
+	virtual bool Attach(Socket_Instrument& connection) = 0;		// takes over a connection (see Open())
+	virtual bool Detach() = 0;
+	virtual bool Reconnect() = 0;
+	virtual bool IsConnected() const = 0;
+
+	// channel configuration (NaN = no change)
+	virtual bool SetChannel(Channel ch, double freq, double Vpp, double Voffs, double phase) = 0;
+	virtual bool SetChannelFreq(Channel ch, double freq) = 0;
+	virtual bool SetChannelOutput(Channel ch, bool output) = 0;
+
+	// native stepped frequency sweep (CAP_NATIVE_SWEEP)
+	virtual bool SetStepSweep(Channel ch, double fStart, double fStop, unsigned int nSteps, double tSweep) = 0;
+	virtual bool TriggerSweep(Channel ch) = 0;
+	virtual bool StopSweep(Channel ch) = 0;
+	virtual unsigned int SweepStepsMax() const = 0;
+
+	// commands prepared in advance and sent later
+	virtual std::string FormatChannelFreq(Channel ch, double freq) const = 0;
+	virtual bool SendCommand(std::string const& command) = 0;
+
+protected:
+	InstrumentIdent ident;
+	unsigned int caps;
+
+private:
+	struct GeneratorModel { char const* manufacturer; char const* model; unsigned int caps; GeneratorDriver* (*create)(); };
+	static const GeneratorModel GeneratorModels[];
+	static const unsigned int nGeneratorModels;
+};
+
+
+/*******************************************************************************
+* Copyright  2026 Kerry S. Martin, martin@wild-wood.net
+* Free for usage without warranty, expressed or implied; attribution required
+*******************************************************************************/
\ No newline at end of file
@@ -0,0 +1,199 @@
+/*******************************************************************************
+* Copyright  2026 Kerry S. Martin, martin@wild-wood.net
+* Free for usage without warranty, expressed or implied; attribution required
+*
+* Filename   : HarmonicAnalysis.cpp
+* Class      : HarmonicAnalysis
+* Description:
+*   HarmonicAnalysis measures the harmonics, THD and THD+N of a captured
+*   sine wave.
+*
+* Created    : 10/16/2026
+* Modified   : 10/16/2026
+* Author     : Kerry S. Martin, martin@wild-wood.net
+*******************************************************************************/
+
+#include "HarmonicAnalysis.h"
+#include <cmath>
+#include <limits>
+
+using namespace std;
+
+constexpr double PI = 3.14159265358979323846;
+
+
+/*******************************************************************************
+* Class      : HarmonicAnalysis
+* Function   : Analyze()
+* Access     : public static
+* Arguments  : samples   = captured waveform (V)
+*              tSample   = time between the samples
+*              f0        = frequency of the fundamental
+*              amplitude = receives the peak amplitudes of the fundamental and
+*                          harmonics 2 to N_HARMONICS (V)
+*              thd       = receives the THD (ratio to the fundamental)
+*              thdn      = receives the THD+N (ratio to the fundamental)
+* Returns    : true if the waveform could be analyzed
+* Description:
+*   The waveform must hold at least one cycle of the fundamental, sampled
+*   fast enough for the highest harmonic to be below the Nyquist frequency.
+*   THD is the root sum square of the harmonics relative to the fundamental;
+*   THD+N is the RMS of everything but the fundamental (and DC) relative to
+*   the RMS of the fundamental, so it includes noise and any harmonic above
+*   the 5th. On failure, every result is NaN.
+*/
+bool HarmonicAnalysis::Analyze(std::vector<double> const& samples, double tSample, double f0, double amplitude[N_HARMONICS], double& thd, double& thdn)
+{
+	const double NaN = numeric_limits<double>::quiet_NaN();
+
+	for (unsigned int k = 0; k < N_HARMONICS; ++k)
+		amplitude[k] = NaN;
+	thd = NaN;
+	thdn = NaN;
+
+	if (!(tSample > 0.0) || !(f0 > 0.0))
+		return false;
+
+	const double samplesPerCycle = 1.0 / (f0 * tSample);
+	if (samplesPerCycle <= 2.0 * N_HARMONICS)
+		return false;   // the highest harmonic would be aliased
+
+	// the largest whole number of cycles of the fundamental
+	const double cycles = floor(samples.size() / samplesPerCycle);
+	const size_t n = static_cast<size_t>(floor(cycles * samplesPerCycle + 0.5));
+	if (cycles < 1.0 || n == 0 || n > samples.size())
+		return false;
+
+	double const* pSamples = samples.data();
+
+	// the fundamental, its amplitude and the residual of everything else
+	double mean = 0.0;
+	double msResidual = 0.0;
+	if (!FitFundamental(pSamples, n, 2.0 * PI * f0 * tSample, amplitude[0], mean, msResidual) || !(amplitude[0] > 0.0))
+		return false;
+
+	for (unsigned int k = 1; k < N_HARMONICS; ++k)
+		amplitude[k] = Amplitude(pSamples, n, mean, 2.0 * PI * (k + 1) * f0 * tSample);
+
+	double sumSquares = 0.0;
+	for (unsigned int k = 1; k < N_HARMONICS; ++k)
+		sumSquares += amplitude[k] * amplitude[k];
+
+	// the mean square of a sine is half its peak squared
+	const double msFund = amplitude[0] * amplitude[0] / 2.0;
+
+	thd = sqrt(sumSquares) / amplitude[0];
+	thdn = sqrt(msResidual / msFund);
+
+	return true;
+}
+
+
+/*******************************************************************************
+* Class      : HarmonicAnalysis
+* Function   : FitFundamental()
+* Access     : private static
+* Arguments  : pSamples   = waveform
+*              n          = number of samples to use
+*              omega      = frequency of the fundamental (radians per sample)
+*              amplitude  = receives the peak amplitude of the fundamental
+*              mean       = receives the DC level
+*              msResidual = receives the mean square of what is left once the
+*                           fundamental and the DC level are removed
+* Returns    : true if the fit could be solved
+* Description:
+*   Least squares fit of a sine of known frequency and a DC level (the three
+*   parameter sine fit). Unlike a single DFT term, the fit is exact when the
+*   record is not a whole number of cycles, so the residual is not inflated
+*   by the leakage of the fundamental.
+*/
+bool HarmonicAnalysis::FitFundamental(double const* pSamples, size_t n, double omega, double& amplitude, double& mean, double& msResidual)
+{
+	// normal equations of x = a.cos + b.sin + d
+	double cc = 0.0, ss = 0.0, cs = 0.0, c1 = 0.0, s1 = 0.0;
+	double xc = 0.0, xs = 0.0, x1 = 0.0;
+
+	for (size_t i = 0; i < n; ++i)
+	{
+		const double c = cos(omega * i);
+		const double s = sin(omega * i);
+		cc += c * c;
+		ss += s * s;
+		cs += c * s;
+		c1 += c;
+		s1 += s;
+		xc += pSamples[i] * c;
+		xs += pSamples[i] * s;
+		x1 += pSamples[i];
+	}
+
+	const double m[3][3] = { { cc, cs, c1 }, { cs, ss, s1 }, { c1, s1, double(n) } };
+	const double det = m[0][0] * (m[1][1] * m[2][2] - m[1][2] * m[2][1])
+		- m[0][1] * (m[1][0] * m[2][2] - m[1][2] * m[2][0])
+		+ m[0][2] * (m[1][0] * m[2][1] - m[1][1] * m[2][0]);
+
+	if (!(abs(det) > 0.0))
+		return false;
+
+	// Cramer's rule
+	const double a = (xc * (m[1][1] * m[2][2] - m[1][2] * m[2][1])
+		- m[0][1] * (xs * m[2][2] - m[1][2] * x1)
+		+ m[0][2] * (xs * m[2][1] - m[1][1] * x1)) / det;
+	const double b = (m[0][0] * (xs * m[2][2] - m[1][2] * x1)
+		- xc * (m[1][0] * m[2][2] - m[1][2] * m[2][0])
+		+ m[0][2] * (m[1][0] * x1 - xs * m[2][0])) / det;
+	const double d = (m[0][0] * (m[1][1] * x1 - xs * m[2][1])
+		- m[0][1] * (m[1][0] * x1 - xs * m[2][0])
+		+ xc * (m[1][0] * m[2][1] - m[1][1] * m[2][0])) / det;
+
+	msResidual = 0.0;
+	for (size_t i = 0; i < n; ++i)
+	{
+		const double r = pSamples[i] - a * cos(omega * i) - b * sin(omega * i) - d;
+		msResidual += r * r;
+	}
+	msResidual /= n;
+
+	amplitude = sqrt(a * a + b * b);
+	mean = d;
+
+	return true;
+}
+
+
+/*******************************************************************************
+* Class      : HarmonicAnalysis
+* Function   : Amplitude()
+* Access     : private static
+* Arguments  : pSamples = waveform
+*              n        = number of samples to use
+*              mean     = DC level, removed from each sample
+*              omega    = frequency (radians per sample)
+* Returns    : peak amplitude of the waveform at omega
+* Description:
+*   Evaluates one term of the discrete time Fourier transform with the
+*   Goertzel recurrence. omega need not be a bin of the FFT of n points.
+*/
+double HarmonicAnalysis::Amplitude(double const* pSamples, size_t n, double mean, double omega)
+{
+	const double coeff = 2.0 * cos(omega);
+	double s1 = 0.0;
+	double s2 = 0.0;
+
+	for (size_t i = 0; i < n; ++i)
+	{
+		const double s0 = (pSamples[i] - mean) + coeff * s1 - s2;
+		s2 = s1;
+		s1 = s0;
+	}
+
+	const double power = s1 * s1 + s2 * s2 - coeff * s1 * s2;
+
+	return 2.0 * sqrt((power > 0.0) ? power : 0.0) / n;
+}
+
+
+/*******************************************************************************
+* Copyright  2026 Kerry S. Martin, martin@wild-wood.net
+* Free for usage without warranty, expressed or implied; attribution required
+*******************************************************************************/
\ No newline at end of file
@@ -0,0 +1,45 @@
+/*******************************************************************************
+* Copyright  2026 Kerry S. Martin, martin@wild-wood.net
+* Free for usage without warranty, expressed or implied; attribution required
+*
+* Filename   : HarmonicAnalysis.h
+* Class      : HarmonicAnalysis
+* Description:
+*   HarmonicAnalysis measures the distortion of a sine wave from a captured
+*   waveform: the amplitudes of the fundamental and of its 2nd to 5th
+*   harmonics, the total harmonic distortion (THD) and the total harmonic
+*   distortion plus noise (THD+N).
+*
+*   The waveform is the one already captured to measure the gain and phase
+*   of a point, read back from the oscilloscope, so the analysis costs no
+*   additional acquisition. It is trimmed to a whole number of cycles of the
+*   fundamental; the fundamental is found by a least squares sine fit, and
+*   each harmonic with the Goertzel algorithm at its exact frequency, so no
+*   FFT or window is needed.
+*
+* Created    : 10/16/2026
+* Modified   : 10/16/2026
+* Author     : Kerry S. Martin, martin@wild-wood.net
+*******************************************************************************/
+#pragma once
+#include <cstddef>
+#include <vector>
+
+class HarmonicAnalysis
+{
+public:
+	// fundamental and 2nd to 5th harmonics
+	static constexpr unsigned int N_HARMONICS = 5;
+
+	static bool Analyze(std::vector<double> const& samples, double tSample, double f0, double amplitude[N_HARMONICS], double& thd, double& thdn);
+
+private:
+	static bool FitFundamental(double const* pSamples, size_t n, double omega, double& amplitude, double& mean, double& msResidual);
+	static double Amplitude(double const* pSamples, size_t n, double mean, double omega);
+};
+
+
+/*******************************************************************************
+* Copyright  2026 Kerry S. Martin, martin@wild-wood.net
+* Free for usage without warranty, expressed or implied; attribution required
+*******************************************************************************/
\ No newline at end of file
@@ -0,0 +1,82 @@
+/*******************************************************************************
+* Copyright  2026 Kerry S. Martin, martin@wild-wood.net
+* Free for usage without warranty, expressed or implied; attribution required
+*
+* Filename   : InstrumentModel.cpp
+* Class      : InstrumentIdent
+* Description:
+*   Identification of an attached instrument model.
+*
+* Created    : 10/16/2026
+* Modified   : 10/16/2026
+* Author     : Kerry S. Martin, martin@wild-wood.net
+*******************************************************************************/
+
+#include "InstrumentModel.h"
+#include <regex>
+
+using namespace std;
+
+
+/*******************************************************************************
+* Class      : InstrumentIdent
+* Function   : Parse()
+* Access     : public
+* Arguments  : response = response to *IDN?
+* Returns    : true if the response has at least a manufacturer and a model
+* Description:
+*   Splits an *IDN? response (manufacturer,model,serial,firmware) into its
+*   fields, without the surrounding whitespace
+*/
+bool InstrumentIdent::Parse(std::string const& response)
+{
+	string* fields[] = { &manufacturer, &model, &serial, &firmware };
+	size_t start = 0;
+
+	for (auto field : fields)
+	{
+		field->clear();
+
+		if (start <= response.length())
+		{
+			size_t end = response.find(',', start);
+			if (end == string::npos)
+				end = response.length();
+
+			const size_t first = response.find_first_not_of(" \t\r\n", start);
+			const size_t last = response.find_last_not_of(" \t\r\n", end - 1);
+			if (first != string::npos && first < end && last != string::npos && last >= first)
+				*field = response.substr(first, last - first + 1);
+
+			start = end + 1;
+		}
+	}
+
+	return !manufacturer.empty() && !model.empty();
+}
+
+
+/*******************************************************************************
+* Class      : InstrumentIdent
+* Function   : Matches()
+* Access     : public
+* Arguments  : reManufacturer = pattern found in the manufacturer
+*              reModel        = pattern matching the whole model
+* Returns    : true if the identification matches both patterns
+* Description:
+*   Compares the identification with an entry of a model table. The patterns
+*   are ECMAScript regular expressions, compared without regard to case.
+*/
+bool InstrumentIdent::Matches(char const* reManufacturer, char const* reModel) const
+{
+	const regex rxManufacturer(reManufacturer, regex::icase);
+	const regex rxModel(reModel, regex::icase);
+
+	return regex_search(manufacturer, rxManufacturer) && regex_match(model, rxModel);
+}
+
+
+/*******************************************************************************
+* Copyright  2026 Kerry S. Martin, martin@wild-wood.net
+* Free for usage without warranty, expressed or implied; attribution required
+*******************************************************************************/
\ No newline at end of file
@@ -0,0 +1,47 @@
+/*******************************************************************************
+* Copyright  2026 Kerry S. Martin, martin@wild-wood.net
+* Free for usage without warranty, expressed or implied; attribution required
+*
+* Filename   : InstrumentModel.h
+* Class      : InstrumentIdent
+* Description:
+*   Identification of an attached instrument model, and the optional
+*   capabilities a model may have. The instrument drivers are chosen by
+*   matching the *IDN? response against the model tables of ScopeDriver and
+*   GeneratorDriver, and FreqResp chooses the fastest measurement strategy
+*   from the capabilities of the models attached.
+*
+* Created    : 10/16/2026
+* Modified   : 10/16/2026
+* Author     : Kerry S. Martin, martin@wild-wood.net
+*******************************************************************************/
+#pragma once
+#include <string>
+
+// optional capabilities of an instrument model (bit flags)
+enum InstrCap : unsigned int
+{
+	CAP_NONE = 0x00,
+	CAP_BINARY_WAVEFORM = 0x01,		// waveform data can be read in binary
+	CAP_MULTI_QUERY = 0x02,			// several queries can be sent in one transmission (see QueryBatch)
+	CAP_SEGMENTED = 0x04,			// segmented (sequence) acquisition memory
+	CAP_NATIVE_SWEEP = 0x08			// stepped frequency sweep run by the instrument
+};
+
+// fields of an *IDN? response
+struct InstrumentIdent
+{
+	std::string manufacturer;
+	std::string model;
+	std::string serial;
+	std::string firmware;
+
+	bool Parse(std::string const& response);
+	bool Matches(char const* reManufacturer, char const* reModel) const;
+};
+
+
+/*******************************************************************************
+* Copyright  2026 Kerry S. Martin, martin@wild-wood.net
+* Free for usage without warranty, expressed or implied; attribution required
+*******************************************************************************/
\ No newline at end of file
@@ -0,0 +1,238 @@
+/*******************************************************************************
+* Copyright  2026 Kerry S. Martin, martin@wild-wood.net
+* Free for usage without warranty, expressed or implied; attribution required
+*
+* Filename   : LimitMask.cpp
+* Class      : LimitMask
+* Description:
+*   LimitMask holds the gain and phase limits of a response, and checks
+*   measured points against them.
+*
+*   File format (one record per line, fields separated by spaces):
+*     FRESP_MASK version
+*     LIMIT  freq dBmin dBmax phaseMin phaseMax
+*            (one per mask point, any order; * for no bound)
+*   Blank lines and lines starting with # are ignored.
+*
+* Created    : 10/16/2026
+* Modified   : 10/16/2026
+* Author     : Kerry S. Martin, martin@wild-wood.net
+*******************************************************************************/
+
+#include "LimitMask.h"
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <limits>
+#include <numeric>
+#include <sstream>
+
+using namespace std;
+
+const char* const LimitMask::FILE_ID{ "FRESP_MASK" };
+const int LimitMask::FILE_VERSION{ 1 };
+
+
+/*******************************************************************************
+* Class      : LimitMask
+* Function   : Load()
+* Access     : public
+* Arguments  : filename = mask file to read
+* Returns    : true if the file was read and has at least one point
+* Description:
+*   Reads the limits of a mask, replacing any held
+*/
+bool LimitMask::Load(std::string filename)
+{
+	ifstream infile(filename);
+	string strLine;
+
+	limits.clear();
+
+	if (!infile.is_open())
+		return false;
+
+	// identification line
+	if (getline(infile, strLine))
+	{
+		istringstream iss(strLine);
+		string strId;
+		int version = 0;
+		if (!(iss >> strId >> version) || strId != FILE_ID || version > FILE_VERSION)
+			return false;
+	}
+	else
+	{
+		return false;
+	}
+
+	while (getline(infile, strLine))
+	{
+		istringstream iss(strLine);
+		string strRecord;
+
+		if (!(iss >> strRecord) || strRecord[0] == '#')
+			continue;
+		else if (strRecord == "LIMIT")
+		{
+			MaskLimit limit;
+			string strBounds[4];
+
+			if (!(iss >> limit.freq >> strBounds[0] >> strBounds[1] >> strBounds[2] >> strBounds[3]) || !(limit.freq > 0.0))
+				return false;
+
+			if (!ParseBound(strBounds[0], limit.dBmin) || !ParseBound(strBounds[1], limit.dBmax)
+				|| !ParseBound(strBounds[2], limit.phaseMin) || !ParseBound(strBounds[3], limit.phaseMax))
+				return false;
+
+			limits.push_back(limit);
+		}
+		else
+		{
+			return false;   // unknown record
+		}
+	}
+
+	sort(limits.begin(), limits.end(), [](MaskLimit const& a, MaskLimit const& b) { return a.freq < b.freq; });
+
+	return !limits.empty();
+}
+
+
+/*******************************************************************************
+* Class      : LimitMask
+* Function   : ParseBound()
+* Access     : private static
+* Arguments  : strBound = field of a LIMIT record
+*              bound    = receives the bound, NaN for *
+* Returns    : true if the field is a number or *
+* Description:
+*   Reads one bound of a LIMIT record
+*/
+bool LimitMask::ParseBound(std::string const& strBound, double& bound)
+{
+	if (strBound == "*")
+	{
+		bound = numeric_limits<double>::quiet_NaN();
+		return true;
+	}
+
+	istringstream iss(strBound);
+	char extra;
+	return (iss >> bound) && !(iss >> extra);
+}
+
+
+/*******************************************************************************
+* Class      : LimitMask
+* Function   : Limits()
+* Access     : public
+* Arguments  : f = frequency
+* Returns    : the bounds at f (all NaN outside the range of the mask)
+* Description:
+*   Interpolates the bounds linearly in log frequency between the mask points
+*   either side of f. A bound left open at either of them is open between them.
+*/
+MaskLimit LimitMask::Limits(double f) const
+{
+	const double NaN = numeric_limits<double>::quiet_NaN();
+	MaskLimit limit{ f, NaN, NaN, NaN, NaN };
+
+	if (limits.empty() || f < limits.front().freq || f > limits.back().freq)
+		return limit;
+
+	auto upper = upper_bound(limits.begin(), limits.end(), f, [](double f, MaskLimit const& ml) { return f < ml.freq; });
+
+	if (upper == limits.end())
+	{
+		limit = limits.back();
+		limit.freq = f;
+	}
+	else
+	{
+		MaskLimit const& lower = *(upper - 1);
+		const double x = log(f / lower.freq) / log(upper->freq / lower.freq);
+		limit.dBmin = lower.dBmin + x * (upper->dBmin - lower.dBmin);
+		limit.dBmax = lower.dBmax + x * (upper->dBmax - lower.dBmax);
+		limit.phaseMin = lower.phaseMin + x * (upper->phaseMin - lower.phaseMin);
+		limit.phaseMax = lower.phaseMax + x * (upper->phaseMax - lower.phaseMax);
+	}
+
+	return limit;
+}
+
+
+/*******************************************************************************
+* Class      : LimitMask
+* Function   : Check()
+* Access     : public
+* Arguments  : point = measured point
+* Returns    : true if the point is within the mask
+* Description:
+*   Checks the gain and phase of a point against the bounds at its frequency.
+*   A point that failed to measure (not finite) is outside any bound. The
+*   measured phase is only known modulo 360 degrees (wrapped to +/-180 in
+*   phase mode, unbounded from a delay), so it is taken within 180 degrees
+*   of the middle of the phase window (or of 0 if the window is open on
+*   one side) before it is compared.
+*/
+bool LimitMask::Check(FRS const& point) const
+{
+	const MaskLimit limit = Limits(point.freq);
+	double phase = (point.tunit == TUNIT::PHASE) ? point.time : -360.0 * point.freq * point.time;
+
+	// wrap into [center - 180, center + 180)
+	const double center = (!isnan(limit.phaseMin) && !isnan(limit.phaseMax)) ? (limit.phaseMin + limit.phaseMax) / 2.0 : 0.0;
+	if (isfinite(phase))
+		phase -= 360.0 * floor((phase - center + 180.0) / 360.0);
+
+	bool bResult = true;
+
+	// comparisons with an open (NaN) bound are false, so it never fails
+	if (!isnan(limit.dBmin) || !isnan(limit.dBmax))
+		bResult = isfinite(point.dBgain) && !(point.dBgain < limit.dBmin) && !(point.dBgain > limit.dBmax);
+
+	if (bResult && (!isnan(limit.phaseMin) || !isnan(limit.phaseMax)))
+		bResult = isfinite(phase) && !(phase < limit.phaseMin) && !(phase > limit.phaseMax);
+
+	return bResult;
+}
+
+
+/*******************************************************************************
+* Class      : LimitMask
+* Function   : Order()
+* Access     : public
+* Arguments  : freqs = frequencies of a sweep
+* Returns    : the indexes of freqs, most discriminating first
+* Description:
+*   Ranks the frequencies by the width of the gain window of the mask, then of
+*   the phase window, narrowest first. Frequencies with no bounds are last,
+*   and frequencies of equal rank stay in sweep order.
+*/
+std::vector<size_t> LimitMask::Order(std::vector<double> const& freqs) const
+{
+	const double inf = numeric_limits<double>::infinity();
+	vector<double> dBwidth(freqs.size());
+	vector<double> phaseWidth(freqs.size());
+	vector<size_t> order(freqs.size());
+
+	for (size_t k = 0; k < freqs.size(); ++k)
+	{
+		const MaskLimit limit = Limits(freqs[k]);
+		dBwidth[k] = (isnan(limit.dBmin) || isnan(limit.dBmax)) ? inf : limit.dBmax - limit.dBmin;
+		phaseWidth[k] = (isnan(limit.phaseMin) || isnan(limit.phaseMax)) ? inf : limit.phaseMax - limit.phaseMin;
+	}
+
+	iota(order.begin(), order.end(), size_t(0));
+	stable_sort(order.begin(), order.end(), [&](size_t a, size_t b)
+		{ return dBwidth[a] < dBwidth[b] || (dBwidth[a] == dBwidth[b] && phaseWidth[a] < phaseWidth[b]); });
+
+	return order;
+}
+
+
+/*******************************************************************************
+* Copyright  2026 Kerry S. Martin, martin@wild-wood.net
+* Free for usage without warranty, expressed or implied; attribution required
+*******************************************************************************/
\ No newline at end of file
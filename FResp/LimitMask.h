@@ -0,0 +1,64 @@
+/*******************************************************************************
+* Copyright  2026 Kerry S. Martin, martin@wild-wood.net
+* Free for usage without warranty, expressed or implied; attribution required
+*
+* Filename   : LimitMask.h
+* Class      : LimitMask
+* Description:
+*   LimitMask holds the pass/fail limits of a response: lower and upper bounds
+*   of the gain and of the phase against frequency, read from a mask file.
+*   FreqResp checks every measured point against the mask, so a sweep can be
+*   stopped at the first point outside it.
+*
+*   The bounds are interpolated linearly in log frequency between the points
+*   of the mask. A bound may be left open, and frequencies outside the range
+*   of the mask are not checked. The phase bounds are in degrees; a delay
+*   measurement is converted to phase to be checked.
+*
+*   Order() ranks the frequencies of a sweep by how tight the mask is there
+*   (the narrowest gain window first, then the narrowest phase window), so
+*   that a sweep measuring in that order meets a failing point early.
+*
+* Created    : 10/16/2026
+* Modified   : 10/16/2026
+* Author     : Kerry S. Martin, martin@wild-wood.net
+*******************************************************************************/
+#pragma once
+#include "FreqResp.h"
+#include <string>
+#include <vector>
+
+// bounds at one frequency (NaN = no bound)
+struct MaskLimit
+{
+	double freq;
+	double dBmin;
+	double dBmax;
+	double phaseMin;	// degrees
+	double phaseMax;
+};
+
+
+class LimitMask
+{
+public:
+	bool Load(std::string filename);
+
+	bool Check(FRS const& point) const;
+	MaskLimit Limits(double f) const;
+	std::vector<size_t> Order(std::vector<double> const& freqs) const;
+
+private:
+	std::vector<MaskLimit> limits;	// ascending frequency
+
+	static bool ParseBound(std::string const& strBound, double& bound);
+
+	static const char* const FILE_ID;
+	static const int FILE_VERSION;
+};
+
+
+/*******************************************************************************
+* Copyright  2026 Kerry S. Martin, martin@wild-wood.net
+* Free for usage without warranty, expressed or implied; attribution required
+*******************************************************************************/
\ No newline at end of file
@@ -0,0 +1,334 @@
+/*******************************************************************************
+* Copyright  2026 Kerry S. Martin, martin@wild-wood.net
+* Free for usage without warranty, expressed or implied; attribution required
+*
+* Filename   : LocalSocket.cpp
+* Class      : LocalSocket
+* Description:
+*   LocalSocket is a minimal line-oriented stream socket on a local (AF_UNIX)
+*   socket file.
+*
+* Created    : 10/16/2026
+* Modified   : 10/16/2026
+* Author     : Kerry S. Martin, martin@wild-wood.net
+*******************************************************************************/
+
+#include "LocalSocket.h"
+#include <afunix.h>
+#include <cstdio>
+#include <cstring>
+
+#pragma comment(lib, "Ws2_32.lib")
+
+using namespace std;
+
+// longest line accepted by ReceiveLine() unless specified
+const size_t LocalSocket::MAX_LINE{ 4096 };
+
+
+/*******************************************************************************
+* Function   : MakeAddress()
+* Arguments  : path = socket file
+*              addr = receives the address
+* Returns    : true if the path fits in the address
+* Description:
+*   Builds the AF_UNIX address for a socket file
+*/
+static bool MakeAddress(std::string const& path, sockaddr_un& addr)
+{
+	memset(&addr, 0, sizeof(addr));
+	addr.sun_family = AF_UNIX;
+
+	if (path.empty() || path.length() >= sizeof(addr.sun_path))
+		return false;
+
+	memcpy(addr.sun_path, path.c_str(), path.length());
+	return true;
+}
+
+
+/*******************************************************************************
+* Class      : LocalSocket
+* Function   : LocalSocket() constructor, destructor, move
+* Access     : public
+* Description:
+*   Constructs a closed socket. The destructor closes the socket.
+*/
+LocalSocket::LocalSocket() : sock(INVALID_SOCKET), bStarted(false)
+{
+}
+
+LocalSocket::~LocalSocket()
+{
+	Close();
+}
+
+LocalSocket::LocalSocket(LocalSocket&& other) : sock(INVALID_SOCKET), bStarted(false)
+{
+	*this = std::move(other);
+}
+
+LocalSocket& LocalSocket::operator = (LocalSocket&& other)
+{
+	if (this != &other)
+	{
+		Close();
+		sock = other.sock;
+		strListenPath = std::move(other.strListenPath);
+		strPending = std::move(other.strPending);
+		bStarted = other.bStarted;
+		other.sock = INVALID_SOCKET;
+		other.strListenPath.clear();
+		other.strPending.clear();
+		other.bStarted = false;
+	}
+	return *this;
+}
+
+
+/*******************************************************************************
+* Class      : LocalSocket
+* Function   : Startup()
+* Access     : private
+* Arguments  : none
+* Returns    : true if Winsock is initialized
+* Description:
+*   Takes a Winsock reference for the life of the socket (released by Close)
+*/
+bool LocalSocket::Startup()
+{
+	if (!bStarted)
+	{
+		WSADATA wsaData;
+		bStarted = (WSAStartup(MAKEWORD(2, 2), &wsaData) == 0);
+	}
+	return bStarted;
+}
+
+
+/*******************************************************************************
+* Class      : LocalSocket
+* Function   : Listen()
+* Access     : public
+* Arguments  : path = socket file to create (a stale file is replaced)
+* Returns    : true if listening
+* Description:
+*   Creates the socket file and listens for clients
+*/
+bool LocalSocket::Listen(std::string path)
+{
+	sockaddr_un addr;
+
+	Close();
+
+	if (!MakeAddress(path, addr) || !Startup())
+		return false;
+
+	sock = socket(AF_UNIX, SOCK_STREAM, 0);
+	if (sock == INVALID_SOCKET)
+	{
+		Close();
+		return false;
+	}
+
+	// a socket file left by a daemon that did not exit cleanly blocks bind()
+	remove(path.c_str());
+
+	if (::bind(sock, (sockaddr*)&addr, (int)sizeof(addr)) == SOCKET_ERROR || listen(sock, 1) == SOCKET_ERROR)
+	{
+		Close();
+		return false;
+	}
+
+	strListenPath = path;
+	return true;
+}
+
+
+/*******************************************************************************
+* Class      : LocalSocket
+* Function   : Accept()
+* Access     : public
+* Arguments  : client = receives the connection
+* Returns    : true if a client connected
+* Description:
+*   Waits for the next client of a listening socket
+*/
+bool LocalSocket::Accept(LocalSocket& client)
+{
+	client.Close();
+
+	if (sock == INVALID_SOCKET)
+		return false;
+
+	SOCKET s = accept(sock, NULL, NULL);
+	if (s == INVALID_SOCKET)
+		return false;
+
+	client.Startup();
+	client.sock = s;
+	return true;
+}
+
+
+/*******************************************************************************
+* Class      : LocalSocket
+* Function   : Connect()
+* Access     : public
+* Arguments  : path = socket file of the daemon
+* Returns    : true if connected
+* Description:
+*   Connects to a listening socket
+*/
+bool LocalSocket::Connect(std::string path)
+{
+	sockaddr_un addr;
+
+	Close();
+
+	if (!MakeAddress(path, addr) || !Startup())
+		return false;
+
+	sock = socket(AF_UNIX, SOCK_STREAM, 0);
+	if (sock == INVALID_SOCKET || connect(sock, (sockaddr*)&addr, (int)sizeof(addr)) == SOCKET_ERROR)
+	{
+		Close();
+		return false;
+	}
+
+	return true;
+}
+
+
+/*******************************************************************************
+* Class      : LocalSocket
+* Function   : Close()
+* Access     : public
+* Arguments  : none
+* Returns    : none
+* Description:
+*   Closes the socket, removing the socket file of a listening socket
+*/
+void LocalSocket::Close()
+{
+	if (sock != INVALID_SOCKET)
+		closesocket(sock);
+	sock = INVALID_SOCKET;
+
+	if (!strListenPath.empty())
+		remove(strListenPath.c_str());
+	strListenPath.clear();
+	strPending.clear();
+
+	if (bStarted)
+		WSACleanup();
+	bStarted = false;
+}
+
+
+/*******************************************************************************
+* Class      : LocalSocket
+* Function   : IsOpen()
+* Access     : public
+* Arguments  : none
+* Returns    : true if the socket is open
+*/
+bool LocalSocket::IsOpen() const
+{
+	return sock != INVALID_SOCKET;
+}
+
+/*******************************************************************************
+* Class      : LocalSocket
+* Function   : SetReceiveTimeout()
+* Access     : public
+* Arguments  : msec = longest wait for data (0 = wait indefinitely)
+* Returns    : true if the timeout was set
+* Description:
+*   Limits how long ReceiveLine() waits for a peer that sends nothing
+*/
+bool LocalSocket::SetReceiveTimeout(unsigned long msec)
+{
+	const DWORD dwTimeout = msec;
+
+	return sock != INVALID_SOCKET && setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, (char const*)&dwTimeout, sizeof(dwTimeout)) == 0;
+}
+
+
+
+/*******************************************************************************
+* Class      : LocalSocket
+* Function   : Send()
+* Access     : public
+* Arguments  : pData, nLength = data to send, or text = text to send
+* Returns    : true if all of the data was sent
+* Description:
+*   Sends the data, continuing after partial sends
+*/
+bool LocalSocket::Send(char const* pData, size_t nLength)
+{
+	while (nLength > 0)
+	{
+		if (sock == INVALID_SOCKET)
+			return false;
+
+		const int n = send(sock, pData, (int)nLength, 0);
+		if (n == SOCKET_ERROR || n <= 0)
+			return false;
+
+		pData += n;
+		nLength -= size_t(n);
+	}
+
+	return true;
+}
+
+bool LocalSocket::Send(std::string const& text)
+{
+	return Send(text.c_str(), text.length());
+}
+
+
+/*******************************************************************************
+* Class      : LocalSocket
+* Function   : ReceiveLine()
+* Access     : public
+* Arguments  : line       = receives the line, without the newline
+*              nMaxLength = longest line accepted
+* Returns    : true if a line was received, false on close, error, or overlong line
+* Description:
+*   Receives one newline terminated line. Data received past the newline is
+*   kept for the next call.
+*/
+bool LocalSocket::ReceiveLine(std::string& line, size_t nMaxLength)
+{
+	char buffer[512];
+
+	for (;;)
+	{
+		const size_t nNewline = strPending.find('\n');
+		if (nNewline != string::npos)
+		{
+			line = strPending.substr(0, nNewline);
+			strPending.erase(0, nNewline + 1);
+			if (!line.empty() && line.back() == '\r')
+				line.pop_back();
+			return true;
+		}
+
+		if (strPending.length() > nMaxLength || sock == INVALID_SOCKET)
+			return false;
+
+		const int n = recv(sock, buffer, (int)sizeof(buffer), 0);
+		if (n == SOCKET_ERROR || n <= 0)
+			return false;
+
+		strPending.append(buffer, size_t(n));
+	}
+}
+
+
+/*******************************************************************************
+* Copyright  2026 Kerry S. Martin, martin@wild-wood.net
+* Free for usage without warranty, expressed or implied; attribution required
+*******************************************************************************/
\ No newline at end of file
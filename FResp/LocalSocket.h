@@ -0,0 +1,59 @@
+/*******************************************************************************
+* Copyright  2026 Kerry S. Martin, martin@wild-wood.net
+* Free for usage without warranty, expressed or implied; attribution required
+*
+* Filename   : LocalSocket.h
+* Class      : LocalSocket
+* Description:
+*   LocalSocket is a minimal line-oriented stream socket on a local (AF_UNIX)
+*   socket file, used between the measurement daemon and its clients.
+*
+*   A listening LocalSocket is created with Listen(); Accept() then returns a
+*   connected LocalSocket for each client. A client uses Connect(). Connected
+*   sockets exchange text with Send() and ReceiveLine().
+*
+* Created    : 10/16/2026
+* Modified   : 10/16/2026
+* Author     : Kerry S. Martin, martin@wild-wood.net
+*******************************************************************************/
+#pragma once
+#include <string>
+#include <winsock2.h>
+
+class LocalSocket
+{
+public:
+	LocalSocket();
+	~LocalSocket();
+	LocalSocket(LocalSocket&& other);
+	LocalSocket& operator = (LocalSocket&& other);
+	LocalSocket(LocalSocket const&) = delete;
+	LocalSocket& operator = (LocalSocket const&) = delete;
+
+	bool Listen(std::string path);
+	bool Accept(LocalSocket& client);
+	bool Connect(std::string path);
+	void Close();
+	bool IsOpen() const;
+	bool SetReceiveTimeout(unsigned long msec);
+
+	bool Send(char const* pData, size_t nLength);
+	bool Send(std::string const& text);
+	bool ReceiveLine(std::string& line, size_t nMaxLength = MAX_LINE);
+
+	static const size_t MAX_LINE;
+
+private:
+	SOCKET sock;
+	std::string strListenPath;	// socket file to remove on Close (listening socket only)
+	std::string strPending;		// received data following the last line returned
+	bool bStarted;				// this object holds a WSAStartup reference
+
+	bool Startup();
+};
+
+
+/*******************************************************************************
+* Copyright  2026 Kerry S. Martin, martin@wild-wood.net
+* Free for usage without warranty, expressed or implied; attribution required
+*******************************************************************************/
\ No newline at end of file
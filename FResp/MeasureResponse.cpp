@@ -10,7 +10,7 @@
 *   the measurement is initiated using class FreqResp.
 *
 * Created    : 07/03/2020
-* Modified   : 01/02/2023
+* Modified   : 10/16/2026
 * Author     : Kerry S. Martin, martin@wild-wood.net
 *
 * History    : Ver    Date         Notes
@@ -21,22 +21,46 @@
 *              2.01    2021-11-11  Fixed filename parsing
 *              2.02    2023-01-01  Added BWL switch for input, output
 *              2.03    2023-01-02  Modified Oscilloscope SetChannelEx & SetChannelBWL (does not affect MeasureResponse functionality)
+*              2.04    2026-10-16  Reconnect and restore instruments after a lost connection mid-sweep
+*              2.05    2026-10-16  Added checkpoint and resume of long sweeps
+*              2.06    2026-10-16  Added binary columnar results file
+*              2.07    2026-10-16  Results are written by a background thread
+*              2.08    2026-10-16  Results are written with full (shortest round-trip) precision
+*              2.09    2026-10-16  Added job files to run many sweeps in one instrument session
+*              2.10    2026-10-16  Added measurement daemon on a local socket, and its client
+*              2.11    2026-10-16  Added averaging with statistical stopping at each point
+*              2.12    2026-10-16  Added hardware sweep mode (generator stepped sweep, scope segments)
+*              2.13    2026-10-16  Added bench calibration of the channel mismatch
+*              2.14    2026-10-16  Instruments are attached concurrently, with a connect timeout (registry ConnectTimeout)
+*              2.15    2026-10-16  Instrument commands are sent at full numeric precision
+*              2.16    2026-10-16  Instrument drivers chosen by model (*IDN?), fastest measurement the models support
+*              2.17    2026-10-16  Added search for the bandwidth corner, peak and unity gain crossover
+*              2.18    2026-10-16  Added limit mask pass/fail testing, with early stop and mask ordering
+*              2.19    2026-10-16  Added stimulus amplitude leveling
+*              2.20    2026-10-16  Added harmonic distortion, THD and THD+N analysis of the captured output
+*              2.21    2026-10-16  Added live result publishing to a shared memory ring
+*              2.22    2026-10-16  Added a rational model fitted while sweeping, ending the sweep once it converges
 *******************************************************************************/
 
 #include <algorithm>
 #include <iostream>
 #include <fstream>
+#include <sstream>
 #include <string>
 #include <regex>
+#include <vector>
 #include <cmath>
-#include "EchoDualStream.h"
 #include "FreqResp.h"
 #include "MeasureResponse.h"
 #include "FResp_Settings.h"
+#include "SweepCheckpoint.h"
+#include "ResultWriter.h"
+#include "LocalSocket.h"
+#include "Socket_Instrument.h"
 
 using namespace std;
 
-constexpr auto VERSION = "2.03";
+constexpr auto VERSION = "2.22";
 
 //#define DEBUG_WITHOUT_INSTRUMENTS			// uncomment this to run the code without connecting to the instruments (for debugging parsing, etc)
 
@@ -47,10 +71,20 @@ constexpr auto REGISTRY_KEY = "SOFTWARE\\WWES\\FResp\\Settings\\";
 constexpr auto RESOURCE_DEFAULT_OSCOPE = "192.168.0.197:5025";
 constexpr auto RESOURCE_DEFAULT_SIGGEN = "192.168.0.198:5555";
 
+// default time allowed to connect to an instrument, in milliseconds (will be written to registry if non-existent)
+constexpr auto CONNECT_TIMEOUT_DEFAULT = "2000";
+
 #define DEFAULT_DOUBLE std::nan("")			// double value returned when no value was specified in an command-line parameter
 
 constexpr auto CH_TRIG_IN = -1;				// value that will be interpreted as "set it to the same channel as input"
 constexpr auto CH_TRIG_OUT = -2;			// value that will be interpreted as "set it to the same channel as output"
+constexpr auto AVG_DEFAULT_TOL_DB = 0.05;	// default averaging tolerance of the gain, dB
+constexpr auto AVG_DEFAULT_TOL_DEG = 0.5;	// default averaging tolerance of the phase, degrees
+constexpr auto SEARCH_DB_CORNER = -3.0;		// gain of the bandwidth corner searched for, relative to fStart
+constexpr auto SEARCH_TOLERANCE = 0.01;		// a search ends once the frequency is bracketed within 1%
+constexpr auto SEARCH_POINTS_MAX = 40u;		// most points measured by a search
+constexpr auto DAEMON_REQUEST_TIMEOUT_MSEC = 5000ul;	// longest wait for a daemon client to send its request
+constexpr auto FIT_DEFAULT_TOL = 0.01;		// a fitted model has converged once its poles, zeros and gain move less than 1%
 
 
 
@@ -65,15 +99,22 @@ int ExitPrintUsage(std::string strProgName)
 {
 	std::cout << strProgName << " ";
 	std::cout << "freq:fstart-fstop,log|lin(npts) ";
-	std::cout << "stim:ch,vampl+voffset ";
+	std::cout << "stim:ch,vampl+voffset level:vout,vmax ";
 	std::cout << "in:ch,ac|dc,1x|10x,bwl|-bwl out:ch,ac|dc,1x|10x,bwl|-bwl ";
 	std::cout << "trig:ch,ac|dc,rising|falling,vtrig ";
-	std::cout << "meas:Vpk|Vpp,phase|delay ";
-	std::cout << "dwell:fast|mid|slow file:filename,quiet|echo\n";
+	std::cout << "meas:Vpk|Vpp,phase|delay avg:max[,dB[,deg]] mode:point|hw harm:on|off search:bw,peak,ugf fit:poles[,zeros[,tol]] ";
+	std::cout << "dwell:fast|mid|slow file:filename,quiet|echo ";
+	std::cout << "checkpoint:filename|resume:filename bin:filename shm:name cal:filename|calibrate:filename ";
+	std::cout << "mask:filename onfail:continue|next|abort order:freq|mask\n";
+	std::cout << strProgName << " job:filename\n";
+	std::cout << strProgName << " serve:socketfile\n";
+	std::cout << strProgName << " via:socketfile arguments...|shutdown\n";
 	std::cout << "  fstart and fstop may use suffix notation (ex/ 1k-10k)\n";
 	std::cout << "  log sweep npts is points/decade\n";
 	std::cout << "  lin sweep npts is the points/sweep\n";
 	std::cout << "  stim vampl+voffset are optional, ch defaults to oscope in or may be S1-S2\n";
+	std::cout << "  level raises or lowers the stimulus at each point to hold the output near vout Vpp, never\n";
+	std::cout << "    above vmax Vpp (the most the circuit may be driven with); the sweep starts at vampl\n";
 	std::cout << "  in, out ch is 1-4 (ex/ ch1, c1, or 1 are equivalent)\n";
 	std::cout << "  in, out ac|dc coupling is optional, defaults to ac\n";
 	std::cout << "  in, out bwl|-bwl  bandwidth limit is optional, defaults to bwl\n";
@@ -81,8 +122,34 @@ int ExitPrintUsage(std::string strProgName)
 	std::cout << "  trig ch may be 1-4, in, or out\n";
 	std::cout << "  trig vtrig is the trigger voltage\n";
 	std::cout << "  meas specifies the measurement type (VPP|VPK and phase|delay)\n";
+	std::cout << "  avg averages up to max readings at each point, stopping early once the 95% confidence\n";
+	std::cout << "    intervals are within +/- dB of gain and +/- deg of phase (defaults 0.05dB, 0.5deg; avg:1 = off)\n";
+	std::cout << "  mode:hw measures a lin sweep with the generator's own stepped sweep, captured as scope\n";
+	std::cout << "    segments (fast, one timebase and vertical scale for the sweep; falls back to point if not possible)\n";
+	std::cout << "  harm:on analyzes the output waveform already captured at each point for the fundamental (V),\n";
+	std::cout << "    harmonics 2-5 (dBc), THD and THD+N (dB), added as columns (the scope must read waveforms)\n";
+	std::cout << "  search finds the bw (-3dB corner), peak and/or ugf (unity gain crossover and phase margin)\n";
+	std::cout << "    between fstart and fstop in a few points, instead of sweeping; outputs the points visited\n";
+	std::cout << "  fit fits a model with poles (1-8) and zeros (0-poles, default 0) while sweeping, measuring coarse\n";
+	std::cout << "    to fine, and ends the sweep once the model moves less than tol (default 0.01) over 3 points;\n";
+	std::cout << "    writes the model after the points (output is not in frequency order)\n";
 	std::cout << "  file|log|report specifies a destination file for the output\n";
-	std::cout << "  quiet or echo specifies output to the standard output\n\n";
+	std::cout << "  quiet or echo specifies output to the standard output\n";
+	std::cout << "  checkpoint records the sweep progress to a file after every point\n";
+	std::cout << "  resume continues the sweep recorded in a checkpoint file (its settings are used)\n";
+	std::cout << "  bin|binary writes the results to a binary columnar file at the end of the sweep\n";
+	std::cout << "  shm|share publishes each point as it is measured to a shared memory ring of that name, for\n";
+	std::cout << "    live viewers on this computer (see FRShared.h; viewers never slow the sweep)\n";
+	std::cout << "  cal corrects the results for the channel mismatch stored in a bench calibration file\n";
+	std::cout << "  calibrate measures the channel mismatch for this setup into a bench calibration file\n";
+	std::cout << "    (connect the in and out probes to the same signal; repeat only when the setup changes)\n";
+	std::cout << "  mask checks every point against the gain and phase limits in a mask file (exit code -15 on fail)\n";
+	std::cout << "  onfail on the first point outside the mask: continue the sweep (default), stop it and go on to\n";
+	std::cout << "    the next job (next), or stop it and the batch (abort)\n";
+	std::cout << "  order:mask measures the frequencies where the mask is tightest first (output is not in frequency order)\n";
+	std::cout << "  job|batch runs the sweeps in a file (one per line, same arguments) in one instrument session\n";
+	std::cout << "  serve runs a daemon that keeps the instruments attached and accepts sweeps on a local socket\n";
+	std::cout << "  via sends the sweep to the daemon and prints the output as it is measured\n\n";
 	std::cout << "  " << strProgName << " Version " << VERSION << " (" << __DATE__ << " " << __TIME__ ")\n";
 	std::cout << "  Copyright (c) 2023 Kerry S. Martin, martin@wild-wood.net\n\n";
 	std::cout << "  Defaults:\n";
@@ -648,24 +715,37 @@ int MeasureResponseParse
 	error = "";
 
 	// default parameters unless overridden on the command line
-	file = { true, "" };
+	file = { true, "", "", false, "", "", "", false, "", Fail_t::CONTINUE, false };
 	freq = { 1000.0, 10000.0, Sweep_t::LOG, 10 };
-	stim = { 1, Vtype_t::VPP, 1.00, 0.00 };
+	stim = { 1, Vtype_t::VPP, 1.00, 0.00, DEFAULT_DOUBLE, DEFAULT_DOUBLE };
 	input = { 1, Ctype_t::AC, 10.0, true };
 	output = { 2, Ctype_t::AC, 10.0, true };
 	trig = { CH_TRIG_IN, Etype_t::RISE, Ctype_t::AC, 0.0 };
-	meas = { Vtype_t::VPP, Ttype_t::PHASE };
+	meas = { Vtype_t::VPP, Ttype_t::PHASE, 1, AVG_DEFAULT_TOL_DB, AVG_DEFAULT_TOL_DEG, false, false, SEARCH_NONE, { 0, 0, FIT_DEFAULT_TOL } };
 	dwell = { 2.0, 500 };
 
 	// regex patterns for parsing the command-line arguments
 	const string str_numeric_pos = "(\\+?\\d*\\.?\\d*(?:E(?:\\+|-)?\\d{1,3})?)(K|M)?";
 	const regex regex_oscope_ch("^(IN?|O(?:UT)?)(?::|=)(?:C|CH)?([1-4])(?:,(AC|DC|1X|10X|-?BWL?))?(?:,(AC|DC|1X|10X|-?BWL?))?(?:,(AC|DC|1X|10X|-?BWL?))?$", regex::icase);
 	const regex regex_stim_spec("^S(?:TIM)?(?::|=)(.+)$", regex::icase);
+	const regex regex_level_spec("^LEVEL(?::|=)([0-9]*\\.?[0-9]+)(?:VPP)?,([0-9]*\\.?[0-9]+)(?:VPP)?$", regex::icase);
 	const regex regex_freq_spec("^F(?:REQ)?(?::|=)" + str_numeric_pos + "(?:HZ)?\\-" + str_numeric_pos + "(?:HZ)?(?:\\,(LOG|LIN)(?:\\(|\\[)([0-9]+)(?:\\)|\\]))?$", regex::icase);
 	const regex regex_meas_spec("^M(?:EAS)?(?::|=)(.+)$", regex::icase);
 	const regex regex_trig_spec("^T(?:RIG)?(?::|=)(.+)$", regex::icase);
+	const regex regex_avg_spec("^AVG?(?::|=)([0-9]+)(?:,([0-9]*\\.?[0-9]+)(?:DB)?)?(?:,([0-9]*\\.?[0-9]+)(?:DEG)?)?$", regex::icase);
+	const regex regex_mode_spec("^MODE(?::|=)(HW|HARD(?:WARE)?|POINT|STEP)$", regex::icase);
+	const regex regex_harm_spec("^(?:HARM(?:ONICS)?|THD)(?::|=)(ON|OFF)$", regex::icase);
+	const regex regex_search_spec("^SEARCH(?::|=)((?:BW|BANDWIDTH|PEAK|UGF|CROSS(?:OVER)?)(?:,(?:BW|BANDWIDTH|PEAK|UGF|CROSS(?:OVER)?))*)$", regex::icase);
+	const regex regex_fit_spec("^FIT(?::|=)([0-8])(?:,([0-8]))?(?:,([0-9]*\\.?[0-9]+))?$", regex::icase);
 	const regex regex_dwell_spec("^D(?:WELL)?(?::|=)(SLOW|MID|FAST|NORM(?:AL)?|DEF(?:AULT)?)$", regex::icase);
 	const regex regex_log_spec("^(?:FILE|LOG|REP(?:ORT)?)(?::|=)(.+)$", regex::icase);
+	const regex regex_ckpt_spec("^(?:(CHECKPOINT|CKPT)|RESUME)(?::|=)\"?([^\"]+)\"?$", regex::icase);
+	const regex regex_bin_spec("^BIN(?:ARY)?(?::|=)\"?([^\"]+)\"?$", regex::icase);
+	const regex regex_shm_spec("^(?:SHM|SHARE)(?::|=)([A-Z0-9_.-]+)$", regex::icase);
+	const regex regex_cal_spec("^(?:CAL|(CALIBRATE))(?::|=)\"?([^\"]+)\"?$", regex::icase);
+	const regex regex_mask_spec("^MASK(?::|=)\"?([^\"]+)\"?$", regex::icase);
+	const regex regex_onfail_spec("^ONFAIL(?::|=)(CONT(?:INUE)?|NEXT|ABORT)$", regex::icase);
+	const regex regex_order_spec("^ORDER(?::|=)(FREQ|MASK)$", regex::icase);
 
 	// logging
 	file.filename = "";		// log to filename
@@ -846,6 +926,109 @@ int MeasureResponseParse
 				return RETURN_SYNTAX_ERROR;
 			}
 		}
+		else if (regex_match(arg, smMatch, regex_ckpt_spec))
+		{
+			// checkpoint to a new file, or resume from an existing one
+			file.checkpoint = smMatch[2];
+			file.is_resume = !smMatch[1].matched;
+		}
+		else if (regex_match(arg, smMatch, regex_bin_spec))
+		{
+			// binary columnar results file
+			file.binfilename = smMatch[1];
+		}
+		else if (regex_match(arg, smMatch, regex_shm_spec))
+		{
+			// shared memory ring for live viewers
+			file.shmname = smMatch[1];
+		}
+		else if (regex_match(arg, smMatch, regex_cal_spec))
+		{
+			// bench calibration file, to correct with or to measure into
+			file.calfile = smMatch[2];
+			file.is_calibrate = smMatch[1].matched;
+		}
+		else if (regex_match(arg, smMatch, regex_level_spec))
+		{
+			// stimulus leveling: output amplitude held, and the largest stimulus
+			stim.vlevel = stod(smMatch[1]);
+			stim.vmax = stod(smMatch[2]);
+		}
+		else if (regex_match(arg, smMatch, regex_mask_spec))
+		{
+			// pass/fail limit mask
+			file.maskfile = smMatch[1];
+		}
+		else if (regex_match(arg, smMatch, regex_onfail_spec))
+		{
+			const string strOnFail = smMatch[1];
+
+			if (str_compare_icase(strOnFail, "NEXT"))
+				file.onfail = Fail_t::NEXT;
+			else if (str_compare_icase(strOnFail, "ABORT"))
+				file.onfail = Fail_t::ABORT;
+			else
+				file.onfail = Fail_t::CONTINUE;
+		}
+		else if (regex_match(arg, smMatch, regex_order_spec))
+		{
+			// measurement order: ascending frequency, or the tightest mask first
+			const string strOrder = smMatch[1];
+			file.is_mask_order = str_compare_icase(strOrder, "MASK");
+		}
+		else if (regex_match(arg, smMatch, regex_avg_spec))
+		{
+			// averaging: most readings per point, then the optional gain and phase tolerances
+			meas.nAvgMax = stoul(smMatch[1]);
+			if (meas.nAvgMax < 1)
+				meas.nAvgMax = 1;
+			if (smMatch[2].matched)
+				meas.tolGain_dB = stod(smMatch[2]);
+			if (smMatch[3].matched)
+				meas.tolPhase_deg = stod(smMatch[3]);
+		}
+		else if (regex_match(arg, smMatch, regex_mode_spec))
+		{
+			// sweep mode: point-by-point, or the generator's hardware sweep
+			const string strMode = smMatch[1];
+			meas.is_hwsweep = !(str_compare_icase(strMode, "POINT") || str_compare_icase(strMode, "STEP"));
+		}
+		else if (regex_match(arg, smMatch, regex_harm_spec))
+		{
+			// harmonic analysis of the output waveform at each point
+			meas.is_harmonics = str_compare_icase(smMatch[1], "ON");
+		}
+		else if (regex_match(arg, smMatch, regex_search_spec))
+		{
+			// characteristics to search for, instead of sweeping
+			const string strSearch = smMatch[1];
+			size_t start = 0;
+
+			while (start <= strSearch.length())
+			{
+				size_t end = strSearch.find(',', start);
+				if (end == string::npos)
+					end = strSearch.length();
+
+				const string strFeature = strSearch.substr(start, end - start);
+				if (str_compare_icase(strFeature, "PEAK"))
+					meas.search |= SEARCH_PEAK;
+				else if (str_compare_icase(strFeature, "BW") || str_compare_icase(strFeature, "BANDWIDTH"))
+					meas.search |= SEARCH_BANDWIDTH;
+				else
+					meas.search |= SEARCH_CROSSOVER;
+
+				start = end + 1;
+			}
+		}
+		else if (regex_match(arg, smMatch, regex_fit_spec))
+		{
+			// rational model: poles, then the optional zeros and convergence tolerance
+			meas.fit.nPoles = stoul(smMatch[1]);
+			meas.fit.nZeros = smMatch[2].matched ? stoul(smMatch[2]) : 0;
+			if (smMatch[3].matched)
+				meas.fit.tolerance = stod(smMatch[3]);
+		}
 		else if (regex_match(arg, smMatch, regex_dwell_spec))
 		{
 			const string strDwell = smMatch[1];
@@ -963,10 +1146,593 @@ int MeasureResponseParse
 		return RETURN_SETUP_ERROR;
 	}
 
+	if (!isnan(stim.vlevel) && (stim.vlevel <= 0.0 || stim.vmax <= 0.0))
+	{
+		error = "The leveling output and maximum stimulus amplitudes must be greater than 0.0V\n";
+		return RETURN_SETUP_ERROR;
+	}
+
+	if (meas.search != SEARCH_NONE && (!file.checkpoint.empty() || file.is_calibrate || meas.is_hwsweep || !file.maskfile.empty()))
+	{
+		error = "A search cannot be checkpointed, calibrated, masked, or measured with mode:hw\n";
+		return RETURN_SETUP_ERROR;
+	}
+
+	if (file.is_mask_order && (file.maskfile.empty() || !file.checkpoint.empty()))
+	{
+		error = "order:mask requires a mask, and cannot be checkpointed\n";
+		return RETURN_SETUP_ERROR;
+	}
+
+	if (meas.fit.nPoles > 0 && (meas.fit.nZeros > meas.fit.nPoles || !(meas.fit.tolerance > 0.0)))
+	{
+		error = "A fit must have no more zeros than poles, and a tolerance greater than 0\n";
+		return RETURN_SETUP_ERROR;
+	}
+
+	if (meas.fit.nPoles > 0 && (meas.search != SEARCH_NONE || file.is_calibrate || file.is_mask_order))
+	{
+		error = "A fit cannot be made of a search or a calibration sweep, or with order:mask\n";
+		return RETURN_SETUP_ERROR;
+	}
+
+	return RETURN_SUCCESS;
+}
+
+
+
+
+/*******************************************************************************
+* Function   : LoadResumeConfig()
+* Arguments  : file = file configuration
+*              freq, stim, input, output, trig, meas, dwell = receive the sweep configuration
+* Returns    : RETURN_SUCCESS = success, RETURN_CHECKPOINT_ERROR = failure
+* Description:
+*   A resumed sweep uses the settings stored in its checkpoint. Loads them,
+*   replacing the parsed configuration, if the file configuration is a resume.
+*/
+static int LoadResumeConfig(File_Config const& file, Freq_Config& freq, Stim_Config& stim, Channel_Config& input, Channel_Config& output, Trig_Config& trig, Meas_Config& meas, Dwell_Config& dwell)
+{
+	if (file.is_resume)
+	{
+		FRST unused;
+		double fUnused;
+
+		if (!SweepCheckpoint::Load(file.checkpoint, freq, stim, input, output, trig, meas, dwell, unused, fUnused))
+		{
+			std::cerr << "Unable to read checkpoint file \"" << file.checkpoint << "\"\n";
+			return RETURN_CHECKPOINT_ERROR;
+		}
+	}
+
 	return RETURN_SUCCESS;
 }
 
 
+/*******************************************************************************
+* Function   : OpenOutput()
+* Arguments  : writer = receives the output sinks
+*              file   = file configuration
+*              freq, stim, input, output, trig, meas, dwell = sweep configuration
+* Returns    : RETURN_SUCCESS = success, RETURN_(...) = failure
+* Description:
+*   Sets up the output sinks: the console (unless quiet), a log file, a
+*   binary file, and a shared memory ring. The caller starts the writer.
+*/
+static int OpenOutput(ResultWriter& writer, File_Config const& file, Freq_Config const& freq, Stim_Config const& stim, Channel_Config const& input, Channel_Config const& output, Trig_Config const& trig, Meas_Config const& meas, Dwell_Config const& dwell)
+{
+	if (file.is_echo)
+		writer.AddSink(make_unique<StreamSink>(std::cout));
+
+	if (!file.filename.empty())
+	{
+		// Check for extension/suffix .exe. Exit if it is .exe
+		if (str_compare_icase(get_suffix(file.filename), ".exe"))
+		{
+			std::cerr << "Blocked writing to .exe file \"" << file.filename << "\"\n";
+			return RETURN_BLOCKED_WRITE_EXE_FILE;
+		}
+
+		auto file_sink = make_unique<FileSink>();
+		if (!file_sink->Open(file.filename))
+		{
+			std::cerr << "Unable to open file \"" << file.filename << "\" for write.\n";
+			return RETURN_FILE_WRITE_ERROR;
+		}
+		writer.AddSink(std::move(file_sink));
+	}
+
+	if (!file.binfilename.empty())
+	{
+		if (str_compare_icase(get_suffix(file.binfilename), ".exe"))
+		{
+			std::cerr << "Blocked writing to .exe file \"" << file.binfilename << "\"\n";
+			return RETURN_BLOCKED_WRITE_EXE_FILE;
+		}
+
+		writer.AddSink(make_unique<BinarySink>(file.binfilename, freq, stim, input, output, trig, meas, dwell));
+	}
+
+	if (!file.shmname.empty())
+	{
+		auto shared_sink = make_unique<SharedSink>(freq, stim, input, output, trig, meas, dwell);
+		if (!shared_sink->Open(file.shmname))
+		{
+			std::cerr << "Unable to open shared memory ring \"" << file.shmname << "\"\n";
+			return RETURN_FILE_WRITE_ERROR;
+		}
+		writer.AddSink(std::move(shared_sink));
+	}
+
+	return RETURN_SUCCESS;
+}
+
+
+/*******************************************************************************
+* Function   : AttachResult()
+* Arguments  : nRetVal = result of MeasureResponseAttach()
+* Returns    : RETURN_SUCCESS = success, RETURN_(...) = failure
+* Description:
+*   Reports a failure to attach to the instruments
+*/
+static int AttachResult(FRRET nRetVal)
+{
+	switch (nRetVal)
+	{
+	case FRRET_SUCCESS:
+		return RETURN_SUCCESS;
+	case FRRET_INIT_OSCILLOSCOPE:
+		cerr << "Unable to connect to oscilloscope\n";
+		return RETURN_NO_CONNECT_OSCOPE;
+	case FRRET_INIT_SINEGEN:
+		cerr << "Unable to connecto to function generator\n";
+		return RETURN_NO_CONNECT_SINEGEN;
+	default:
+		cerr << "Unexpected error (" << nRetVal << ")\n";
+		return RETURN_ERROR;
+	}
+}
+
+
+/*******************************************************************************
+* Function   : StoreCalibration()
+* Arguments  : response = FreqResp that completed a sweep
+*              file     = file configuration
+* Returns    : RETURN_SUCCESS = success, RETURN_CALIBRATION_ERROR = failure
+* Description:
+*   Stores a completed calibration sweep in the bench calibration file
+*/
+static int StoreCalibration(FreqResp& response, File_Config const& file)
+{
+	if (file.is_calibrate && response.SaveCalibration(file.calfile.c_str()) < FRRET_SUCCESS)
+	{
+		cerr << "Unable to write calibration file \"" << file.calfile << "\"\n";
+		return RETURN_CALIBRATION_ERROR;
+	}
+
+	return RETURN_SUCCESS;
+}
+
+/*******************************************************************************
+* Function   : WriteModel()
+* Arguments  : response = FreqResp that completed (or stopped) a sweep
+*              writer   = started output writer
+* Returns    : none
+* Description:
+*   Writes the rational model fitted while sweeping as comment lines: the
+*   coefficients of num(s) and den(s) (ascending powers of s, in rad/s), the
+*   poles and zeros (rad/s), and the fit error
+*/
+static void WriteModel(FreqResp& response, ResultWriter& writer)
+{
+	FR_Model model;
+
+	if (!response.Model(model))
+		return;
+
+	// one line per record
+	auto writeLine = [&writer](ostringstream& oss)
+	{
+		oss << "\n";
+		writer.WriteText(oss.str().c_str());
+		oss.str("");
+	};
+
+	ostringstream oss;
+	oss.precision(8);
+
+	oss << "# model\t" << (model.converged ? "converged" : "not converged") << "\t" << model.nPoints << " points\t";
+	oss << model.rms_dB << "dB rms\t" << model.rms_deg << "deg rms";
+	writeLine(oss);
+
+	oss << "# num";
+	for (double coeff : model.num)
+		oss << "\t" << coeff;
+	writeLine(oss);
+
+	oss << "# den";
+	for (double coeff : model.den)
+		oss << "\t" << coeff;
+	writeLine(oss);
+
+	for (auto const& pole : model.poles)
+	{
+		oss << "# pole\t" << pole.real() << "\t" << pole.imag();
+		writeLine(oss);
+	}
+	for (auto const& zero : model.zeros)
+	{
+		oss << "# zero\t" << zero.real() << "\t" << zero.imag();
+		writeLine(oss);
+	}
+}
+
+
+/*******************************************************************************
+* Function   : WriteSorted()
+* Arguments  : response = FreqResp that completed (or stopped) a sweep
+*              writer   = started output writer
+* Returns    : none
+* Description:
+*   Writes the points of a sweep measured out of frequency order (see
+*   FreqResp::IsOrdered()) sorted by frequency, so the output files hold the
+*   same rows as a sweep measured in order
+*/
+static void WriteSorted(FreqResp& response, ResultWriter& writer)
+{
+	FRST points = response;
+
+	stable_sort(points.begin(), points.end(), [](FRS const& a, FRS const& b) { return a.freq < b.freq; });
+
+	for (auto const& point : points)
+		writer.WritePoint(point);
+}
+
+
+/*******************************************************************************
+* Function   : FinishSweep()
+* Arguments  : response = FreqResp that completed (or stopped) a sweep
+*              file     = file configuration
+*              writer   = started output writer
+*              bStopped = true if the sweep was stopped at a point outside the mask
+* Returns    : RETURN_SUCCESS = success, RETURN_MASK_FAIL = points outside the
+*              mask, RETURN_(...) = other failure
+* Description:
+*   Stores a calibration sweep, and writes the fitted model and the pass/fail
+*   result of a limit mask as comment lines
+*/
+static int FinishSweep(FreqResp& response, File_Config const& file, ResultWriter& writer, bool bStopped)
+{
+	if (!bStopped)
+	{
+		const int retval = StoreCalibration(response, file);
+		if (retval != RETURN_SUCCESS)
+			return retval;
+	}
+
+	WriteModel(response, writer);
+
+	if (file.maskfile.empty())
+		return RETURN_SUCCESS;
+
+	const unsigned int nFailures = response.MaskFailures();
+	if (nFailures == 0)
+	{
+		writer.WriteText("# mask\tpass\n");
+		return RETURN_SUCCESS;
+	}
+
+	ostringstream oss;
+	oss << "# mask\tfail\t" << nFailures << " point(s) outside" << (bStopped ? ", sweep stopped" : "") << "\n";
+	writer.WriteText(oss.str().c_str());
+
+	return RETURN_MASK_FAIL;
+}
+
+
+/*******************************************************************************
+* Function   : WriteCharacteristic()
+* Arguments  : writer = started output writer
+*              szName = name of the characteristic
+*              f      = frequency of the characteristic (NaN if not found)
+*              value  = value at f
+*              szUnit = unit of value
+* Returns    : none
+* Description:
+*   Writes one characteristic found by a search as a comment line
+*/
+static void WriteCharacteristic(ResultWriter& writer, char const* szName, double f, double value, char const* szUnit)
+{
+	ostringstream oss;
+	oss.precision(6);
+
+	oss << "# " << szName << "\t";
+	if (isnan(f))
+		oss << "not found\n";
+	else
+		oss << f << "\t" << value << szUnit << "\n";
+
+	writer.WriteText(oss.str().c_str());
+}
+
+
+/*******************************************************************************
+* Function   : RunSearch()
+* Arguments  : response = attached and configured FreqResp
+*              meas     = measurement configuration (the characteristics in search)
+*              writer   = started output writer, the header written
+* Returns    : RETURN_SUCCESS = success, RETURN_(...) = failure
+* Description:
+*   Searches for the characteristics of the response, then writes the points
+*   visited and the characteristics found
+*/
+static int RunSearch(FreqResp& response, Meas_Config const& meas, ResultWriter& writer)
+{
+	const Search_Config search = { meas.search, SEARCH_DB_CORNER, SEARCH_TOLERANCE, SEARCH_POINTS_MAX };
+	FR_Characteristics found;
+
+	FRRET nRetVal = response.Search(search, found);
+
+	switch (nRetVal)
+	{
+	case FRRET_COMPLETE:
+		break;
+	case FRRET_CONNECTION_LOST:
+		std::cerr << "Lost connection to the instruments and unable to reconnect\n";
+		return RETURN_CONNECTION_LOST;
+	default:
+		std::cerr << "Unexpected error (" << nRetVal << ")\n";
+		return RETURN_ERROR;
+	}
+
+	FRST const& visited = response;
+	for (auto const& point : visited)
+		writer.WritePoint(point);
+
+	if (meas.search & SEARCH_BANDWIDTH)
+		WriteCharacteristic(writer, "bandwidth", found.fCorner, found.dBref + SEARCH_DB_CORNER, "dB");
+	if (meas.search & SEARCH_PEAK)
+		WriteCharacteristic(writer, "peak", found.fPeak, found.dBpeak, "dB");
+	if (meas.search & SEARCH_CROSSOVER)
+		WriteCharacteristic(writer, "crossover", found.fCrossover, found.phaseMargin, "deg phase margin");
+
+	return RETURN_SUCCESS;
+}
+
+
+/*******************************************************************************
+* Function   : RunSweep()
+* Arguments  : response = attached and configured FreqResp
+*              file     = file configuration
+*              meas     = measurement configuration
+*              writer   = started output writer
+* Returns    : RETURN_SUCCESS = success, RETURN_(...) = failure
+* Description:
+*   Starts the checkpoint (or resumes from it), then measures every point of
+*   the sweep and writes the header and each point to the output. In
+*   hardware sweep mode the whole sweep is measured at once, falling back to
+*   point-by-point measurement if the sweep cannot be measured that way.
+*   The results are corrected with the bench calibration, or a calibration
+*   sweep is stored as the calibration of the setup. A search (search:) is
+*   measured instead of the sweep (see RunSearch()). With a limit mask, the
+*   sweep is stopped at the first point outside it unless onfail:continue.
+*   With a model fitted (fit:), the sweep ends once the model converges.
+*/
+static int RunSweep(FreqResp& response, File_Config const& file, Meas_Config const& meas, ResultWriter& writer)
+{
+	FRRET nRetVal;
+	FRS result;
+
+	if (!file.checkpoint.empty())
+	{
+		if (file.is_resume)
+			nRetVal = response.Resume(file.checkpoint.c_str());
+		else
+			nRetVal = response.Checkpoint(file.checkpoint.c_str());
+
+		if (nRetVal < FRRET_SUCCESS)
+		{
+			cerr << "Unable to " << (file.is_resume ? "resume from" : "write") << " checkpoint file \"" << file.checkpoint << "\"\n";
+			return RETURN_CHECKPOINT_ERROR;
+		}
+	}
+
+	// bench calibration: correct with it, or measure it (uncorrected)
+	nRetVal = response.UseCalibration(file.is_calibrate ? nullptr : file.calfile.c_str());
+	if (nRetVal == FRRET_INVALID_CALIBRATION)
+	{
+		cerr << "Unable to read calibration file \"" << file.calfile << "\"\n";
+		return RETURN_CALIBRATION_ERROR;
+	}
+	else if (nRetVal == FRRET_NO_CALIBRATION)
+	{
+		cerr << "Calibration file \"" << file.calfile << "\" has no calibration for this setup (measure it with calibrate:)\n";
+		return RETURN_CALIBRATION_ERROR;
+	}
+	else if (nRetVal == FRRET_CAL_EXTRAPOLATED)
+	{
+		cerr << "Sweep extends beyond the calibrated range, the end corrections are used outside it\n";
+	}
+
+	// limit mask: check every point against it
+	nRetVal = response.UseMask(file.maskfile.c_str(), file.is_mask_order);
+	if (nRetVal == FRRET_INVALID_MASK)
+	{
+		cerr << "Unable to read mask file \"" << file.maskfile << "\"\n";
+		return RETURN_MASK_ERROR;
+	}
+
+	// rational model: fit it while sweeping, and end the sweep once it converges
+	nRetVal = response.UseFit(meas.fit);
+	if (nRetVal == FRRET_INVALID_FIT)
+	{
+		cerr << "Unable to fit a model with " << meas.fit.nPoles << " pole(s) and " << meas.fit.nZeros << " zero(s)\n";
+		return RETURN_SETUP_ERROR;
+	}
+
+	// emit a header line
+	string strHeader = (meas.ttMeas == Ttype_t::DELAY) ? "freq\tinput\toutput\tgain\tdB\tdelay" : "freq\tinput\toutput\tgain\tdB\tphase";
+	if (meas.is_harmonics)
+		strHeader += "\tfund\th2_dBc\th3_dBc\th4_dBc\th5_dBc\tthd_dB\tthdn_dB";
+	writer.WriteText((strHeader + "\n").c_str());
+
+	if (meas.search != SEARCH_NONE)
+		return RunSearch(response, meas, writer);
+
+	// points measured out of frequency order are held back, and written sorted once the sweep ends
+	const bool bHold = response.IsOrdered();
+
+	// emit the points restored from a checkpoint
+	if (!bHold)
+	{
+		FRST const& restored = response;
+		for (auto const& point : restored)
+			writer.WritePoint(point);
+	}
+
+	if (meas.is_hwsweep && !file.is_resume)
+	{
+		nRetVal = response.HardwareSweep();
+		if (nRetVal == FRRET_COMPLETE)
+		{
+			FRST const& measured = response;
+			for (auto const& point : measured)
+				writer.WritePoint(point);
+			return FinishSweep(response, file, writer, false);
+		}
+		else if (nRetVal == FRRET_HW_SWEEP)
+		{
+			cerr << "Hardware sweep not possible for this sweep, measuring point by point\n";
+		}
+		else if (nRetVal == FRRET_CONNECTION_LOST)
+		{
+			std::cerr << "Lost connection to the instruments\n";
+			return RETURN_CONNECTION_LOST;
+		}
+	}
+
+	do
+	{
+		nRetVal = MeasureResponseNext(response, result);
+		if (nRetVal >= FRRET_SUCCESS && !bHold)
+		{
+			writer.WritePoint(result);
+		}
+
+	} while (nRetVal == FRRET_SUCCESS || (nRetVal == FRRET_MASK_FAIL && file.onfail == Fail_t::CONTINUE));  // will exit when FRRET_COMPLETE, or on an error
+
+	// the points measured, also when the sweep stopped early
+	if (bHold)
+		WriteSorted(response, writer);
+
+	switch (nRetVal)
+	{
+	case FRRET_COMPLETE:
+		return FinishSweep(response, file, writer, false);
+	case FRRET_MASK_FAIL:
+		return FinishSweep(response, file, writer, true);   // stopped at the first point outside the mask
+	case FRRET_CONNECTION_LOST:
+		std::cerr << "Lost connection to the instruments and unable to reconnect\n";
+		return RETURN_CONNECTION_LOST;
+	default:
+		std::cerr << "Unexpected error (" << nRetVal << ")\n";
+		return RETURN_ERROR;
+	}
+}
+
+
+/*******************************************************************************
+* Function   : StartSession()
+* Arguments  : response  = FreqResp kept attached between sweeps
+*              bAttached = true if response is already attached, updated on return
+*              szOscope  = oscilloscope resource
+*              szSigGen  = signal generator resource
+*              freq, stim, input, output, trig, meas, dwell = sweep configuration
+* Returns    : RETURN_SUCCESS = success, RETURN_(...) = failure
+* Description:
+*   Prepares a sweep in a session of several sweeps. The first sweep attaches
+*   to and sets up the instruments; each following sweep only applies the
+*   settings that changed (see FreqResp::Reconfigure).
+*/
+static int StartSession(FreqResp& response, bool& bAttached, char const* szOscope, char const* szSigGen, Freq_Config const& freq, Stim_Config const& stim, Channel_Config const& input, Channel_Config const& output, Trig_Config const& trig, Meas_Config const& meas, Dwell_Config const& dwell)
+{
+	int retval = RETURN_SUCCESS;
+
+	if (!bAttached)
+	{
+		// attach and set up the instruments
+		retval = AttachResult(MeasureResponseAttach(szOscope, szSigGen, response, freq, stim, input, output, trig, meas, dwell));
+		if (retval == RETURN_SUCCESS)
+			bAttached = true;
+		else
+			MeasureResponseClose(response);
+	}
+	else
+	{
+		// apply only the changes
+		FRRET nRetVal = response.Reconfigure(freq, stim, input, output, trig, meas, dwell);
+		if (nRetVal == FRRET_CONNECTION_LOST)
+		{
+			std::cerr << "Lost connection to the instruments\n";
+			retval = RETURN_CONNECTION_LOST;
+		}
+		else if (nRetVal < FRRET_SUCCESS)
+		{
+			std::cerr << "Unable to apply the configuration (" << nRetVal << ")\n";
+			retval = RETURN_SETUP_ERROR;
+		}
+	}
+
+	return retval;
+}
+
+
+/*******************************************************************************
+* Function   : TokenizeJobLine()
+* Arguments  : strLine = one line of a job file
+*              tokens  = receives the arguments on the line
+* Returns    : none
+* Description:
+*   Splits a job file line into arguments at white space, as the command line
+*   would be. Double quotes group text containing spaces and are removed.
+*   A # outside of quotes starts a comment that runs to the end of the line.
+*/
+static void TokenizeJobLine(string const& strLine, vector<string>& tokens)
+{
+	string strToken;
+	bool bInToken = false;
+	bool bQuoted = false;
+
+	tokens.clear();
+
+	for (char c : strLine)
+	{
+		if (c == '"')
+		{
+			bQuoted = !bQuoted;
+			bInToken = true;
+		}
+		else if (!bQuoted && c == '#')
+		{
+			break;
+		}
+		else if (!bQuoted && isspace((unsigned char)c))
+		{
+			if (bInToken)
+				tokens.push_back(strToken);
+			strToken.clear();
+			bInToken = false;
+		}
+		else
+		{
+			strToken += c;
+			bInToken = true;
+		}
+	}
+
+	if (bInToken)
+		tokens.push_back(strToken);
+}
 
 
 /*******************************************************************************
@@ -1006,12 +1772,41 @@ int MeasureResponse(int argc, char* argv[])
 		return RETURN_RESOURCE_ERROR;
 	}
 
+	// a powered-off instrument fails to attach after this time instead of the OS connect timeout
+	char szTimeout[MAX_RESULT_LENGTH + 1];
+	if (FResp_ReadRegSZ(REGISTRY_KEY, "ConnectTimeout", szTimeout, CONNECT_TIMEOUT_DEFAULT))
+	{
+		const unsigned long timeout_msec = strtoul(szTimeout, nullptr, 10);
+		if (timeout_msec > 0)
+			Socket_Instrument::SetConnectTimeout(timeout_msec);
+	}
+
+	const regex regex_job_spec("^(?:JOB|BATCH)(?::|=)\"?([^\"]+)\"?$", regex::icase);
+	const regex regex_serve_spec("^(?:SERVE|DAEMON)(?::|=)\"?([^\"]+)\"?$", regex::icase);
+	const regex regex_via_spec("^(?:VIA|CLIENT)(?::|=)\"?([^\"]+)\"?$", regex::icase);
+	smatch smMatch;
+	const string strArg1 = (argc >= 2) ? argv[1] : "";
 
 	if (argc < 2)
 	{
 		const string strProgName = (argc == 1) ? strip_path(argv[0]) : "FRESP.exe";
 		return ExitPrintUsage(strProgName);
 	}
+	else if (argc == 2 && regex_match(strArg1, smMatch, regex_job_spec))
+	{
+		const string strJobFile = smMatch[1];
+		return MeasureResponseBatch(strJobFile.c_str(), szOscope, szSigGen);
+	}
+	else if (argc == 2 && regex_match(strArg1, smMatch, regex_serve_spec))
+	{
+		const string strPath = smMatch[1];
+		return MeasureResponseServe(strPath.c_str(), szOscope, szSigGen);
+	}
+	else if (regex_match(strArg1, smMatch, regex_via_spec))
+	{
+		const string strPath = smMatch[1];
+		return MeasureResponseClient(strPath.c_str(), argc - 2, argv + 2);
+	}
 	else
 	{
 		string error;
@@ -1030,88 +1825,495 @@ int MeasureResponse(int argc, char* argv[])
 			return retval;
 		}
 
-		// setup dual stream output
-		//   one to std::cout
-		//   the other to either a log file or to a null_stream
-		ofstream my_file;
-		if (!file.filename.empty())
-		{
-			// Check for extension/suffix .exe. Exit if it is .exe
-			if (str_compare_icase(get_suffix(file.filename), ".exe"))
-			{
-				std::cerr << "Blocked writing to .exe file \"" << file.filename << "\"\n";
-				return RETURN_BLOCKED_WRITE_EXE_FILE;
-			}
+		// a resumed sweep uses the settings stored in its checkpoint
+		retval = LoadResumeConfig(file, freq, stim, input, output, trig, meas, dwell);
+		if (retval != RETURN_SUCCESS)
+			return retval;
 
-			my_file.open(file.filename, ios::out | ios::trunc);
-			if (!my_file.is_open())
-			{
-				std::cerr << "Unable to open file \"" << file.filename << "\" for write.\n";
-				return RETURN_FILE_WRITE_ERROR;
-			}
-		}
+		// setup the output sinks, written by a background thread
+		ResultWriter writer;
+		retval = OpenOutput(writer, file, freq, stim, input, output, trig, meas, dwell);
+		if (retval != RETURN_SUCCESS)
+			return retval;
 
-		EchoDualStream my_dualstream(file.is_echo ? std::cout : EchoDualStream::null_stream, my_file.is_open() ? my_file : EchoDualStream::null_stream);
+		writer.Start();
 
 #ifdef DEBUG_WITHOUT_INSTRUMENTS
-		my_dualstream << "Eleanor is sweet and Daddy loves her!!!\n";
-		my_dualstream << "Test 1, 2, 3\n";
+		writer.WriteText("Eleanor is sweet and Daddy loves her!!!\n");
+		writer.WriteText("Test 1, 2, 3\n");
 #else
-		FRRET nRetVal;
-		FRS result;
 		FreqResp response;
-		nRetVal = MeasureResponseAttach(szOscope, szSigGen, response, freq, stim, input, output, trig, meas, dwell);
+		retval = AttachResult(MeasureResponseAttach(szOscope, szSigGen, response, freq, stim, input, output, trig, meas, dwell));
+		if (retval != RETURN_SUCCESS)
+			return retval;
 
-		switch (nRetVal)
+		retval = RunSweep(response, file, meas, writer);
+		if (retval != RETURN_SUCCESS)
+			return retval;
+#endif
+
+		// wait for the output to be written
+		if (!writer.Stop())
 		{
-		case FRRET_SUCCESS:
+			std::cerr << "Unable to write the output files\n";
+			return RETURN_FILE_WRITE_ERROR;
+		}
+	}
+
+	return RETURN_SUCCESS;
+}
+
+
+/*******************************************************************************
+* Function   : MeasureResponseBatch()
+* Arguments  : szJobFile = job file, one sweep per line
+*              szOscope  = oscilloscope resource
+*              szSigGen  = signal generator resource
+* Returns    : 0 = success, otherwise the failure of the first job that failed
+* Description:
+*   Runs the sweeps listed in a job file back-to-back in one instrument
+*   session. Each line holds the arguments of one sweep, exactly as they
+*   would be given on the command line; blank lines and # comments are
+*   ignored. Every line is parsed before the instruments are touched, so a
+*   syntax error anywhere in the file runs nothing.
+*
+*   The instruments are attached and set up once, for the first job. Each
+*   following job only sends the settings that differ from the job before
+*   it (see FreqResp::Reconfigure). A failed job is reported and the next job
+*   is run, except after a lost connection, or a limit mask failure of a job
+*   with onfail:abort, which end the batch.
+*/
+int MeasureResponseBatch(char const* szJobFile, char const* szOscope, char const* szSigGen)
+{
+	struct Job
+	{
+		int nLine;
+		File_Config file;
+		Freq_Config freq;
+		Stim_Config stim;
+		Channel_Config input;
+		Channel_Config output;
+		Trig_Config trig;
+		Meas_Config meas;
+		Dwell_Config dwell;
+	};
+
+	vector<Job> jobs;
+	ifstream infile(szJobFile);
+	string strLine;
+	int nLine = 0;
+
+	if (!infile.is_open())
+	{
+		std::cerr << "Unable to open job file \"" << szJobFile << "\"\n";
+		return RETURN_JOB_ERROR;
+	}
+
+	// parse every job first
+	while (getline(infile, strLine))
+	{
+		vector<string> tokens;
+		vector<char*> args;
+		string error;
+		Job job;
+
+		nLine = nLine + 1;
+		TokenizeJobLine(strLine, tokens);
+		if (tokens.empty())
+			continue;
+
+		args.push_back(const_cast<char*>(szJobFile));   // in place of the program name
+		for (auto& token : tokens)
+			args.push_back(&token[0]);
+
+		job.nLine = nLine;
+		int retval = MeasureResponseParse(int(args.size()), args.data(), job.file, job.freq, job.stim, job.input, job.output, job.trig, job.meas, job.dwell, error);
+
+		switch (retval)
+		{
+		case RETURN_SUCCESS:
 			break;
-		case FRRET_INIT_OSCILLOSCOPE:
-			cerr << "Unable to connect to oscilloscope\n";
-			return RETURN_NO_CONNECT_OSCOPE;
-		case FRRET_INIT_SINEGEN:
-			cerr << "Unable to connecto to function generator\n";
-			return RETURN_NO_CONNECT_SINEGEN;
+		case RETURN_SYNTAX_ERROR:
+			std::cerr << szJobFile << "(" << nLine << "): syntax error with argument: \"" << error << "\"\n";
+			return RETURN_SYNTAX_ERROR;
 		default:
-			cerr << "Unexpected error (" << nRetVal << ")\n";
-			return RETURN_ERROR;
+			std::cerr << szJobFile << "(" << nLine << "): " << error;
+			return retval;
 		}
 
-		// emit a header line
-		my_dualstream << "freq\tinput\toutput\tgain\tdB\t";
-		if (meas.ttMeas == Ttype_t::DELAY)
-			my_dualstream << "delay";
-		else
-			my_dualstream << "phase";
-		my_dualstream << "\n";
+		retval = LoadResumeConfig(job.file, job.freq, job.stim, job.input, job.output, job.trig, job.meas, job.dwell);
+		if (retval != RETURN_SUCCESS)
+			return retval;
 
-		do
+		jobs.push_back(job);
+	}
+
+	if (jobs.empty())
+	{
+		std::cerr << "No jobs in job file \"" << szJobFile << "\"\n";
+		return RETURN_JOB_ERROR;
+	}
+
+	int nResult = RETURN_SUCCESS;
+
+#ifndef DEBUG_WITHOUT_INSTRUMENTS
+	FreqResp response;
+	bool bAttached = false;
+
+	for (auto const& job : jobs)
+	{
+		ResultWriter writer;
+		int retval = OpenOutput(writer, job.file, job.freq, job.stim, job.input, job.output, job.trig, job.meas, job.dwell);
+
+		if (retval == RETURN_SUCCESS)
 		{
-			nRetVal = MeasureResponseNext(response, result);
-			if (nRetVal >= FRRET_SUCCESS)
+			writer.Start();
+
+			retval = StartSession(response, bAttached, szOscope, szSigGen, job.freq, job.stim, job.input, job.output, job.trig, job.meas, job.dwell);
+			if (!bAttached)
+				return retval;   // unable to attach for the first job
+
+			if (retval == RETURN_SUCCESS)
+				retval = RunSweep(response, job.file, job.meas, writer);
+
+			if (!writer.Stop() && retval == RETURN_SUCCESS)
 			{
-				my_dualstream << result.freq << "\t" << result.mag_in << "\t" << result.mag_out << "\t" << (result.mag_out / result.mag_in) << "\t" << result.dBgain << "\t" << result.time << "\n";
+				std::cerr << "Unable to write the output files\n";
+				retval = RETURN_FILE_WRITE_ERROR;
 			}
+		}
 
-		} while (nRetVal == FRRET_SUCCESS);  // will exit when FRRET_COMPLETE, or on an error
+		if (retval != RETURN_SUCCESS)
+		{
+			std::cerr << szJobFile << "(" << job.nLine << "): job failed\n";
+			if (nResult == RETURN_SUCCESS)
+				nResult = retval;
+			if (retval == RETURN_CONNECTION_LOST)
+				break;
+			if (retval == RETURN_MASK_FAIL && job.file.onfail == Fail_t::ABORT)
+				break;
+		}
+	}
+#endif
+
+	return nResult;
+}
+
+/*******************************************************************************
+* Class      : ClientErrorBuffer
+* Description:
+*   Stream buffer that copies the error messages of a daemon request to the
+*   daemon's own error stream, and sends each line to the client as a comment
+*   line ("# "), so the client sees why its request failed. Installed in
+*   std::cerr for the length of one request.
+*
+*   While a result writer sends the output to the client, the lines go
+*   through its queue (see SendThrough()), so that only the writer thread
+*   sends on the socket and a line never lands in the middle of a result.
+*/
+class ClientErrorBuffer : public std::streambuf
+{
+public:
+	ClientErrorBuffer(LocalSocket& client, std::streambuf* pPrevious) : client(client), pPrevious(pPrevious), pWriter(nullptr), strLine() {}
+	~ClientErrorBuffer() { sync(); }
+
+	// the lines go through pWriter while it runs (nullptr: sent directly)
+	void SendThrough(ResultWriter* pWriter)
+	{
+		sync();
+		this->pWriter = pWriter;
+	}
+
+protected:
+	int overflow(int c) override
+	{
+		if (c == traits_type::eof())
+			return traits_type::not_eof(c);
+
+		if (pPrevious != nullptr)
+			pPrevious->sputc(char(c));
 
-		switch (nRetVal)
+		strLine += char(c);
+		if (c == '\n')
+			SendLine();
+
+		return c;
+	}
+
+	int sync() override
+	{
+		if (!strLine.empty())
 		{
-		case FRRET_COMPLETE:
+			strLine += '\n';
+			SendLine();
+		}
+
+		return (pPrevious != nullptr) ? pPrevious->pubsync() : 0;
+	}
+
+private:
+	LocalSocket& client;
+	std::streambuf* pPrevious;
+	ResultWriter* pWriter;
+	std::string strLine;
+
+	void SendLine()
+	{
+		const string strMessage = "# " + strLine;
+
+		if (pWriter != nullptr)
+			pWriter->WriteMessage(strMessage.c_str());
+		else
+			client.Send(strMessage);
+		strLine.clear();
+	}
+};
+
+
+/*******************************************************************************
+* Function   : ServeRequest()
+* Arguments  : client    = connected client
+*              errors    = error stream buffer of the request (sends to client)
+*              tokens    = arguments of the request
+*              response  = FreqResp kept attached between requests
+*              bAttached = true if response is attached, updated on return
+*              szOscope  = oscilloscope resource
+*              szSigGen  = signal generator resource
+* Returns    : RETURN_SUCCESS = success, RETURN_(...) = failure
+* Description:
+*   Runs one sweep requested by a daemon client, streaming the output lines
+*   to the client as they are measured. A quiet request sends no output
+*   lines; file and binary outputs are written by the daemon.
+*/
+static int ServeRequest(LocalSocket& client, ClientErrorBuffer& errors, vector<string>& tokens, FreqResp& response, bool& bAttached, char const* szOscope, char const* szSigGen)
+{
+	File_Config file;
+	Freq_Config freq;
+	Stim_Config stim;
+	Channel_Config input;
+	Channel_Config output;
+	Trig_Config trig;
+	Meas_Config meas;
+	Dwell_Config dwell;
+	vector<char*> args;
+	string error;
+
+	args.push_back(const_cast<char*>("daemon"));   // in place of the program name
+	for (auto& token : tokens)
+		args.push_back(&token[0]);
+
+	int retval = MeasureResponseParse(int(args.size()), args.data(), file, freq, stim, input, output, trig, meas, dwell, error);
+
+	switch (retval)
+	{
+	case RETURN_SUCCESS:
+		break;
+	case RETURN_SYNTAX_ERROR:
+		client.Send("# syntax error with argument: \"" + error + "\"\n");
+		return RETURN_SYNTAX_ERROR;
+	default:
+		client.Send("# " + error);
+		return retval;
+	}
+
+	retval = LoadResumeConfig(file, freq, stim, input, output, trig, meas, dwell);
+	if (retval != RETURN_SUCCESS)
+	{
+		client.Send("# Unable to read checkpoint file \"" + file.checkpoint + "\"\n");
+		return retval;
+	}
+
+	// the client receives the output in place of the console
+	const bool bEcho = file.is_echo;
+	file.is_echo = false;
+
+	ResultWriter writer;
+	retval = OpenOutput(writer, file, freq, stim, input, output, trig, meas, dwell);
+	if (retval != RETURN_SUCCESS)
+		return retval;
+	if (bEcho)
+		writer.AddSink(make_unique<SocketSink>(client));
+
+	writer.Start();
+
+	// the error messages follow the output through the writer thread
+	if (bEcho)
+		errors.SendThrough(&writer);
+
+	retval = StartSession(response, bAttached, szOscope, szSigGen, freq, stim, input, output, trig, meas, dwell);
+	if (retval == RETURN_SUCCESS)
+		retval = RunSweep(response, file, meas, writer);
+
+	// attach again on the next request
+	if (retval == RETURN_CONNECTION_LOST)
+	{
+		MeasureResponseClose(response);
+		bAttached = false;
+	}
+
+	errors.SendThrough(nullptr);
+	if (!writer.Stop() && retval == RETURN_SUCCESS)
+		retval = RETURN_FILE_WRITE_ERROR;
+
+	return retval;
+}
+
+
+/*******************************************************************************
+* Function   : MeasureResponseServe()
+* Arguments  : szPath   = local socket file to listen on
+*              szOscope = oscilloscope resource
+*              szSigGen = signal generator resource
+* Returns    : 0 = success (shut down by a client), non-zero = failure
+* Description:
+*   Runs the measurement daemon. The instruments are attached, set up, and
+*   given their first (discarded) measurement once, at start-up, and stay
+*   attached; each request then only applies the settings that changed.
+*
+*   Protocol (one client at a time, text lines):
+*     request   one line holding the arguments of a sweep, exactly as on the
+*               command line, or the single word shutdown
+*     response  the output lines as they are measured, messages prefixed
+*               with "# ", and a final line "= n" with the return code
+*/
+int MeasureResponseServe(char const* szPath, char const* szOscope, char const* szSigGen)
+{
+	LocalSocket server;
+	FreqResp response;
+	bool bAttached = false;
+
+	if (!server.Listen(szPath))
+	{
+		std::cerr << "Unable to listen on \"" << szPath << "\"\n";
+		return RETURN_DAEMON_ERROR;
+	}
+
+	// attach and warm up with the default settings, so that the first request
+	// does not pay for it (if this fails, the first request attaches again)
+	{
+		File_Config file;
+		Freq_Config freq;
+		Stim_Config stim;
+		Channel_Config input;
+		Channel_Config output;
+		Trig_Config trig;
+		Meas_Config meas;
+		Dwell_Config dwell;
+		char szProgName[] = "daemon";
+		char* args[] = { szProgName };
+		string error;
+
+		if (MeasureResponseParse(1, args, file, freq, stim, input, output, trig, meas, dwell, error) == RETURN_SUCCESS)
+			StartSession(response, bAttached, szOscope, szSigGen, freq, stim, input, output, trig, meas, dwell);
+	}
+
+	std::cerr << "Listening on \"" << szPath << "\"\n";
+
+	for (;;)
+	{
+		LocalSocket client;
+		string strRequest;
+		vector<string> tokens;
+
+		if (!server.Accept(client))
+		{
+			std::cerr << "Unable to accept a connection on \"" << szPath << "\"\n";
+			return RETURN_DAEMON_ERROR;
+		}
+
+		// a client that connects and sends nothing must not hold up the daemon
+		client.SetReceiveTimeout(DAEMON_REQUEST_TIMEOUT_MSEC);
+		if (!client.ReceiveLine(strRequest))
+			continue;
+		client.SetReceiveTimeout(0);
+
+		TokenizeJobLine(strRequest, tokens);
+
+		if (tokens.size() == 1 && str_compare_icase(tokens[0], "SHUTDOWN"))
+		{
+			client.Send("= 0\n");
 			break;
-		default:
-			std::cerr << "Unexpected error (" << nRetVal << ")\n";
-			return RETURN_ERROR;
 		}
-#endif
 
-		my_file.close();
+		int retval = RETURN_SYNTAX_ERROR;
+		if (tokens.empty())
+			client.Send("# empty request\n");
+		else
+		{
+			// the client also receives the error messages of its request
+			ClientErrorBuffer errors(client, std::cerr.rdbuf());
+			std::streambuf* pPrevious = std::cerr.rdbuf(&errors);
+			retval = ServeRequest(client, errors, tokens, response, bAttached, szOscope, szSigGen);
+			std::cerr.flush();
+			std::cerr.rdbuf(pPrevious);
+		}
+
+		if (retval != RETURN_SUCCESS)
+			client.Send("# request failed (" + to_string(retval) + ")\n");
+		client.Send("= " + to_string(retval) + "\n");
 	}
 
 	return RETURN_SUCCESS;
 }
 
 
+/*******************************************************************************
+* Function   : MeasureResponseClient()
+* Arguments  : szPath = local socket file of the daemon
+*              argc   = number of sweep arguments
+*              argv[] = sweep arguments (command-line syntax)
+* Returns    : the return code of the sweep, or RETURN_DAEMON_ERROR
+* Description:
+*   Sends a sweep to a running daemon (see MeasureResponseServe) and writes
+*   its output to the standard output as it is received.
+*/
+int MeasureResponseClient(char const* szPath, int argc, char* argv[])
+{
+	LocalSocket sock;
+	string strRequest;
+	string strLine;
+
+	if (!sock.Connect(szPath))
+	{
+		std::cerr << "Unable to connect to the measurement daemon at \"" << szPath << "\"\n";
+		return RETURN_DAEMON_ERROR;
+	}
+
+	// one line of arguments, quoted where they would not survive tokenizing
+	for (int i = 0; i < argc; ++i)
+	{
+		const string arg = argv[i];
+
+		if (i > 0)
+			strRequest += ' ';
+		if (arg.empty() || arg.find_first_of(" \t#") != string::npos)
+			strRequest += '"' + arg + '"';
+		else
+			strRequest += arg;
+	}
+	strRequest += '\n';
+
+	if (!sock.Send(strRequest))
+	{
+		std::cerr << "Unable to send to the measurement daemon\n";
+		return RETURN_DAEMON_ERROR;
+	}
+
+	while (sock.ReceiveLine(strLine))
+	{
+		if (strLine.compare(0, 2, "= ") == 0)
+			return atoi(strLine.c_str() + 2);
+		else if (strLine.compare(0, 2, "# ") == 0)
+			std::cerr << strLine.substr(2) << "\n";
+		else
+			std::cout << strLine << "\n";
+	}
+
+	std::cerr << "Lost connection to the measurement daemon\n";
+	return RETURN_DAEMON_ERROR;
+}
+
+
 int MeasureResponseAttach(char const* szOscope, char const* szSigGen, FreqResp& response, Freq_Config const& freq, Stim_Config const& stim, Channel_Config const& input, Channel_Config const& output, Trig_Config const& trig, Meas_Config const& meas, Dwell_Config const& dwell)
 {
 	return response.Init(szOscope, szSigGen, freq, stim, input, output, trig, meas, dwell);
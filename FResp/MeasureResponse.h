@@ -11,7 +11,7 @@
 *   generator and a Siglent oscilloscope.
 *
 * Created    : 07/03/2020
-* Modified   : 01/02/2023
+* Modified   : 10/16/2026
 * Author     : Kerry S. Martin, martin@wild-wood.net
 *******************************************************************************/
 #pragma once
@@ -27,10 +27,24 @@ constexpr auto RETURN_SETUP_ERROR = -6;
 constexpr auto RETURN_BLOCKED_WRITE_EXE_FILE = -7;
 constexpr auto RETURN_UNKNOWN_ERROR = -8;
 constexpr auto RETURN_RESOURCE_ERROR = -9;
+constexpr auto RETURN_CONNECTION_LOST = -10;
+constexpr auto RETURN_CHECKPOINT_ERROR = -11;
+constexpr auto RETURN_JOB_ERROR = -12;
+constexpr auto RETURN_DAEMON_ERROR = -13;
+constexpr auto RETURN_CALIBRATION_ERROR = -14;
+constexpr auto RETURN_MASK_FAIL = -15;
+constexpr auto RETURN_MASK_ERROR = -16;
 
 // automated full-response interface
 int MeasureResponse(int argc, char* argv[]);
 
+// many sweeps from a job file, in one instrument session
+int MeasureResponseBatch(char const* szJobFile, char const* szOscope, char const* szSigGen);
+
+// resident daemon keeping the instruments attached, and its client
+int MeasureResponseServe(char const* szPath, char const* szOscope, char const* szSigGen);
+int MeasureResponseClient(char const* szPath, int argc, char* argv[]);
+
 // semi-automatic/incremental response interface
 int MeasureResponseParse(int argc, char* argv[], File_Config& file,Freq_Config& freq, Stim_Config& stim, Channel_Config& input, Channel_Config& output, Trig_Config& trig,Meas_Config& meas, Dwell_Config& dwell,std::string& error);
 int MeasureResponseAttach(char const* szOscope, char const* szSigGen, FreqResp& response, Freq_Config const& freq, Stim_Config const& stim, Channel_Config const& input, Channel_Config const& output, Trig_Config const& trig, Meas_Config const& meas, Dwell_Config const& dwell);
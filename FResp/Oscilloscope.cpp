@@ -8,16 +8,48 @@
 *   Implements an interface to a Siglent SDS 1000 X-E oscilloscope.
 *
 * Created    : 05/25/2020
-* Modified   : 01/02/2023
+* Modified   : 10/16/2026
 * Author     : Kerry S. Martin, martin@wild-wood.net
 *******************************************************************************/
 
 #include <regex>
 #include <limits>
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdlib>
 #include "Oscilloscope.h"
 using namespace std;
 
 
+// command templates (see ScpiCommand.h)
+static constexpr auto TRMD = SCPI_TEMPLATE("TRMD {}");
+static constexpr auto TRCP = SCPI_TEMPLATE("TRCP {}");
+static constexpr auto TRSE_EDGE = SCPI_TEMPLATE("TRSE EDGE, SR, {}, HT, {}, HV, {}NS");
+static constexpr auto CH_TRLV = SCPI_TEMPLATE("{}:TRLV {}V");
+static constexpr auto CH_TRSL = SCPI_TEMPLATE("{}:TRSL {}");
+static constexpr auto CH_TRACE = SCPI_TEMPLATE("{}:TRACE {}");
+static constexpr auto CH_VDIV = SCPI_TEMPLATE("{}:VDIV {}");
+static constexpr auto CH_OFST = SCPI_TEMPLATE("{}:OFST {}V");
+static constexpr auto CH_BWL = SCPI_TEMPLATE("BWL {},{}");
+static constexpr auto CH_INVS = SCPI_TEMPLATE("{}:INVS {}");
+static constexpr auto CH_ATTN = SCPI_TEMPLATE("{}:ATTN {}");
+static constexpr auto CH_CPL = SCPI_TEMPLATE("{}:CPL {}");
+static constexpr auto CH_UNIT = SCPI_TEMPLATE("{}:UNIT {}");
+static constexpr auto CH_SKEW = SCPI_TEMPLATE("{}:SKEW {}");
+static constexpr auto CH_TRACE_Q = SCPI_TEMPLATE("{}:TRA?");
+static constexpr auto CH_ATTN_Q = SCPI_TEMPLATE("{}:ATTN?");
+static constexpr auto CH_VDIV_Q = SCPI_TEMPLATE("{}:VDIV?");
+static constexpr auto CH_OFST_Q = SCPI_TEMPLATE("{}:OFST?");
+static constexpr auto CH_PAVA_Q = SCPI_TEMPLATE("{}:PAVA? {}");
+static constexpr auto CH_MEAD_Q = SCPI_TEMPLATE("{}-{}:MEAD? {}");
+static constexpr auto SEQUENCE_ON = SCPI_TEMPLATE("SEQUENCE ON,{}");
+static constexpr auto FRAM = SCPI_TEMPLATE("FRAM {}");
+static constexpr auto SANU_Q = SCPI_TEMPLATE("SANU? {}");
+static constexpr auto WFSU = SCPI_TEMPLATE("WFSU SP,{},NP,{},FP,0");
+static constexpr auto CH_WF_Q = SCPI_TEMPLATE("{}:WF? DAT2");
+
+
 /*******************************************************************************
 * Class      : Oscilloscope
 * Member     : VoltagePairs[][] table
@@ -153,6 +185,62 @@ const unsigned int Oscilloscope::nTimePairs{ sizeof(TimePairs) / sizeof(TimePair
 const unsigned int Oscilloscope::nTimeDivisions{ 14 };
 
 
+/*******************************************************************************
+* Class      : Oscilloscope
+* Member     : MemDepthPairs[] table
+* Access     : private static constant
+* Arguments  : n/a
+* Returns    : n/a
+* Description:
+*   Table of acquisition memory depths, smallest first, with the number of
+*   points and the corresponding string
+*/
+const Oscilloscope::MemDepthPair Oscilloscope::MemDepthPairs[]
+{
+	{ MemDepth::M_14K,	1.4E+04, "14K" },
+	{ MemDepth::M_140K,	1.4E+05, "140K" },
+	{ MemDepth::M_1_4M,	1.4E+06, "1.4M" },
+	{ MemDepth::M_14M,	1.4E+07, "14M" }
+};
+
+
+/*******************************************************************************
+* Class      : Oscilloscope
+* Member     : nMemDepthPairs constant
+* Access     : private static constant
+* Arguments  : n/a
+* Returns    : n/a
+* Description:
+*   Number of entries in the MemDepthPairs[] table
+*/
+const unsigned int Oscilloscope::nMemDepthPairs{ sizeof(MemDepthPairs) / sizeof(MemDepthPair) };
+
+
+/*******************************************************************************
+* Class      : Oscilloscope
+* Member     : MAX_SAMPLE_RATE constant
+* Access     : private static constant
+* Arguments  : n/a
+* Returns    : n/a
+* Description:
+*   Highest sample rate (samples/second); more memory than this rate fills in
+*   one capture is not used
+*/
+const double Oscilloscope::MAX_SAMPLE_RATE{ 1.0E+09 };
+
+
+/*******************************************************************************
+* Class      : Oscilloscope
+* Member     : HOLDOFF_MAX constant
+* Access     : public static constant
+* Arguments  : n/a
+* Returns    : n/a
+* Description:
+*   Longest trigger holdoff time (seconds)
+*/
+const double Oscilloscope::HOLDOFF_MAX{ 1.5 };
+
+
 /*******************************************************************************
 * Class      : Oscilloscope
 * Member     : nVoltageDivisions constant
@@ -263,6 +351,66 @@ const Oscilloscope::MeasDelPair Oscilloscope::MeasDelPairs[]
 const unsigned int Oscilloscope::nMeasDelPairs{ sizeof(MeasDelPairs) / sizeof(MeasDelPair) };
 
 
+/*******************************************************************************
+* Class      : Oscilloscope
+* Member     : SetupChecks[] table
+* Access     : private static constant
+* Arguments  : n/a
+* Returns    : n/a
+* Description:
+*   Queries that fingerprint the default instrument state, with the value each
+*   should return (the text after the response header). A numeric expected
+*   value is compared numerically, ignoring any unit suffix; an expected value
+*   ending with * only has to match the start of the response.
+*
+*   Only settings that a measurement leaves at their defaults are checked.
+*   The time/division, memory depth, bandwidth limits, the trigger, and the
+*   scale, offset, coupling and attenuation of the channels are set for
+*   every measurement (and after every reconnection), so they are never at
+*   their defaults on a bench in use. The fast setup does not check or send
+*   them (see SetupOscilloscopeFast()). The traces are checked separately,
+*   one channel at a time.
+*/
+const Oscilloscope::SetupCheck Oscilloscope::SetupChecks[]
+{
+	{ SetupGroup::ACQUIRE,		"ACQW?",	"SAMPLING"		},
+	{ SetupGroup::ACQUIRE,		"SXSA?",	"ON"			},
+	{ SetupGroup::DISPLAY,		"XYDS?",	"OFF"			},
+	{ SetupGroup::DISPLAY,		"DTJN?",	"OFF"			},
+	{ SetupGroup::DISPLAY,		"PESU?",	"OFF"			},
+	{ SetupGroup::DISPLAY,		"MENU?",	"OFF"			},
+	{ SetupGroup::OVERLAY,		"CRMS?",	"OFF"			},
+	{ SetupGroup::OVERLAY,		"HSMD?",	"OFF"			},
+	{ SetupGroup::OVERLAY,		"DCST?",	"OFF"			},
+	{ SetupGroup::OVERLAY,		"DI:SW?",	"OFF"			},
+	{ SetupGroup::TIMEBASE,		"TRDL?",	"0"				},
+	{ SetupGroup::CH1,			"C1:INVS?",	"OFF"			},
+	{ SetupGroup::CH1,			"C1:UNIT?",	"V"				},
+	{ SetupGroup::CH1,			"C1:SKEW?",	"0"				},
+	{ SetupGroup::CH2,			"C2:INVS?",	"OFF"			},
+	{ SetupGroup::CH2,			"C2:UNIT?",	"V"				},
+	{ SetupGroup::CH2,			"C2:SKEW?",	"0"				},
+	{ SetupGroup::CH3,			"C3:INVS?",	"OFF"			},
+	{ SetupGroup::CH3,			"C3:UNIT?",	"V"				},
+	{ SetupGroup::CH3,			"C3:SKEW?",	"0"				},
+	{ SetupGroup::CH4,			"C4:INVS?",	"OFF"			},
+	{ SetupGroup::CH4,			"C4:UNIT?",	"V"				},
+	{ SetupGroup::CH4,			"C4:SKEW?",	"0"				}
+};
+
+
+/*******************************************************************************
+* Class      : Oscilloscope
+* Member     : nSetupChecks constant
+* Access     : private static constant
+* Arguments  : n/a
+* Returns    : n/a
+* Description:
+*   Number of entries in the SetupChecks[] table
+*/
+const unsigned int Oscilloscope::nSetupChecks{ sizeof(SetupChecks) / sizeof(SetupCheck) };
+
+
 /*******************************************************************************
 * Class      : Oscilloscope
 * Function   : GetChannel()
@@ -287,25 +435,25 @@ Oscilloscope::Channel Oscilloscope::GetChannel(int i)
 
 /*******************************************************************************
 * Class      : Oscilloscope
-* Function   : GetChannelString()
+* Function   : GetChannelName()
 * Access     : private static
 * Arguments  : ch = Channel enum
-* Returns    : string designation of channel
+* Returns    : designation of channel (static, not to be freed)
 * Description:
-*   Get the string designation for the given channel
+*   Get the designation for the given channel
 */
-string Oscilloscope::GetChannelString(Channel ch)
+char const* Oscilloscope::GetChannelName(Channel ch)
 {
 	switch (ch)
 	{
 	case Channel::CH1: default:
-		return string("C1");
+		return "C1";
 	case Channel::CH2:
-		return string("C2");
+		return "C2";
 	case Channel::CH3:
-		return string("C3");
+		return "C3";
 	case Channel::CH4:
-		return string("C4");
+		return "C4";
 	}
 }
 
@@ -320,7 +468,7 @@ string Oscilloscope::GetChannelString(Channel ch)
 *   Constructs a default (attached to no instrument) Oscilloscope object
 */
 Oscilloscope::Oscilloscope()
-	: Socket_Instrument()
+	: Socket_Instrument(), tdivSet(TimeDiv::UNSPEC), mdepthSet(MemDepth::UNSPEC), delaySet(DEFAULT_PARAM)
 {
 }
 
@@ -346,14 +494,38 @@ Oscilloscope::~Oscilloscope()
 * Arguments  : resource = resource identifier string for instrument
 * Returns    : true if successful (instrument was attached), false if not
 * Description:
-*   Attaches to an instrument using the given resource name
+*   Attaches to an instrument using the given resource name and puts it in
+*   the default instrument state
 */
 bool Oscilloscope::Attach(std::string resource)
 {
 	bool bResult = false;
 	if (Socket_Instrument::Attach(resource))
 	{
-		SetupOscilloscopeDefault();
+		SetupOscilloscope();
+		bResult = true;
+	}
+
+	return bResult;
+}
+
+
+/*******************************************************************************
+* Class      : Oscilloscope
+* Function   : Attach()
+* Access     : public
+* Arguments  : connection = attached connection to the instrument
+* Returns    : true if successful (instrument was attached), false if not
+* Description:
+*   Takes over a connection to the instrument (see ScopeDriver::Open()) and
+*   puts it in the default instrument state
+*/
+bool Oscilloscope::Attach(Socket_Instrument& connection)
+{
+	bool bResult = false;
+	if (Socket_Instrument::Adopt(connection))
+	{
+		SetupOscilloscope();
 		bResult = true;
 	}
 
@@ -376,6 +548,141 @@ bool Oscilloscope::Detach()
 }
 
 
+/*******************************************************************************
+* Class      : Oscilloscope
+* Function   : Reconnect()
+* Access     : public
+* Arguments  : none
+* Returns    : true if successful (instrument was re-attached), false if not
+* Description:
+*   Re-attaches to the instrument after a lost connection and puts it back in
+*   the default instrument state. The caller restores any other settings.
+*/
+bool Oscilloscope::Reconnect()
+{
+	bool bResult = false;
+	if (Socket_Instrument::Reconnect())
+	{
+		SetupOscilloscope();
+		bResult = true;
+	}
+
+	return bResult;
+}
+
+
+/*******************************************************************************
+* Class      : Oscilloscope
+* Function   : IsConnected()
+* Access     : public
+* Arguments  : none
+* Returns    : true if attached and communicating, false otherwise
+* Description:
+*   Reports whether the connection to the instrument is healthy
+*/
+bool Oscilloscope::IsConnected() const
+{
+	return Socket_Instrument::IsConnected();
+}
+
+
+/*******************************************************************************
+* Class      : Oscilloscope
+* Function   : SetupOscilloscope()
+* Access     : private
+* Arguments  : none
+* Returns    : none
+* Description:
+*   Puts the oscilloscope in the default instrument state, sending only the
+*   settings that differ from it when the current state can be read back.
+*   When the read back fails the connection is re-established, so that a late
+*   response cannot be taken for another, and every setting is sent.
+*/
+void Oscilloscope::SetupOscilloscope()
+{
+	// the capture settings of a newly attached instrument are not known
+	tdivSet = TimeDiv::UNSPEC;
+	mdepthSet = MemDepth::UNSPEC;
+	delaySet = DEFAULT_PARAM;
+
+	if (!SetupOscilloscopeFast())
+	{
+		// a fingerprint left unanswered marks the connection as lost: set up on a clean one
+		if (!Socket_Instrument::IsConnected())
+			Socket_Instrument::Reconnect();
+		SetupOscilloscopeDefault();
+	}
+}
+
+
+/*******************************************************************************
+* Class      : Oscilloscope
+* Function   : SetupOscilloscopeFast()
+* Access     : private
+* Arguments  : none
+* Returns    : true if the state was read back and the differences were sent,
+*              false if the state could not be read (nothing else is sent)
+* Description:
+*   Reads the SetupChecks[] fingerprint of the instrument state in a single
+*   pipelined batch, then sends the default settings only for the groups that
+*   differ. A bench left by the previous run is set up in about one round
+*   trip instead of several dozen commands. The settings every measurement
+*   configures itself (those not in SetupChecks[]) are left as they are, to
+*   be set by the caller. The trace of every channel is read in the same
+*   batch, and each channel found on is turned off, as the default setup
+*   does: a channel left on shares the sample rate and memory, and the caller
+*   turns on the channels it measures. A model that cannot pipeline queries
+*   (CAP_MULTI_QUERY) is not checked, since a query it leaves unanswered costs
+*   a full receive timeout.
+*/
+bool Oscilloscope::SetupOscilloscopeFast()
+{
+	vector<string> queries;
+	vector<string> responses;
+	bool bDiffers[static_cast<int>(SetupGroup::N_GROUPS)] = { false };
+
+	if (!Supports(CAP_MULTI_QUERY))
+		return false;
+
+	// response format (the checks expect the short header)
+	if (!Write("COMM_HEADER SHORT"))
+		return false;
+
+	for (unsigned int i = 0; i < nSetupChecks; ++i)
+		queries.push_back(SetupChecks[i].query);
+	for (int i = 1; i <= 4; ++i)
+		queries.push_back(cmd.Format(CH_TRACE_Q, GetChannelName(GetChannel(i))).str());
+
+	if (!QueryBatch(queries, responses))
+		return false;
+
+	for (unsigned int i = 0; i < nSetupChecks; ++i)
+	{
+		if (!SetupValueMatches(responses[i], SetupChecks[i].expected))
+			bDiffers[static_cast<int>(SetupChecks[i].group)] = true;
+	}
+
+	// settings that cannot be read back are always sent
+	bDiffers[static_cast<int>(SetupGroup::UNCHECKED)] = true;
+
+	for (int g = 0; g < static_cast<int>(SetupGroup::N_GROUPS); ++g)
+	{
+		if (bDiffers[g])
+			SetupGroupDefault(static_cast<SetupGroup>(g));
+	}
+
+	// a channel still on (its group was not sent, which turns it off)
+	for (int i = 1; i <= 4; ++i)
+	{
+		const int g = static_cast<int>(SetupGroup::CH1) + i - 1;
+		if (!bDiffers[g] && !SetupValueMatches(responses[nSetupChecks + i - 1], "OFF"))
+			SetChannelEnable(GetChannel(i), false);
+	}
+
+	return true;
+}
+
+
 /*******************************************************************************
 * Class      : Oscilloscope
 * Function   : SetupOscilloscopeDefault()
@@ -383,72 +690,139 @@ bool Oscilloscope::Detach()
 * Arguments  : none
 * Returns    : none
 * Description:
-*   Puts the oscilloscope in a default instrument state
+*   Puts the oscilloscope in a default instrument state, sending every setting
 */
 void Oscilloscope::SetupOscilloscopeDefault()
 {
 	// response format
 	Write("COMM_HEADER SHORT");
 
-	// acquire
-	Write("ACQUIRE_WAY SAMPLING");
-	Write("MEMORY_SIZE 14M");
-	Write("SINXX_SAMPLE ON");
+	for (int g = 0; g < static_cast<int>(SetupGroup::N_GROUPS); ++g)
+		SetupGroupDefault(static_cast<SetupGroup>(g));
+}
+
+
+/*******************************************************************************
+* Class      : Oscilloscope
+* Function   : SetupGroupDefault()
+* Access     : private
+* Arguments  : group = group of settings to send
+* Returns    : none
+* Description:
+*   Sends the default instrument state for one group of settings
+*/
+void Oscilloscope::SetupGroupDefault(SetupGroup group)
+{
+	switch (group)
+	{
+	case SetupGroup::ACQUIRE:
+		Write("ACQUIRE_WAY SAMPLING");
+		SetMemoryDepth(MemDepth::M_14M);
+		Write("SINXX_SAMPLE ON");
+		break;
 
-	// display
-	Write("XY_DISPLAY OFF");
-	Write("DTJN OFF"); // vectors
-	Write("PESU OFF"); // persistence off
-	Write("MENU OFF");
+	case SetupGroup::DISPLAY:
+		Write("XY_DISPLAY OFF");
+		Write("DTJN OFF"); // vectors
+		Write("PESU OFF"); // persistence off
+		Write("MENU OFF");
+		break;
 
-	// zoom off
-	// TODO: oscope SCPI command set currently does not support changing zoom on/off (fix this if the support is added)
+	case SetupGroup::OVERLAY:
+		// zoom off
+		// TODO: oscope SCPI command set currently does not support changing zoom on/off (fix this if the support is added)
+		Write("CRMS OFF"); // cursors off
+		Write("HSMD OFF"); // history off
+		Write("DCST OFF"); // decode off
+		Write("DI:SWITCH OFF"); // digital off
+		break;
 
-	// cursors
-	Write("CRMS OFF"); // cursors off
+	case SetupGroup::UNCHECKED:
+		Write("MATH:TRACE OFF");
+		Write("MEASURE_CLEAR");
+		Write("REF_CLOSE"); // turn reference off
+		break;
 
-	// history
-	Write("HSMD OFF"); // history off
+	case SetupGroup::TIMEBASE:
+		SetTimebase(TimeDiv::T_1mS, 0.0);
+		break;
 
-	// decode
-	Write("DCST OFF"); // decode off
+	case SetupGroup::BANDWIDTH:
+	{
+		const vector< ChBWLPair> ch_bwl_pairs = { {Channel::CH1, BWLimit::BWL_FULL}, {Channel::CH2, BWLimit::BWL_FULL}, {Channel::CH3, BWLimit::BWL_FULL}, {Channel::CH4, BWLimit::BWL_FULL} };
+		SetChannelBWL(ch_bwl_pairs);
+		break;
+	}
 
-	// digital
-	Write("DI:SWITCH OFF");
+	case SetupGroup::CH1:
+	case SetupGroup::CH2:
+	case SetupGroup::CH3:
+	case SetupGroup::CH4:
+	{	// vertical, channel off
+		const Channel ch = GetChannel(1 + static_cast<int>(group) - static_cast<int>(SetupGroup::CH1));
+		SetChannelEx(ch, false, VoltsPerDiv::V_1V, 0.0, Coupling::DC, BWLimit::UNSPEC, ChAtten::AT_10X, ChInvert::INV_OFF);  // BWL set by its own group
+		SetChannelUnit(ch, ChUnit::V);
+		SetChannelSkew(ch, 0.0);
+		break;
+	}
 
-	// math
-	Write("MATH:TRACE OFF");
+	case SetupGroup::TRIGGER:
+		// trigger = Auto, DC, Edge-triggered, CH1 rising @ 0V, no holdoff
+		SetEdgeTrigger(Channel::CH1, EdgeType::RISING, 0.0, Coupling::DC, false, 0.0);
+		SetTriggerMode(TriggerMode::AUTO);
+		break;
 
-	// measure
-	Write("MEASURE_CLEAR");
+	default:
+		break;
+	}
+}
 
-	// reference
-	Write("REF_CLOSE"); // turn reference off
 
-	// timebase
-	SetTimebase(TimeDiv::T_1mS, 0.0);
+/*******************************************************************************
+* Class      : Oscilloscope
+* Function   : SetupValueMatches()
+* Access     : private static
+* Arguments  : response = response to a SetupChecks[] query, with short header
+*              expected = expected value from the SetupChecks[] table
+* Returns    : true if the response has the expected value
+* Description:
+*   Compares the value part of a query response (after the header) with the
+*   expected value. Text is compared without regard to case; a numeric
+*   expected value is compared numerically, so 1.00E+00V matches 1.
+*/
+bool Oscilloscope::SetupValueMatches(std::string const& response, char const* expected)
+{
+	const size_t begin = response.find(' ');
+	if (begin == string::npos)
+		return false;
 
-	// bandwidth limit
-	const vector< ChBWLPair> ch_bwl_pairs = { {Channel::CH1, BWLimit::BWL_FULL}, {Channel::CH2, BWLimit::BWL_FULL}, {Channel::CH3, BWLimit::BWL_FULL}, {Channel::CH4, BWLimit::BWL_FULL} };
-	SetChannelBWL(ch_bwl_pairs);
+	size_t end = response.find_last_not_of(" \r\n");
+	if (end == string::npos || end <= begin)
+		return false;
 
-	// vertical (channel 1 and channel 2 on)
-	for (int i = 1; i <= 4; ++i)
+	string value = response.substr(begin + 1, end - begin);
+	for (auto& c : value)
+		c = (char)toupper((unsigned char)c);
+
+	string strExpected(expected);
+	if (!strExpected.empty() && strExpected.back() == '*')
 	{
-		const Channel ch = GetChannel(i);
-		SetChannelEx(ch, false, VoltsPerDiv::V_1V, 0.0, Coupling::DC, BWLimit::UNSPEC, ChAtten::AT_10X, ChInvert::INV_OFF);  // BWL already set
-		SetChannelUnit(ch, ChUnit::V);
-		SetChannelSkew(ch, 0.0);
-		if (i > 2)
-		{
-			// turn off channels 3 and 4
-			SetChannelEnable(ch, false);
-		}
+		strExpected.pop_back();
+		return value.compare(0, strExpected.length(), strExpected) == 0;
+	}
+
+	char* pEnd;
+	const double vExpected = strtod(expected, &pEnd);
+	if (pEnd != expected && *pEnd == '\0')
+	{
+		const char* szValue = value.c_str();
+		const double vActual = strtod(szValue, &pEnd);
+		if (pEnd == szValue)
+			return false;
+		return fabs(vActual - vExpected) <= 1.0e-6 * max(fabs(vActual), fabs(vExpected)) + 1.0e-15;
 	}
 
-	// trigger = Auto, DC, Edge-triggered, CH1 rising @ 0V, no holdoff
-	SetEdgeTrigger(Channel::CH1, EdgeType::RISING, 0.0, Coupling::DC, false, 0.0);
-	SetTriggerMode(TriggerMode::AUTO);
+	return value == strExpected;
 }
 
 
@@ -464,25 +838,25 @@ void Oscilloscope::SetupOscilloscopeDefault()
 bool Oscilloscope::SetTriggerMode(TriggerMode mode)
 {
 	bool bResult;
-	string strTrigMode;
+	char const* szTrigMode;
 
 	switch (mode)
 	{
 	case TriggerMode::STOP:
-		strTrigMode = "STOP";
+		szTrigMode = "STOP";
 		break;
 	case TriggerMode::NORMAL:
-		strTrigMode = "NORM";
+		szTrigMode = "NORM";
 		break;
 	case TriggerMode::AUTO: default:
-		strTrigMode = "AUTO";
+		szTrigMode = "AUTO";
 		break;
 	case TriggerMode::SINGLE:
-		strTrigMode = "SINGLE";
+		szTrigMode = "SINGLE";
 		break;
 	}
 
-	bResult = Write("TRMD " + strTrigMode);
+	bResult = Write(cmd.Format(TRMD, szTrigMode));
 
 	return bResult;
 }
@@ -505,17 +879,17 @@ bool Oscilloscope::SetTriggerMode(TriggerMode mode)
 bool Oscilloscope::SetEdgeTrigger(Channel ch, EdgeType edge, double voltage, Coupling coup, bool holdoff, double tHoldoff)
 {
 	bool bResult = true;
-	const string strCh = GetChannelString(ch);
-	string strCoup;
-	string strHoldoff;
-	string strHoldValue;
-	string strEdge;
+	char const* const szCh = GetChannelName(ch);
+	char const* szCoup;
+	char const* szHoldoff;
+	double nsHoldValue;
+	char const* szEdge;
 	string strResponse;  // response from query
 	double attn = 1.0;
 
 	// trigger voltage is at 1x probe attenuation
 	// read the probe attenuation and scale accordingly
-	if (Query(strCh + ":ATTN?", strResponse))
+	if (Query(cmd.Format(CH_ATTN_Q, szCh), strResponse))
 	{
 		// format should be C#:ATT(eNuation) xxxx\n
 		smatch smMatch;
@@ -540,48 +914,63 @@ bool Oscilloscope::SetEdgeTrigger(Channel ch, EdgeType edge, double voltage, Cou
 		switch (coup)
 		{
 		case Coupling::AC: default:
-			strCoup = "AC";
+			szCoup = "AC";
 			break;
 		case Coupling::DC:
-			strCoup = "DC";
+			szCoup = "DC";
 			break;
 		}
 
 		switch (holdoff)
 		{
 		case true:
-			strHoldoff = "ON";
-			strHoldValue = to_string(tHoldoff * 1.0e9) + "NS";
+			szHoldoff = "ON";
+			nsHoldValue = tHoldoff * 1.0e9;
 			break;
 		case false:
-			strHoldoff = "OFF";
-			strHoldValue = "80NS";
+			szHoldoff = "OFF";
+			nsHoldValue = 80.0;
 			break;
 		}
 
 		switch (edge)
 		{
 		case EdgeType::RISING: default:
-			strEdge = "POS";
+			szEdge = "POS";
 			break;
 		case EdgeType::FALLING:
-			strEdge = "NEG";
+			szEdge = "NEG";
 			break;
 		}
 
-		bResult = Write("TRCP " + strCoup);
+		bResult = Write(cmd.Format(TRCP, szCoup));
 		if (bResult)
-			bResult = Write(strCh + ":TRLV " + to_string(voltage / attn) + "V");
+			bResult = Write(cmd.Format(CH_TRLV, szCh, voltage / attn));
 		if (bResult)
-			bResult = Write("TRSE EDGE, SR, " + strCh + ", HT, " + strHoldoff + ", HV, " + strHoldValue);
+			bResult = Write(cmd.Format(TRSE_EDGE, szCh, szHoldoff, nsHoldValue));
 		if (bResult)
-			bResult = Write(strCh + ":TRSL " + strEdge);
+			bResult = Write(cmd.Format(CH_TRSL, szCh, szEdge));
 	}
 
 	return bResult;
 }
 
 
+/*******************************************************************************
+* Class      : Oscilloscope
+* Function   : HoldoffMax()
+* Access     : public
+* Arguments  : none
+* Returns    : longest trigger holdoff (seconds)
+* Description:
+*   Returns HOLDOFF_MAX, the longest trigger holdoff of the model
+*/
+double Oscilloscope::HoldoffMax() const
+{
+	return HOLDOFF_MAX;
+}
+
+
 /*******************************************************************************
 * Class      : Oscilloscope
 * Function   : SetChannelEnable()
@@ -594,13 +983,7 @@ bool Oscilloscope::SetEdgeTrigger(Channel ch, EdgeType edge, double voltage, Cou
 */
 bool Oscilloscope::SetChannelEnable(Channel ch, bool enabled)
 {
-	bool bResult = false;
-	const string strCh = GetChannelString(ch);
-
-	if (enabled)
-		bResult = Write(strCh + ":TRACE ON");
-	else
-		bResult = Write(strCh + ":TRACE OFF");
+	bool bResult = Write(cmd.Format(CH_TRACE, GetChannelName(ch), enabled ? "ON" : "OFF"));
 
 	return bResult;
 }
@@ -620,8 +1003,6 @@ bool Oscilloscope::SetChannelEnable(Channel ch, bool enabled)
 */
 bool Oscilloscope::SetChannelVolts(Channel ch, VoltsPerDiv vdiv, double offset)
 {
-	const string strCh = GetChannelString(ch);
-
 	bool bResult = true;
 
 	const double vAtten = ReadChannelAtten(ch);
@@ -638,7 +1019,7 @@ bool Oscilloscope::SetChannelVolts(Channel ch, VoltsPerDiv vdiv, double offset)
 			{
 				if (vdiv == VoltagePairs[iPairTable][i].vdiv)
 				{
-					bResult = Write(strCh + ":VDIV " + string(VoltagePairs[iPairTable][i].str));
+					bResult = Write(cmd.Format(CH_VDIV, GetChannelName(ch), VoltagePairs[iPairTable][i].str));
 					break;
 				}
 			}
@@ -670,13 +1051,12 @@ bool Oscilloscope::SetChannelVolts(Channel ch, VoltsPerDiv vdiv, double offset)
 bool Oscilloscope::SetChannelVoltsEx(Channel ch, double vdiv, double offset)
 {
 	bool bResult = false;
-	const string strCh = GetChannelString(ch);
 	const double unscaled = vdiv/ReadChannelAtten(ch);
 
 	// check that vdiv makes sense... positive and results within oscilloscope input range
 	if (vdiv > 0.0 && unscaled>=vUnscaledMin && unscaled<=vUnscaledMax)
 	{
-		bResult = Write(strCh + ":VDIV " + to_string(vdiv));
+		bResult = Write(cmd.Format(CH_VDIV, GetChannelName(ch), vdiv));
 
 		if (bResult)
 			bResult = SetChannelOffset(ch, offset);
@@ -699,10 +1079,9 @@ bool Oscilloscope::SetChannelVoltsEx(Channel ch, double vdiv, double offset)
 bool Oscilloscope::SetChannelOffset(Channel ch, double offset)
 {
 	bool bResult = false;
-	const string strCh = GetChannelString(ch);
 
 	if (!isnan(offset))
-		bResult = Write(strCh + ":OFST " + to_string(offset) + "V");
+		bResult = Write(cmd.Format(CH_OFST, GetChannelName(ch), offset));
 	else
 		bResult = false;
 
@@ -723,15 +1102,15 @@ bool Oscilloscope::SetChannelOffset(Channel ch, double offset)
 bool Oscilloscope::SetChannelBWL(Channel ch, BWLimit bwl)
 {
 	bool bResult = false;
-	const string strCh = GetChannelString(ch);
+	char const* const szCh = GetChannelName(ch);
 
 	switch (bwl)
 	{
 	case BWLimit::BWL_FULL:
-		bResult = Write("BWL " + strCh + ",OFF");
+		bResult = Write(cmd.Format(CH_BWL, szCh, "OFF"));
 		break;
 	case BWLimit::BWL_ON:
-		bResult = Write("BWL " + strCh + ",ON");
+		bResult = Write(cmd.Format(CH_BWL, szCh, "ON"));
 		break;
 	}
 	return bResult;
@@ -750,30 +1129,19 @@ bool Oscilloscope::SetChannelBWL(Channel ch, BWLimit bwl)
 bool Oscilloscope::SetChannelBWL(const vector<ChBWLPair> pairs)
 {
 	bool bResult = false;
-	string strCmdArg = "";   // build this from the pairs
+
+	cmd.Clear().Append("BWL");   // build this from the pairs
 
 	vector<ChBWLPair>::const_iterator pcb;
 
 	for (pcb = pairs.cbegin(); pcb < pairs.cend(); ++pcb)
 	{
-		Channel ch = pcb->ch;
-		BWLimit bwl = pcb->bwl;
-		const string strCh = GetChannelString(ch);
-		string strPair = "";
-
-		if (bwl== BWLimit::BWL_ON)
-			strPair =  strCh + ",ON";
-		else
-			strPair =  strCh + ",OFF";
-
-		if (strCmdArg.empty())
-			strCmdArg = strPair;
-		else
-			strCmdArg = strCmdArg + "," + strPair;
+		cmd.Append((pcb == pairs.cbegin()) ? ' ' : ',');
+		cmd.Append(GetChannelName(pcb->ch)).Append((pcb->bwl == BWLimit::BWL_ON) ? ",ON" : ",OFF");
 	}
 
-	if (!strCmdArg.empty())
-		bResult = Write("BWL " + strCmdArg);
+	if (!pairs.empty())
+		bResult = Write(cmd);
 
 	return bResult;
 }
@@ -792,15 +1160,15 @@ bool Oscilloscope::SetChannelBWL(const vector<ChBWLPair> pairs)
 bool Oscilloscope::SetChannelInvert(Channel ch, ChInvert inv)
 {
 	bool bResult = false;
-	const string strCh = GetChannelString(ch);
+	char const* const szCh = GetChannelName(ch);
 
 	switch (inv)
 	{
 	case ChInvert::INV_OFF:
-		bResult = Write(strCh + ":INVS OFF");
+		bResult = Write(cmd.Format(CH_INVS, szCh, "OFF"));
 		break;
 	case ChInvert::INV_ON:
-		bResult = Write(strCh + ":INVS ON");
+		bResult = Write(cmd.Format(CH_INVS, szCh, "ON"));
 		break;
 	}
 
@@ -821,15 +1189,15 @@ bool Oscilloscope::SetChannelInvert(Channel ch, ChInvert inv)
 bool Oscilloscope::SetChannelAtten(Channel ch, ChAtten atten)
 {
 	bool bResult = false;
-	const string strCh = GetChannelString(ch);
+	char const* const szCh = GetChannelName(ch);
 
 	switch (atten)
 	{
 	case ChAtten::AT_10X:
-		bResult = Write(strCh + ":ATTN 10");
+		bResult = Write(cmd.Format(CH_ATTN, szCh, 10));
 		break;
 	case ChAtten::AT_1X:
-		bResult = Write(strCh + ":ATTN 1");
+		bResult = Write(cmd.Format(CH_ATTN, szCh, 1));
 		break;
 	}
 
@@ -850,15 +1218,15 @@ bool Oscilloscope::SetChannelAtten(Channel ch, ChAtten atten)
 bool Oscilloscope::SetChannelCoupling(Channel ch, Coupling coup)
 {
 	bool bResult = false;
-	const string strCh = GetChannelString(ch);
+	char const* const szCh = GetChannelName(ch);
 
 	switch (coup)
 	{
 	case Coupling::DC:
-		bResult = Write(strCh + ":CPL D1M");
+		bResult = Write(cmd.Format(CH_CPL, szCh, "D1M"));
 		break;
 	case Coupling::AC:
-		bResult = Write(strCh + ":CPL A1M");
+		bResult = Write(cmd.Format(CH_CPL, szCh, "A1M"));
 		break;
 	}
 
@@ -879,15 +1247,15 @@ bool Oscilloscope::SetChannelCoupling(Channel ch, Coupling coup)
 bool Oscilloscope::SetChannelUnit(Channel ch, ChUnit unit)
 {
 	bool bResult = false;
-	const string strCh = GetChannelString(ch);
+	char const* const szCh = GetChannelName(ch);
 
 	switch (unit)
 	{
 	case ChUnit::V:
-		bResult = Write(strCh + ":UNIT V");
+		bResult = Write(cmd.Format(CH_UNIT, szCh, "V"));
 		break;
 		//case ChUnit::A:  // TODO: implement A eventually
-		//	Write(strCh + ":UNIT A");
+		//	Write(cmd.Format(CH_UNIT, szCh, "A"));
 		//	break;
 	}
 
@@ -908,12 +1276,11 @@ bool Oscilloscope::SetChannelUnit(Channel ch, ChUnit unit)
 bool Oscilloscope::SetChannelSkew(Channel ch, double skew)
 {
 	bool bResult = true;
-	const string strCh = GetChannelString(ch);
 
 	if (!isnan(skew))
 	{
 		if (skew >= -100.0e-9 && skew <= 100.0e-9)
-			bResult = Write(strCh + ":SKEW " + to_string(skew));
+			bResult = Write(cmd.Format(CH_SKEW, GetChannelName(ch), skew));
 		else
 			bResult = false;
 	}
@@ -945,7 +1312,6 @@ bool Oscilloscope::SetChannelSkew(Channel ch, double skew)
 bool Oscilloscope::SetChannelEx(Channel ch, bool enabled, VoltsPerDiv vdiv, double offset, Coupling coup, BWLimit bwl, ChAtten atten, ChInvert inv)
 {
 	bool bResult = true;
-	const string strCh = GetChannelString(ch);
 
 	if (bResult && inv != ChInvert::UNSPEC)			bResult = SetChannelInvert(ch, inv);
 	if (bResult && atten != ChAtten::UNSPEC)		bResult = SetChannelAtten(ch, atten);
@@ -1015,7 +1381,7 @@ int Oscilloscope::AdjustChannelVolts(Channel ch, int adjust, ScaleValues& scale)
 	int iAdjActual = adjust;
 	bool bNoIssues = true;
 
-	const string strCh = GetChannelString(ch);
+	char const* const szCh = GetChannelName(ch);
 	string strResponse;
 	smatch smMatch;
 
@@ -1033,14 +1399,14 @@ int Oscilloscope::AdjustChannelVolts(Channel ch, int adjust, ScaleValues& scale)
 		iAdjActual = 3;
 
 	// get the channel voltage scale and ofset
-	if (Query(strCh + ":VDIV?", strResponse))
+	if (Query(cmd.Format(CH_VDIV_Q, szCh), strResponse))
 	{
 		if (regex_match(strResponse, smMatch, regex("^C[1-4]\\:V[A-Z_]+ ([\\+\\-\\.0-9E]+)(?:V|A)\n$", regex::icase)))
 		{
 			scale.vdiv = stod(smMatch[1]);
 		}
 
-		if (Query(strCh + ":OFST?", strResponse))
+		if (Query(cmd.Format(CH_OFST_Q, szCh), strResponse))
 		{
 			if (regex_match(strResponse, smMatch, regex("^C[1-4]\\:O[A-Z]+ ([\\+\\-\\.0-9E]+)(?:V|A)\n$", regex::icase)))
 			{
@@ -1132,11 +1498,10 @@ int Oscilloscope::AdjustChannelVolts(Channel ch, int adjust, ScaleValues& scale)
 */
 double Oscilloscope::ReadChannelAtten(Channel ch)
 {
-	const string strCh = GetChannelString(ch);
 	string strAtten;
 	smatch smMatch;
 
-	Query(strCh + ":ATTN?", strAtten);
+	Query(cmd.Format(CH_ATTN_Q, GetChannelName(ch)), strAtten);
 	// response format = "Cn:ATTN vv\n"
 	if (regex_match(strAtten, smMatch, regex("^C[1-4]:ATTN ([0-9.]+)\n")))
 		return stod(smMatch[1]);
@@ -1158,29 +1523,10 @@ double Oscilloscope::ReadChannelAtten(Channel ch)
 double Oscilloscope::Measure(Channel ch, MeasParam param)
 {
 	double dResult = Socket_Instrument::DEFAULT_PARAM; // return NaN if no result is obtained
-
-	const string strCh = GetChannelString(ch);
-
 	string strResult = "";
-	smatch smMatch;
-	string strMeasure = MeasPairs[0].str;
 
-	for (unsigned int i = 0; i < nMeasPairs; ++i)
-	{
-		if (param == MeasPairs[i].par)
-		{
-			strMeasure = MeasPairs[i].str;
-			break;
-		}
-	}
-
-	if (Query(strCh + ":PAVA? " + strMeasure, strResult))
-	{
-		if (regex_match(strResult, smMatch, regex("^C[1-4]:PAVA [A-Z]+,([0-9.E+-]+)(V|A)\\s*$")))
-		{
-			dResult = stod(smMatch[1]);
-		}
-	}
+	if (Query(FormatMeasure(cmd, ch, param), strResult))
+		dResult = ParseMeasure(strResult);
 
 	return dResult;
 }
@@ -1200,33 +1546,311 @@ double Oscilloscope::Measure(Channel ch, MeasParam param)
 double Oscilloscope::MeasureDelay(Channel ch1, Channel ch2, MeasDelParam param)
 {
 	double dResult = Socket_Instrument::DEFAULT_PARAM; // return NaN if no result is obtained
+	string strResult = "";
 
-	const string strCh1 = GetChannelString(ch1);
-	const string strCh2 = GetChannelString(ch2);
+	if (Query(FormatMeasureDelay(cmd, ch1, ch2, param), strResult))
+		dResult = ParseMeasureDelay(strResult);
 
-	string strResult = "";
+	return dResult;
+}
+
+
+/*******************************************************************************
+* Class      : Oscilloscope
+* Function   : MeasureSet()
+* Access     : public
+* Arguments  : chIn     = input (reference) channel
+*              chOut    = output channel
+*              param    = amplitude measurement parameter of both channels
+*              delParam = delay measurement parameter of the output to the input
+*              meas     = (reference) receives the measurements (NaN if not obtained)
+* Returns    : true if every measurement was answered
+* Description:
+*   Reads the input and output amplitudes and their delay together. With
+*   CAP_MULTI_QUERY the three queries are sent in one transmission, so the
+*   set costs about one round trip; otherwise they are sent one at a time.
+*/
+bool Oscilloscope::MeasureSet(Channel chIn, Channel chOut, MeasParam param, MeasDelParam delParam, FrameMeas& meas)
+{
+	if (!Supports(CAP_MULTI_QUERY))
+	{
+		meas.in = Measure(chIn, param);
+		meas.out = Measure(chOut, param);
+		meas.delay = MeasureDelay(chIn, chOut, delParam);
+		return !isnan(meas.in) && !isnan(meas.out) && !isnan(meas.delay);
+	}
+
+	vector<string> commands;
+	vector<string> responses;
+
+	commands.push_back(FormatMeasure(cmd, chIn, param).str());
+	commands.push_back(FormatMeasure(cmd, chOut, param).str());
+	commands.push_back(FormatMeasureDelay(cmd, chIn, chOut, delParam).str());
+
+	meas.in = meas.out = meas.delay = DEFAULT_PARAM;
+
+	if (!QueryBatch(commands, responses))
+		return false;
+
+	meas.in = ParseMeasure(responses[0]);
+	meas.out = ParseMeasure(responses[1]);
+	meas.delay = ParseMeasureDelay(responses[2]);
+
+	return true;
+}
+
+
+/*******************************************************************************
+* Class      : Oscilloscope
+* Function   : FormatMeasure(), ParseMeasure()
+* Access     : private static
+* Description:
+*   Formats the measurement query for a channel and parameter into command,
+*   and reads the value in its response (NaN if the response is not a
+*   measurement)
+*/
+ScpiCommand& Oscilloscope::FormatMeasure(ScpiCommand& command, Channel ch, MeasParam param)
+{
+	char const* szMeasure = MeasPairs[0].str;
+
+	for (unsigned int i = 0; i < nMeasPairs; ++i)
+	{
+		if (param == MeasPairs[i].par)
+		{
+			szMeasure = MeasPairs[i].str;
+			break;
+		}
+	}
+
+	return command.Format(CH_PAVA_Q, GetChannelName(ch), szMeasure);
+}
+
+double Oscilloscope::ParseMeasure(std::string const& response)
+{
 	smatch smMatch;
-	string strMeasure = MeasDelPairs[0].str;
+
+	if (regex_match(response, smMatch, regex("^C[1-4]:PAVA [A-Z]+,([0-9.E+-]+)(V|A)\\s*$")))
+		return stod(smMatch[1]);
+
+	return Socket_Instrument::DEFAULT_PARAM;
+}
+
+
+/*******************************************************************************
+* Class      : Oscilloscope
+* Function   : FormatMeasureDelay(), ParseMeasureDelay()
+* Access     : private static
+* Description:
+*   Formats the delay measurement query for a pair of channels and a
+*   parameter into command, and reads the value in its response (NaN if the
+*   response is not a measurement)
+*/
+ScpiCommand& Oscilloscope::FormatMeasureDelay(ScpiCommand& command, Channel ch1, Channel ch2, MeasDelParam param)
+{
+	char const* szMeasure = MeasDelPairs[0].str;
 
 	for (unsigned int i = 0; i < nMeasDelPairs; ++i)
 	{
 		if (param == MeasDelPairs[i].par)
 		{
-			strMeasure = MeasDelPairs[i].str;
+			szMeasure = MeasDelPairs[i].str;
 			break;
 		}
 	}
 
-	if (Query(strCh1 + "-" + strCh2 + ":MEAD? " + strMeasure, strResult))
+	return command.Format(CH_MEAD_Q, GetChannelName(ch1), GetChannelName(ch2), szMeasure);
+}
+
+double Oscilloscope::ParseMeasureDelay(std::string const& response)
+{
+	smatch smMatch;
+
+	// note: unknown result "****" will fall through and produce NaN
+	if (regex_match(response, smMatch, regex("^C[1-4]-C[1-4]:MEAD [A-Z]+,([0-9.E+-]+)[a-zA-Z]*\\s*$")))
+		return stod(smMatch[1]);
+
+	return Socket_Instrument::DEFAULT_PARAM;
+}
+
+
+/*******************************************************************************
+* Class      : Oscilloscope
+* Function   : SetSequence()
+* Access     : public
+* Arguments  : nSegments = number of segments to capture (0 = sequence mode off)
+* Returns    : true if successful, false otherwise
+* Description:
+*   Sets segmented acquisition: each trigger fills the next segment until
+*   nSegments have been captured. The segments are kept as history frames.
+*/
+bool Oscilloscope::SetSequence(unsigned int nSegments)
+{
+	if (nSegments == 0)
+		return Write("SEQUENCE OFF");
+
+	return Write(cmd.Format(SEQUENCE_ON, nSegments));
+}
+
+
+/*******************************************************************************
+* Class      : Oscilloscope
+* Function   : WaitForStop()
+* Access     : public
+* Arguments  : timeout = longest time to wait (seconds)
+* Returns    : true if the acquisition stopped, false on timeout or failure
+* Description:
+*   Waits for a single (or sequence) acquisition to complete
+*/
+bool Oscilloscope::WaitForStop(double timeout)
+{
+	const DWORD msecPoll = 100;
+	const DWORD msecTimeout = DWORD(timeout * 1000.0);
+	const DWORD msecStart = GetTickCount();
+	string strResponse;
+
+	while (GetTickCount() - msecStart < msecTimeout)
+	{
+		if (!Query("SAST?", strResponse))
+			return false;
+
+		// response format = "SAST Stop\n"
+		if (regex_search(strResponse, regex("STOP", regex::icase)))
+			return true;
+
+		Sleep(msecPoll);
+	}
+
+	return false;
+}
+
+
+/*******************************************************************************
+* Class      : Oscilloscope
+* Function   : MeasureFrames()
+* Access     : public
+* Arguments  : nFrames  = number of history frames to measure (1 = first captured)
+*              chIn     = input channel
+*              chOut    = output channel
+*              param    = measurement parameter for both channels
+*              delParam = delay measurement parameter, input to output
+*              frames   = receives one set of measurements per frame
+* Returns    : true if every frame was measured
+* Description:
+*   Shows the history frames of a sequence acquisition one after another and
+*   measures each. The frame selections and the measurement queries of all
+*   frames are sent in one pipelined batch and the responses read back
+*   together, so the whole sequence costs about one round trip. Each frame
+*   selection is followed by *OPC?, so the measurements that follow it are
+*   not taken before the frame is shown.
+*/
+bool Oscilloscope::MeasureFrames(unsigned int nFrames, Channel chIn, Channel chOut, MeasParam param, MeasDelParam delParam, std::vector<FrameMeas>& frames)
+{
+	const string strIn = FormatMeasure(cmd, chIn, param).str();
+	const string strOut = FormatMeasure(cmd, chOut, param).str();
+	const string strDelay = FormatMeasureDelay(cmd, chIn, chOut, delParam).str();
+	vector<string> commands;
+	vector<string> responses;
+
+	frames.clear();
+
+	if (!Write("HSMD ON"))
+		return false;
+
+	for (unsigned int i = 1; i <= nFrames; ++i)
 	{
-		// note: unknown result "****" will fall through and produce NaN
-		if (regex_match(strResult, smMatch, regex("^C[1-4]-C[1-4]:MEAD " + strMeasure + ",([0-9.E+-]+)[a-zA-Z]*\\s*$")))
+		commands.push_back(cmd.Format(FRAM, i).str());
+		commands.push_back("*OPC?");
+		commands.push_back(strIn);
+		commands.push_back(strOut);
+		commands.push_back(strDelay);
+	}
+
+	bool bResult = QueryBatch(commands, responses);
+
+	if (bResult)
+	{
+		for (unsigned int i = 0; i < nFrames; ++i)
 		{
-			dResult = stod(smMatch[1]);
+			FrameMeas frame;
+			// responses[4 * i] answers *OPC?
+			frame.in = ParseMeasure(responses[4 * i + 1]);
+			frame.out = ParseMeasure(responses[4 * i + 2]);
+			frame.delay = ParseMeasureDelay(responses[4 * i + 3]);
+			frames.push_back(frame);
 		}
 	}
 
-	return dResult;
+	Write("HSMD OFF");
+
+	return bResult;
+}
+
+/*******************************************************************************
+* Class      : Oscilloscope
+* Function   : ReadWaveform()
+* Access     : public
+* Arguments  : ch         = channel
+*              nPointsMax = most points to read (the capture is decimated to fit)
+*              volts      = receives the samples, in volts
+*              tSample    = receives the time between the samples read
+* Returns    : true if the waveform was read
+* Description:
+*   Reads the last capture of a channel as binary data. The scale, offset,
+*   sample rate and length of the capture are queried in one batch, the
+*   download is limited to nPointsMax by taking every n-th point, and the
+*   8-bit codes are converted to volts (25 codes per division).
+*/
+bool Oscilloscope::ReadWaveform(Channel ch, unsigned int nPointsMax, std::vector<double>& volts, double& tSample)
+{
+	char const* szCh = GetChannelName(ch);
+	vector<string> commands;
+	vector<string> responses;
+	string strBlock;
+	smatch smMatch;
+	const regex reValue("^[^ ]+ ([\\+\\-\\.0-9E]+)[A-Za-z/]*\\s*$", regex::icase);
+	double values[4];
+
+	volts.clear();
+
+	if (nPointsMax == 0)
+		return false;
+
+	commands.push_back(cmd.Format(CH_VDIV_Q, szCh).str());
+	commands.push_back(cmd.Format(CH_OFST_Q, szCh).str());
+	commands.push_back("SARA?");
+	commands.push_back(cmd.Format(SANU_Q, szCh).str());
+
+	if (!QueryBatch(commands, responses))
+		return false;
+
+	for (size_t i = 0; i < 4; ++i)
+	{
+		if (!regex_match(responses[i], smMatch, reValue))
+			return false;
+		values[i] = stod(smMatch[1]);
+	}
+
+	const double vdiv = values[0];
+	const double offset = values[1];
+	const double rate = values[2];
+	const double points = values[3];
+
+	if (!(vdiv > 0.0) || !(rate > 0.0) || !(points >= 1.0))
+		return false;
+
+	const unsigned int sparse = static_cast<unsigned int>(ceil(points / nPointsMax));
+
+	// the waveform block is followed by two LF
+	if (!Write(cmd.Format(WFSU, sparse, nPointsMax)) || !QueryBlock(cmd.Format(CH_WF_Q, szCh).str(), strBlock, 2))
+		return false;
+
+	volts.reserve(strBlock.length());
+	for (char code : strBlock)
+		volts.push_back(static_cast<signed char>(code) * vdiv / 25.0 - offset);
+
+	tSample = sparse / rate;
+
+	return !volts.empty();
 }
 
 
@@ -1237,16 +1861,11 @@ double Oscilloscope::MeasureDelay(Channel ch1, Channel ch2, MeasDelParam param)
 * Arguments  : delay  = horizontal delay (seconds)
 * Returns    : true if successful, false otherwise
 * Description:
-*   Reads the given delay measurement between the given channels
+*   Sets the horizontal delay, if it is not already set (NaN = no change)
 */
 bool Oscilloscope::SetTimeDelay(double delay)
 {
-	bool bResult = true;
-
-	if (!isnan(delay))
-		bResult = Write("TRDL "+to_string(delay));
-
-	return bResult;
+	return SetCapture(TimeDiv::UNSPEC, MemDepth::UNSPEC, delay);
 }
 
 
@@ -1263,60 +1882,240 @@ bool Oscilloscope::SetTimeDelay(double delay)
 */
 double Oscilloscope::SetTimebase(double tcapture, double delay)
 {
-	const double tdiv = tcapture / nTimeDivisions; 
+	TimeDiv tpick;
+	const double tactual = FindTimebase(tcapture, tpick);
+
+	if (SetTimebase(tpick, delay))
+		return tactual;
+	else
+		return DEFAULT_PARAM;
+}
+
+
+/*******************************************************************************
+* Class      : Oscilloscope
+* Function   : SetTimebase()
+* Access     : public
+* Arguments  : tdiv  = time/division setting (TimeDiv)
+*              delay = horizontal delay (seconds)
+* Returns    : true if successful, false otherwise
+* Description:
+*   Sets the timebase to the given time/division and delay.
+*/
+bool Oscilloscope::SetTimebase(TimeDiv tdiv, double delay)
+{
+	if (tdiv == TimeDiv::UNSPEC)
+		return false;
+
+	return SetCapture(tdiv, MemDepth::UNSPEC, delay);
+}
+
+
+/*******************************************************************************
+* Class      : Oscilloscope
+* Function   : SetCapture()
+* Access     : public
+* Arguments  : tdiv  = time/division setting (UNSPEC = no change)
+*              depth = acquisition memory depth (UNSPEC = no change)
+*              delay = horizontal delay in seconds (NaN = no change)
+* Returns    : true if successful, false otherwise
+* Description:
+*   Sets the horizontal capture. Each change of timebase or memory depth
+*   restarts the acquisition, so settings equal to the ones last written are
+*   not sent again, and the ones that changed (TDIV, MSIZ, TRDL) are sent
+*   together in a single transmission. Adjacent sweep points usually share
+*   a timebase, so most points send nothing here.
+*/
+bool Oscilloscope::SetCapture(TimeDiv tdiv, MemDepth depth, double delay)
+{
+	cmd.Clear();
+
+	if (tdiv != TimeDiv::UNSPEC && tdiv != tdivSet)
+	{
+		if (!FormatTimebase(cmd, tdiv))
+			return false;
+	}
+
+	if (depth != MemDepth::UNSPEC && depth != mdepthSet)
+	{
+		if (!FormatMemoryDepth(cmd, depth))
+			return false;
+	}
+
+	if (!isnan(delay) && delay != delaySet)
+		cmd.Append("TRDL ").Append(delay).Append('\n');
+
+	if (cmd.size() == 0)
+		return true;
+
+	if (!Write(cmd))
+	{	// the instrument state is no longer known
+		tdivSet = TimeDiv::UNSPEC;
+		mdepthSet = MemDepth::UNSPEC;
+		delaySet = DEFAULT_PARAM;
+		return false;
+	}
+
+	if (tdiv != TimeDiv::UNSPEC)
+		tdivSet = tdiv;
+	if (depth != MemDepth::UNSPEC)
+		mdepthSet = depth;
+	if (!isnan(delay))
+		delaySet = delay;
+
+	return true;
+}
+
+
+/*******************************************************************************
+* Class      : Oscilloscope
+* Function   : FindTimebase()
+* Access     : public
+* Arguments  : tcapture = target capture time (seconds)
+*              tdiv     = receives the time/division setting
+* Returns    : total horizontal time in the capture for the chosen setting
+* Description:
+*   Finds the closest settable timebase that provides a total capture time
+*   greater than or equal to that passed as an argument, without applying it.
+*/
+double Oscilloscope::FindTimebase(double tcapture, TimeDiv& tdiv) const
+{
+	const double tdiv_ideal = tcapture / nTimeDivisions;
 
 	// default if no others match
-	TimeDiv tpick = TimePairs[nTimePairs - 1].tdiv;
+	tdiv = TimePairs[nTimePairs - 1].tdiv;
 	double tactual = TimePairs[nTimePairs - 1].sec;
 
 	for (unsigned int i = 0; i < nTimePairs-1; ++i)   // -1 => no need to do the last one, since it was chosen as default
 	{
-		if (tdiv <= TimePairs[i].sec)
+		if (tdiv_ideal <= TimePairs[i].sec)
 		{
-			tpick = TimePairs[i].tdiv;
+			tdiv = TimePairs[i].tdiv;
 			tactual = TimePairs[i].sec;
 			break;
 		}
 	}
 
-	if (SetTimebase(tpick, delay))
-		return tactual * nTimeDivisions;
-	else
-		return DEFAULT_PARAM;
+	return tactual * nTimeDivisions;
 }
 
 
 /*******************************************************************************
 * Class      : Oscilloscope
-* Function   : SetTimebase()
+* Function   : FormatTimebase()
+* Access     : private static
+* Arguments  : command = command to append to
+*              tdiv    = time/division setting (TimeDiv)
+* Returns    : true if appended, false if tdiv is invalid
+* Description:
+*   Appends the time/division command, with its newline, so that it can be
+*   sent in one transmission with other commands
+*/
+bool Oscilloscope::FormatTimebase(ScpiCommand& command, TimeDiv tdiv)
+{
+	for (unsigned int i = 0; i < nTimePairs; ++i)
+	{
+		if (tdiv == TimePairs[i].tdiv)
+		{
+			command.Append("TDIV ").Append(TimePairs[i].str).Append('\n');
+			return true;
+		}
+	}
+
+	return false;
+}
+
+
+/*******************************************************************************
+* Class      : Oscilloscope
+* Function   : SetMemoryDepth()
 * Access     : public
-* Arguments  : tdiv  = time/division setting (TimeDiv)
-*              delay = horizontal delay (seconds)
+* Arguments  : depth = acquisition memory depth
 * Returns    : true if successful, false otherwise
 * Description:
-*   Sets the timebase to the given time/division and delay.
+*   Sets the acquisition memory depth. A smaller depth makes the measurements
+*   update sooner and waveform transfers smaller.
 */
-bool Oscilloscope::SetTimebase(TimeDiv tdiv, double delay)
+bool Oscilloscope::SetMemoryDepth(MemDepth depth)
 {
-	bool bResult = false;
-	string strTDiv = "";
+	if (depth == MemDepth::UNSPEC)
+		return false;
 
-	for (unsigned int i = 0; i < nTimePairs; ++i)
+	return SetCapture(TimeDiv::UNSPEC, depth);
+}
+
+
+/*******************************************************************************
+* Class      : Oscilloscope
+* Function   : FindMemoryDepth()
+* Access     : public
+* Arguments  : tcapture = total horizontal time of the capture (seconds)
+*              rate     = sample rate needed (samples/second)
+* Returns    : the smallest memory depth that samples at least that fast
+* Description:
+*   The scope samples a capture at the memory depth divided by the capture
+*   time, up to MAX_SAMPLE_RATE. Returns the smallest depth reaching the
+*   needed rate (or the highest rate available), or the largest depth if no
+*   depth does.
+*/
+Oscilloscope::MemDepth Oscilloscope::FindMemoryDepth(double tcapture, double rate) const
+{
+	if (rate > MAX_SAMPLE_RATE)
+		rate = MAX_SAMPLE_RATE;
+
+	const double points = rate * tcapture;
+
+	for (unsigned int i = 0; i < nMemDepthPairs; ++i)
 	{
-		if (tdiv == TimePairs[i].tdiv)
+		if (MemDepthPairs[i].points >= points)
+			return MemDepthPairs[i].depth;
+	}
+
+	return MemDepthPairs[nMemDepthPairs - 1].depth;
+}
+
+
+/*******************************************************************************
+* Class      : Oscilloscope
+* Function   : FormatMemoryDepth()
+* Access     : private static
+* Arguments  : command = command to append to
+*              depth   = acquisition memory depth
+* Returns    : true if appended, false if depth is invalid
+* Description:
+*   Appends the memory depth command, with its newline, so that it can be
+*   sent in one transmission with other commands
+*/
+bool Oscilloscope::FormatMemoryDepth(ScpiCommand& command, MemDepth depth)
+{
+	for (unsigned int i = 0; i < nMemDepthPairs; ++i)
+	{
+		if (depth == MemDepthPairs[i].depth)
 		{
-			strTDiv = TimePairs[i].str;
-			bResult = true;
-			break;
+			command.Append("MSIZ ").Append(MemDepthPairs[i].str).Append('\n');
+			return true;
 		}
 	}
 
-	if (bResult)
-		bResult = Write("TDIV " + strTDiv);
-	if (bResult)
-		bResult = SetTimeDelay(delay);
+	return false;
+}
 
-	return bResult;
+
+/*******************************************************************************
+* Class      : Oscilloscope
+* Function   : SendCommand()
+* Access     : public
+* Arguments  : command = command prepared in advance
+* Returns    : true if successful, false otherwise
+* Description:
+*   Sends a command that was formatted in advance
+*/
+bool Oscilloscope::SendCommand(std::string const& command)
+{
+	if (command.empty())
+		return false;
+
+	return Write(command);
 }
 
 
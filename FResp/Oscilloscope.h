@@ -5,13 +5,15 @@
 * Filename   : Oscilloscope.h
 * Class      : Oscilloscope
 * Description:
-*   Implements an interface to a Siglent SDS 1000 X-E oscilloscope.
+*   Implements an interface to a Siglent SDS 1000 X-E oscilloscope. This is
+*   the ScopeDriver for that model (see ScopeDriver.h).
 *
 * Created    : 05/25/2020
-* Modified   : 01/02/2023
+* Modified   : 10/16/2026
 * Author     : Kerry S. Martin, martin@wild-wood.net
 *******************************************************************************/
 #pragma once
+#include "ScopeDriver.h"
 #include "Socket_Instrument.h"
 
 
@@ -20,7 +22,7 @@ constexpr auto N_VOLTAGE_PAIRS = 14;
 
 
 class Oscilloscope :
-	protected Socket_Instrument
+	public ScopeDriver, protected Socket_Instrument
 {
 public:
 	// construction/destruction
@@ -28,60 +30,95 @@ public:
 	virtual ~Oscilloscope();
 
 	// connection to an instrument
-	virtual bool Attach(std::string resource);
+	bool Attach(std::string resource) override;
+	bool Attach(Socket_Instrument& connection) override;
 	//virtual bool Attach(std::regex pattern);
-	virtual bool Detach();
-
-	// many setting types
-	enum class Channel { CH1, CH2, CH3, CH4 };
-	enum class VoltsPerDiv { UNSPEC, V_500uV, V_1mV, V_2mV, V_5mV, V_10mV, V_20mV, V_50mV, V_100mV, V_200mV, V_500mV, V_1V, V_2V, V_5V, V_10V, V_20V, V_50V, V_100V }; // 500uV only at 1x, 100V at 10x
-	enum class BWLimit { UNSPEC, BWL_FULL, BWL_ON };
-	enum class ChInvert { UNSPEC, INV_OFF, INV_ON };
-	enum class Coupling { UNSPEC, DC, AC };
-	enum class ChAtten { UNSPEC, AT_1X, AT_10X };
-	enum class ChUnit { UNSPEC, V /*, A */ };  // for now, A is not supported TODO: support eventually
-	enum class EdgeType { RISING, FALLING };
-	enum class TriggerMode { STOP, AUTO, NORMAL, SINGLE };
-	enum class MeasParam { PKPK, MAX, MIN, AMPL, TOP, BASE, CMEAN, MEAN, RMS, CRMS, OVSN, FPRE, OVSP, RPRE, PER, FREQ, PWID, NWID, RISE, FALL, WID, DUTY, NDUTY };
-	enum class MeasDelParam { PHA, FRR, FRF, FFR, FFF, LRR, LRF, LFR, LFF, SKEW };
-	enum class TimeDiv { UNSPEC, T_1nS, T_2nS, T_5nS, T_10nS, T_20nS, T_50nS, T_100nS, T_200nS, T_500nS, T_1uS, T_2uS, T_5uS, T_10uS, T_20uS, T_50uS, T_100uS, T_200uS, T_500uS, T_1mS, T_2mS, T_5mS, T_10mS, T_20mS, T_50mS, T_100mS, T_200mS, T_500mS, T_1S, T_2S, T_5S, T_10S, T_20S, T_50S, T_100S };
-	struct ScaleValues { double max; double min; double pp; double offset; double vdiv; };
-	struct ChBWLPair { Channel ch; BWLimit bwl; };
+	bool Detach() override;
+	bool Reconnect() override;
+	bool IsConnected() const override;
+
+	// setting types are those of ScopeDriver
 
 	// channel configuration
 	bool SetChannelEx(Channel ch, bool enabled = true, VoltsPerDiv vdiv=VoltsPerDiv::UNSPEC, double offset=DEFAULT_PARAM, Coupling coup = Coupling::UNSPEC, BWLimit bwl=BWLimit::UNSPEC, ChAtten atten=ChAtten::UNSPEC, ChInvert inv=ChInvert::UNSPEC);
-	bool SetChannelEnable(Channel ch, bool enabled);
+	bool SetChannelEnable(Channel ch, bool enabled) override;
 	bool SetChannelVolts(Channel ch, VoltsPerDiv vdiv, double offset=DEFAULT_PARAM);
-	bool SetChannelVoltsEx(Channel ch, double vdiv, double offset = DEFAULT_PARAM);
+	bool SetChannelVoltsEx(Channel ch, double vdiv, double offset = DEFAULT_PARAM) override;
 	bool SetChannelOffset(Channel ch, double offset);
-	bool SetChannelBWL(Channel ch, BWLimit bwl);
+	bool SetChannelBWL(Channel ch, BWLimit bwl) override;
 	bool SetChannelBWL(const std::vector<ChBWLPair> pairs);
 	bool SetChannelInvert(Channel ch, ChInvert inv);
-	bool SetChannelAtten(Channel ch, ChAtten atten);
-	bool SetChannelCoupling(Channel ch, Coupling coup);
+	bool SetChannelAtten(Channel ch, ChAtten atten) override;
+	bool SetChannelCoupling(Channel ch, Coupling coup) override;
 	bool SetChannelUnit(Channel ch, ChUnit unit);
 	bool SetChannelSkew(Channel ch, double skew);
 	int AdjustChannelVolts(Channel ch, int adjust);
-	int AdjustChannelVolts(Channel ch, int adjust, ScaleValues& scale);
+	int AdjustChannelVolts(Channel ch, int adjust, ScaleValues& scale) override;
 
 	// timebase configuration
+	// settings equal to the ones last written are skipped, and the changed ones
+	// are sent in a single transmission (see SetCapture)
+	bool SetCapture(TimeDiv tdiv, MemDepth depth, double delay = DEFAULT_PARAM) override;
 	bool SetTimebase(TimeDiv tdiv, double delay=DEFAULT_PARAM);
 	double SetTimebase(double tcapture, double delay = DEFAULT_PARAM);
 	bool SetTimeDelay(double delay);
+	double FindTimebase(double tcapture, TimeDiv& tdiv) const override;
+
+	// acquisition memory depth (see SetCapture)
+	bool SetMemoryDepth(MemDepth depth);
+	MemDepth FindMemoryDepth(double tcapture, double rate) const override;
+
+	// send a command prepared in advance (use SetCapture for the timebase, memory depth and delay)
+	bool SendCommand(std::string const& command);
 
 	// trigger configuration
-	bool SetTriggerMode(TriggerMode mode);
-	bool SetEdgeTrigger(Channel ch, EdgeType edge, double voltage, Coupling coup, bool holdoff=false, double tHoldoff = 0.0);
+	bool SetTriggerMode(TriggerMode mode) override;
+	bool SetEdgeTrigger(Channel ch, EdgeType edge, double voltage, Coupling coup, bool holdoff=false, double tHoldoff = 0.0) override;
+	double HoldoffMax() const override;
 
 	// measurements
-	double Measure(Channel ch, MeasParam param);
-	double MeasureDelay(Channel ch1, Channel ch2, MeasDelParam param);
+	double Measure(Channel ch, MeasParam param) override;
+	double MeasureDelay(Channel ch1, Channel ch2, MeasDelParam param) override;
+	bool MeasureSet(Channel chIn, Channel chOut, MeasParam param, MeasDelParam delParam, FrameMeas& meas) override;
+
+	// segmented (sequence) acquisition, read back through the history frames
+	bool SetSequence(unsigned int nSegments) override;
+	bool WaitForStop(double timeout) override;
+	bool MeasureFrames(unsigned int nFrames, Channel chIn, Channel chOut, MeasParam param, MeasDelParam delParam, std::vector<FrameMeas>& frames) override;
+
+	// waveform of the last capture, read in binary
+	bool ReadWaveform(Channel ch, unsigned int nPointsMax, std::vector<double>& volts, double& tSample) override;
+
+	// longest trigger holdoff (seconds)
+	static const double HOLDOFF_MAX;
 
 private:
+	// capture settings last written (UNSPEC or NaN if not known)
+	TimeDiv tdivSet;
+	MemDepth mdepthSet;
+	double delaySet;
+
+	// setup groups, in the order SetupOscilloscopeDefault() sends them
+	// UNCHECKED holds the settings that cannot be read back; it is always sent
+	enum class SetupGroup { ACQUIRE, DISPLAY, OVERLAY, UNCHECKED, TIMEBASE, BANDWIDTH, CH1, CH2, CH3, CH4, TRIGGER, N_GROUPS };
+	struct SetupCheck { SetupGroup group; char query[12]; char expected[32]; };
+	static const SetupCheck SetupChecks[];
+	static const unsigned int nSetupChecks;
+
 	// helper functions
+	void SetupOscilloscope();
+	bool SetupOscilloscopeFast();
 	void SetupOscilloscopeDefault();
+	void SetupGroupDefault(SetupGroup group);
+	static bool SetupValueMatches(std::string const& response, char const* expected);
+	static ScpiCommand& FormatMeasure(ScpiCommand& command, Channel ch, MeasParam param);
+	static double ParseMeasure(std::string const& response);
+	static ScpiCommand& FormatMeasureDelay(ScpiCommand& command, Channel ch1, Channel ch2, MeasDelParam param);
+	static double ParseMeasureDelay(std::string const& response);
+	static bool FormatTimebase(ScpiCommand& command, TimeDiv tdiv);
+	static bool FormatMemoryDepth(ScpiCommand& command, MemDepth depth);
 	double ReadChannelAtten(Channel ch);
-	static std::string GetChannelString(Channel ch);
+	static char const* GetChannelName(Channel ch);
 	static Channel GetChannel(int i);
 
 	struct VoltagePair { VoltsPerDiv vdiv; double volts; char str[6]; };
@@ -92,6 +129,11 @@ private:
 	static const TimePair TimePairs[];
 	static const unsigned int nTimePairs;
 
+	struct MemDepthPair { MemDepth depth; double points; char str[6]; };
+	static const MemDepthPair MemDepthPairs[];
+	static const unsigned int nMemDepthPairs;
+	static const double MAX_SAMPLE_RATE;
+
 	struct MeasPair { MeasParam par; char str[6]; };
 	static const MeasPair MeasPairs[];
 	static const unsigned int nMeasPairs;
@@ -0,0 +1,85 @@
+/*******************************************************************************
+* Copyright  2026 Kerry S. Martin, martin@wild-wood.net
+* Free for usage without warranty, expressed or implied; attribution required
+*
+* Filename   : ResultFormatter.cpp
+* Class      : ResultFormatter
+* Description:
+*   ResultFormatter writes a frequency point as one tab-separated text row
+*   with shortest round-trip precision.
+*
+* Created    : 10/16/2026
+* Modified   : 10/16/2026
+* Author     : Kerry S. Martin, martin@wild-wood.net
+*******************************************************************************/
+
+#include "ResultFormatter.h"
+#include <charconv>
+#include <cmath>
+
+using namespace std;
+
+
+/*******************************************************************************
+* Class      : ResultFormatter
+* Function   : FormatValue()
+* Access     : public static
+* Arguments  : pFirst = where to write the value
+*              pLast  = end of the available buffer
+*              value  = value to write
+* Returns    : one past the last character written, or nullptr if it did not fit
+* Description:
+*   Writes one value in the shortest form that reads back exactly. A failed
+*   measurement (NaN) is written as nan.
+*/
+char* ResultFormatter::FormatValue(char* pFirst, char* pLast, double value)
+{
+	to_chars_result result = to_chars(pFirst, pLast, value);
+
+	return (result.ec == errc()) ? result.ptr : nullptr;
+}
+
+
+/*******************************************************************************
+* Class      : ResultFormatter
+* Function   : FormatRow()
+* Access     : public static
+* Arguments  : pBuffer = buffer to receive the row (ROW_SIZE is always enough)
+*              nSize   = size of the buffer
+*              point   = frequency point to format
+* Returns    : number of characters written, 0 if the buffer is too small
+* Description:
+*   Writes freq, input, output, gain, dB and phase|delay separated by tabs
+*   and terminated by a newline, followed before the newline by fund, h2 to
+*   h5, THD and THD+N if the point has harmonic analysis. The buffer is not
+*   null terminated.
+*/
+size_t ResultFormatter::FormatRow(char* pBuffer, size_t nSize, FRS const& point)
+{
+	const double values[ROW_COLUMNS + HARMONIC_COLUMNS] =
+	{
+		point.freq, point.mag_in, point.mag_out, point.mag_out / point.mag_in, point.dBgain, point.time,
+		point.fund, 20.0 * log10(point.h2 / point.fund), 20.0 * log10(point.h3 / point.fund), 20.0 * log10(point.h4 / point.fund),
+		20.0 * log10(point.h5 / point.fund), 20.0 * log10(point.thd), 20.0 * log10(point.thdn)
+	};
+	const size_t nColumns = point.is_harmonics ? ROW_COLUMNS + HARMONIC_COLUMNS : ROW_COLUMNS;
+	char* const pLast = pBuffer + nSize;
+	char* p = pBuffer;
+
+	for (size_t i = 0; i < nColumns; ++i)
+	{
+		p = FormatValue(p, pLast, values[i]);
+		if (p == nullptr || p == pLast)
+			return 0;
+
+		*p++ = (i + 1 < nColumns) ? '\t' : '\n';
+	}
+
+	return size_t(p - pBuffer);
+}
+
+
+/*******************************************************************************
+* Copyright  2026 Kerry S. Martin, martin@wild-wood.net
+* Free for usage without warranty, expressed or implied; attribution required
+*******************************************************************************/
\ No newline at end of file
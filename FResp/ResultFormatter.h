@@ -0,0 +1,41 @@
+/*******************************************************************************
+* Copyright  2026 Kerry S. Martin, martin@wild-wood.net
+* Free for usage without warranty, expressed or implied; attribution required
+*
+* Filename   : ResultFormatter.h
+* Class      : ResultFormatter
+* Description:
+*   ResultFormatter writes a frequency point as one tab-separated text row
+*   into a caller supplied buffer using std::to_chars. Each value is written
+*   with the fewest digits that read back to exactly the same double, with
+*   no locale lookups and no allocation.
+*
+*   A point with harmonic analysis has seven more columns: the amplitude of
+*   the fundamental (V peak), harmonics 2 to 5 (dBc), THD and THD+N (dB).
+*
+* Created    : 10/16/2026
+* Modified   : 10/16/2026
+* Author     : Kerry S. Martin, martin@wild-wood.net
+*******************************************************************************/
+#pragma once
+#include "FreqResp.h"
+#include <cstddef>
+
+class ResultFormatter
+{
+public:
+	// longest shortest-round-trip double ("-2.2250738585072014e-308") plus a separator
+	static constexpr size_t VALUE_SIZE = 25;
+	static constexpr size_t ROW_COLUMNS = 6;
+	static constexpr size_t HARMONIC_COLUMNS = 7;
+	static constexpr size_t ROW_SIZE = (ROW_COLUMNS + HARMONIC_COLUMNS) * VALUE_SIZE + 1;
+
+	static size_t FormatRow(char* pBuffer, size_t nSize, FRS const& point);
+	static char* FormatValue(char* pFirst, char* pLast, double value);
+};
+
+
+/*******************************************************************************
+* Copyright  2026 Kerry S. Martin, martin@wild-wood.net
+* Free for usage without warranty, expressed or implied; attribution required
+*******************************************************************************/
\ No newline at end of file
@@ -0,0 +1,584 @@
+/*******************************************************************************
+* Copyright  2026 Kerry S. Martin, martin@wild-wood.net
+* Free for usage without warranty, expressed or implied; attribution required
+*
+* Filename   : ResultWriter.cpp
+* Class      : ResultWriter, StreamSink, FileSink, BinarySink, SocketSink,
+*              SharedSink
+* Description:
+*   ResultWriter moves result output off the measurement thread through a
+*   lock-free SPSC queue serviced by a background writer thread.
+*
+* Created    : 10/16/2026
+* Modified   : 10/16/2026
+* Author     : Kerry S. Martin, martin@wild-wood.net
+*******************************************************************************/
+
+#include "ResultWriter.h"
+#include "FRBinaryWriter.h"
+#include "FRShared.h"
+#include <algorithm>
+#include <cstring>
+
+using namespace std;
+
+// how long the writer thread sleeps when there is nothing to write
+constexpr auto RESULT_WRITER_IDLE_MSEC = 5;
+
+
+/*******************************************************************************
+* Class      : StreamSink
+* Function   : Write(), Flush(), Close()
+* Access     : public
+* Description:
+*   Writes the text records to the stream (not the messages for a client).
+*   The stream is not owned, so Close() only flushes it.
+*/
+void StreamSink::Write(ResultRecord const& record)
+{
+	if (!record.is_message)
+		os.write(record.text, streamsize(record.length));
+}
+
+void StreamSink::Flush()
+{
+	os.flush();
+}
+
+bool StreamSink::Close()
+{
+	os.flush();
+	return os.good();
+}
+
+
+/*******************************************************************************
+* Class      : FileSink
+* Function   : Open()
+* Access     : public
+* Arguments  : filename = file to write (an existing file is replaced)
+* Returns    : true if the file was opened
+* Description:
+*   Opens the text output file. Called before the writer is started.
+*/
+bool FileSink::Open(std::string filename)
+{
+	file.open(filename, ios::out | ios::trunc);
+	return file.is_open();
+}
+
+
+/*******************************************************************************
+* Class      : FileSink
+* Function   : Write(), Flush(), Close()
+* Access     : public
+* Description:
+*   Writes the text records to the file (the messages for a client are not
+*   results, and are left out)
+*/
+void FileSink::Write(ResultRecord const& record)
+{
+	if (!record.is_message)
+		file.write(record.text, streamsize(record.length));
+}
+
+void FileSink::Flush()
+{
+	file.flush();
+}
+
+bool FileSink::Close()
+{
+	if (!file.is_open())
+		return true;
+
+	file.close();
+	return !file.fail();
+}
+
+
+/*******************************************************************************
+* Class      : BinarySink
+* Function   : BinarySink() constructor
+* Access     : public
+* Arguments  : filename = binary file to write when the sink is closed
+*              freq, stim, input, output, trig, meas, dwell = sweep configuration
+* Returns    : none
+* Description:
+*   Constructs a sink that collects the points for a binary columnar file
+*/
+BinarySink::BinarySink(std::string filename, Freq_Config const& freq, Stim_Config const& stim, Channel_Config const& input, Channel_Config const& output, Trig_Config const& trig, Meas_Config const& meas, Dwell_Config const& dwell)
+	: filename(filename), freq(freq), stim(stim), input(input), output(output), trig(trig), meas(meas), dwell(dwell)
+{
+}
+
+
+/*******************************************************************************
+* Class      : BinarySink
+* Function   : Write(), Close()
+* Access     : public
+* Description:
+*   Collects the point records (text records are ignored). The columnar
+*   file can only be laid out once the number of points is known, so it is
+*   written by Close().
+*/
+void BinarySink::Write(ResultRecord const& record)
+{
+	if (record.is_point)
+		data.push_back(record.point);
+}
+
+bool BinarySink::Close()
+{
+	return FRBinaryWriter::Write(filename, data, freq, stim, input, output, trig, meas, dwell);
+}
+
+
+/*******************************************************************************
+* Class      : SocketSink
+* Function   : Write(), Close()
+* Access     : public
+* Description:
+*   Sends the text records and the messages to the socket. Once a send fails
+*   (the client has gone away) the remaining records are discarded, and
+*   Close() reports it. The socket is not owned; while the writer runs, only
+*   the writer thread sends on it.
+*/
+void SocketSink::Write(ResultRecord const& record)
+{
+	if (!bFailed)
+		bFailed = !sock.Send(record.text, record.length);
+}
+
+bool SocketSink::Close()
+{
+	return !bFailed;
+}
+
+/*******************************************************************************
+* Class      : SharedSink
+* Function   : SharedSink() constructor, ~SharedSink() destructor
+* Access     : public
+* Arguments  : freq, stim, input, output, trig, meas, dwell = sweep configuration
+* Returns    : none
+* Description:
+*   Constructs a sink that publishes the points to a shared memory ring.
+*   Open() creates or opens the ring. The destructor releases it, if Close()
+*   was not called.
+*/
+SharedSink::SharedSink(Freq_Config const& freq, Stim_Config const& stim, Channel_Config const& input, Channel_Config const& output, Trig_Config const& trig, Meas_Config const& meas, Dwell_Config const& dwell)
+	: hMapping(NULL), header(nullptr), slots(nullptr), next(0), freq(freq), stim(stim), input(input), output(output), trig(trig), meas(meas), dwell(dwell)
+{
+}
+
+SharedSink::~SharedSink()
+{
+	Close();
+}
+
+
+/*******************************************************************************
+* Class      : SharedSink
+* Function   : Open()
+* Access     : public
+* Arguments  : name = name of the ring (see FRM_MappingName())
+* Returns    : true if the ring was created, or an existing one opened
+* Description:
+*   Creates the ring, or opens the one left by an earlier sweep while a
+*   reader still has it mapped, and starts a new sweep in it. Point numbers
+*   carry on from the earlier sweeps, so a reader can tell the sweeps apart.
+*   Called before the writer is started.
+*/
+bool SharedSink::Open(std::string name)
+{
+	const uint64_t nSize = FRM_MappingSize();
+
+	Close();
+
+	hMapping = CreateFileMappingA(INVALID_HANDLE_VALUE, NULL, PAGE_READWRITE, DWORD(nSize >> 32), DWORD(nSize & 0xFFFFFFFF), FRM_MappingName(name.c_str()).c_str());
+	if (hMapping == NULL)
+		return false;
+
+	void* pView = MapViewOfFile(hMapping, FILE_MAP_ALL_ACCESS, 0, 0, 0);
+	if (pView == nullptr)
+	{
+		Close();
+		return false;
+	}
+
+	header = static_cast<FRM_Header*>(pView);
+	slots = reinterpret_cast<FRM_Slot*>(static_cast<char*>(pView) + sizeof(FRM_Header));
+
+	if (memcmp(header->magic, FRM_MAGIC, sizeof(FRM_MAGIC)) != 0)
+	{	// a new ring (the mapping starts zeroed); identified last, once it is ready
+		header->version = FRM_VERSION;
+		header->header_size = sizeof(FRM_Header);
+		header->ring_points = FRM_RING_POINTS;
+		header->slot_size = sizeof(FRM_Slot);
+		atomic_thread_fence(memory_order_release);
+		memcpy(header->magic, FRM_MAGIC, sizeof(FRM_MAGIC));
+	}
+	else if (header->version != FRM_VERSION || header->header_size != sizeof(FRM_Header) || header->ring_points != FRM_RING_POINTS || header->slot_size != sizeof(FRM_Slot))
+	{	// left by a different version of the program, which is not touched
+		UnmapViewOfFile(pView);
+		header = nullptr;
+		Close();
+		return false;
+	}
+
+	next = header->head.load(memory_order_relaxed);
+	SetState(FRM_State::RUNNING, true);
+
+	return true;
+}
+
+
+/*******************************************************************************
+* Class      : SharedSink
+* Function   : SetState()
+* Access     : private
+* Arguments  : state     = state of the sweep
+*              bNewSweep = start a new sweep, from the next point
+* Returns    : none
+* Description:
+*   Updates the sweep fields of the ring under their seqlock
+*/
+void SharedSink::SetState(FRM_State state, bool bNewSweep)
+{
+	const uint64_t seq = header->sweep_seq.load(memory_order_relaxed);
+
+	header->sweep_seq.store(seq + 1, memory_order_relaxed);
+	atomic_thread_fence(memory_order_release);
+
+	if (bNewSweep)
+	{
+		header->sweep.sweep = header->sweep.sweep + 1;
+		header->sweep.first = next;
+		header->sweep.config = FRBinaryWriter::MakeConfig(freq, stim, input, output, trig, meas, dwell);
+	}
+	header->sweep.state = state;
+
+	header->sweep_seq.store(seq + 2, memory_order_release);
+}
+
+
+/*******************************************************************************
+* Class      : SharedSink
+* Function   : Write(), Close()
+* Access     : public
+* Description:
+*   Publishes the point records (text records are ignored): the point is
+*   written into its slot under the slot's seqlock, then the head is moved
+*   past it. Nothing waits for the readers. Close() marks the sweep done and
+*   releases the ring, which lasts as long as a reader has it mapped.
+*/
+void SharedSink::Write(ResultRecord const& record)
+{
+	if (header == nullptr || !record.is_point)
+		return;
+
+	FRS const& point = record.point;
+	FRM_Slot& slot = slots[next % FRM_RING_POINTS];
+
+	slot.seq.store(2 * next + 1, memory_order_relaxed);
+	atomic_thread_fence(memory_order_release);
+
+	slot.point = { point.freq, point.mag_in, point.mag_out, point.dBgain, point.time, point.sd_dBgain, point.sd_time, point.vstim,
+		point.fund, point.h2, point.h3, point.h4, point.h5, point.thd, point.thdn, point.count, uint8_t(point.tunit), uint8_t(point.is_harmonics ? 1 : 0), { 0, 0 } };
+
+	slot.seq.store(2 * next + 2, memory_order_release);
+
+	next = next + 1;
+	header->head.store(next, memory_order_release);
+}
+
+bool SharedSink::Close()
+{
+	if (header != nullptr)
+	{
+		SetState(FRM_State::DONE, false);
+		UnmapViewOfFile(header);
+	}
+	if (hMapping != NULL)
+		CloseHandle(hMapping);
+
+	hMapping = NULL;
+	header = nullptr;
+	slots = nullptr;
+
+	return true;
+}
+
+
+/*******************************************************************************
+* Class      : ResultWriter
+* Function   : ResultWriter() constructor
+* Access     : public
+* Arguments  : none
+* Returns    : none
+* Description:
+*   Constructs a ResultWriter with no sinks. Add the sinks, then Start().
+*/
+ResultWriter::ResultWriter() : bStopping(false), bRunning(false)
+{
+}
+
+
+/*******************************************************************************
+* Class      : ResultWriter
+* Function   : ~ResultWriter() destructor
+* Access     : public
+* Arguments  : none
+* Returns    : none
+* Description:
+*   Writes any queued records and stops the writer thread, so output already
+*   produced is not lost when a sweep ends early.
+*/
+ResultWriter::~ResultWriter()
+{
+	Stop();
+}
+
+
+/*******************************************************************************
+* Class      : ResultWriter
+* Function   : AddSink()
+* Access     : public
+* Arguments  : sink = destination for the records
+* Returns    : none
+* Description:
+*   Adds a sink. Must be called before Start().
+*/
+void ResultWriter::AddSink(std::unique_ptr<ResultSink> sink)
+{
+	if (!bRunning)
+		sinks.push_back(std::move(sink));
+}
+
+
+/*******************************************************************************
+* Class      : ResultWriter
+* Function   : Start()
+* Access     : public
+* Arguments  : none
+* Returns    : none
+* Description:
+*   Starts the writer thread
+*/
+void ResultWriter::Start()
+{
+	if (!bRunning)
+	{
+		bStopping.store(false);
+		thread = std::thread(&ResultWriter::Run, this);
+		bRunning = true;
+	}
+}
+
+
+/*******************************************************************************
+* Class      : ResultWriter
+* Function   : Stop()
+* Access     : public
+* Arguments  : none
+* Returns    : true if every sink was written and closed successfully
+* Description:
+*   Waits for the queued records to be written, stops the writer thread and
+*   closes the sinks.
+*/
+bool ResultWriter::Stop()
+{
+	bool bResult = true;
+
+	if (bRunning)
+	{
+		bStopping.store(true, memory_order_release);
+		thread.join();
+		bRunning = false;
+	}
+
+	for (auto& sink : sinks)
+	{
+		if (!sink->Close())
+			bResult = false;
+	}
+	sinks.clear();
+
+	return bResult;
+}
+
+
+/*******************************************************************************
+* Class      : ResultWriter
+* Function   : WriteText()
+* Access     : public
+* Arguments  : szText = text to write
+* Returns    : none
+* Description:
+*   Queues text, such as a header, for the text sinks. Text longer than a
+*   queue slot (RESULT_TEXT_SIZE characters) is queued in as many records as
+*   it takes, which the sinks write back to back.
+*/
+void ResultWriter::WriteText(char const* szText)
+{
+	QueueText(szText, false);
+}
+
+
+/*******************************************************************************
+* Class      : ResultWriter
+* Function   : WriteMessage()
+* Access     : public
+* Arguments  : szText = message to send
+* Returns    : none
+* Description:
+*   Queues a message, such as an error, for a connected client (SocketSink)
+*   only. Sent through the queue, it reaches the client in order with the
+*   results, and never in the middle of one.
+*/
+void ResultWriter::WriteMessage(char const* szText)
+{
+	QueueText(szText, true);
+}
+
+
+/*******************************************************************************
+* Class      : ResultWriter
+* Function   : QueueText()
+* Access     : private
+* Arguments  : szText   = text to queue
+*              bMessage = true if the text is a message for a client only
+* Returns    : none
+* Description:
+*   Queues text in as many records as it takes (see WriteText())
+*/
+void ResultWriter::QueueText(char const* szText, bool bMessage)
+{
+	size_t nRemaining = strlen(szText);
+
+	do
+	{
+		ResultRecord* pRecord = ReserveRecord();
+
+		pRecord->is_point = false;
+		pRecord->is_message = bMessage;
+		pRecord->length = min(nRemaining, RESULT_TEXT_SIZE);
+		memcpy(pRecord->text, szText, pRecord->length);
+		queue.Commit();
+
+		szText += pRecord->length;
+		nRemaining -= pRecord->length;
+	} while (nRemaining > 0);
+}
+
+
+/*******************************************************************************
+* Class      : ResultWriter
+* Function   : WritePoint()
+* Access     : public
+* Arguments  : point = frequency point to output
+* Returns    : none
+* Description:
+*   Formats one frequency point as a tab-separated line directly into a queue
+*   slot and queues it, with the point itself, for the sinks. The row is
+*   formatted once, with full precision, and the same bytes go to every sink.
+*/
+void ResultWriter::WritePoint(FRS const& point)
+{
+	ResultRecord* pRecord = ReserveRecord();
+
+	pRecord->is_point = true;
+	pRecord->is_message = false;
+	pRecord->point = point;
+	pRecord->length = ResultFormatter::FormatRow(pRecord->text, RESULT_TEXT_SIZE, point);
+	queue.Commit();
+}
+
+
+/*******************************************************************************
+* Class      : ResultWriter
+* Function   : ReserveRecord()
+* Access     : private
+* Arguments  : none
+* Returns    : a free queue slot
+* Description:
+*   Returns the next free slot. If the writer has fallen a full queue behind,
+*   this yields until a slot is free rather than dropping output.
+*/
+ResultRecord* ResultWriter::ReserveRecord()
+{
+	ResultRecord* pRecord;
+
+	while ((pRecord = queue.Reserve()) == nullptr)
+		std::this_thread::yield();
+
+	return pRecord;
+}
+
+
+/*******************************************************************************
+* Class      : ResultWriter
+* Function   : Run()
+* Access     : private
+* Arguments  : none
+* Returns    : none
+* Description:
+*   Writer thread. Passes each record to the sinks, flushes them whenever the
+*   queue has been drained, and exits once stopped and empty.
+*/
+void ResultWriter::Run()
+{
+	bool bPending = false;   // records written since the last flush
+
+	for (;;)
+	{
+		ResultRecord* pRecord = queue.Peek();
+
+		if (pRecord != nullptr)
+		{
+			Dispatch(*pRecord);
+			queue.Release();
+			bPending = true;
+			continue;
+		}
+
+		if (bPending)
+		{
+			for (auto& sink : sinks)
+				sink->Flush();
+			bPending = false;
+		}
+
+		if (bStopping.load(memory_order_acquire))
+		{
+			if (queue.Empty())
+				break;
+		}
+		else
+		{
+			Sleep(RESULT_WRITER_IDLE_MSEC);
+		}
+	}
+}
+
+
+/*******************************************************************************
+* Class      : ResultWriter
+* Function   : Dispatch()
+* Access     : private
+* Arguments  : record = record to write
+* Returns    : none
+* Description:
+*   Passes one record to every sink
+*/
+void ResultWriter::Dispatch(ResultRecord const& record)
+{
+	for (auto& sink : sinks)
+		sink->Write(record);
+}
+
+
+/*******************************************************************************
+* Copyright  2026 Kerry S. Martin, martin@wild-wood.net
+* Free for usage without warranty, expressed or implied; attribution required
+*******************************************************************************/
\ No newline at end of file
@@ -0,0 +1,200 @@
+/*******************************************************************************
+* Copyright  2026 Kerry S. Martin, martin@wild-wood.net
+* Free for usage without warranty, expressed or implied; attribution required
+*
+* Filename   : ResultWriter.h
+* Class      : ResultWriter, ResultSink, StreamSink, FileSink, BinarySink, SocketSink,
+*              SharedSink
+* Description:
+*   ResultWriter moves result output off the measurement thread. Each result
+*   is formatted into a preallocated queue slot on the calling thread and
+*   handed to a background writer thread through a lock-free SPSC queue; the
+*   writer thread passes every record to each of its sinks. A slow console,
+*   file or network share therefore never delays the next measurement.
+*
+*   Sinks:
+*     StreamSink   writes the text records to an existing ostream (console)
+*     FileSink     writes the text records to a file it owns
+*     BinarySink   collects the points and writes a binary columnar file
+*                  (FRBinary.h) when the writer is stopped
+*     SocketSink   sends the text records, and the messages meant for the
+*                  client, to a connected LocalSocket
+*     SharedSink   publishes the points to a shared memory ring that other
+*                  local processes can watch live (FRShared.h)
+*
+* Created    : 10/16/2026
+* Modified   : 10/16/2026
+* Author     : Kerry S. Martin, martin@wild-wood.net
+*******************************************************************************/
+#pragma once
+#include "FreqResp.h"
+#include "LocalSocket.h"
+#include "ResultFormatter.h"
+#include "SpscQueue.h"
+#include <atomic>
+#include <fstream>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+constexpr size_t RESULT_TEXT_SIZE = 384;
+static_assert(RESULT_TEXT_SIZE >= ResultFormatter::ROW_SIZE, "result row does not fit a queue slot");
+constexpr size_t RESULT_QUEUE_SIZE = 256;
+
+// shared memory ring layout (FRShared.h)
+struct FRM_Header;
+struct FRM_Slot;
+enum class FRM_State : uint32_t;
+
+// one queued output record: a preformatted text line and, for points, the point itself
+struct ResultRecord
+{
+	bool is_point;
+	bool is_message;		// text for a connected client only (see ResultWriter::WriteMessage())
+	FRS point;
+	size_t length;
+	char text[RESULT_TEXT_SIZE];
+};
+
+
+/*******************************************************************************
+* Class      : ResultSink
+* Description:
+*   Destination for result records. Write() and Close() are called only on
+*   the writer thread.
+*/
+class ResultSink
+{
+public:
+	virtual ~ResultSink() {}
+	virtual void Write(ResultRecord const& record) = 0;
+	virtual void Flush() {}
+	virtual bool Close() { return true; }
+};
+
+
+class StreamSink : public ResultSink
+{
+public:
+	explicit StreamSink(std::ostream& os) : os(os) {}
+	void Write(ResultRecord const& record) override;
+	void Flush() override;
+	bool Close() override;
+
+private:
+	std::ostream& os;
+};
+
+
+class FileSink : public ResultSink
+{
+public:
+	bool Open(std::string filename);
+	void Write(ResultRecord const& record) override;
+	void Flush() override;
+	bool Close() override;
+
+private:
+	std::ofstream file;
+};
+
+
+class BinarySink : public ResultSink
+{
+public:
+	BinarySink(std::string filename, Freq_Config const& freq, Stim_Config const& stim, Channel_Config const& input, Channel_Config const& output, Trig_Config const& trig, Meas_Config const& meas, Dwell_Config const& dwell);
+	void Write(ResultRecord const& record) override;
+	bool Close() override;
+
+private:
+	std::string filename;
+	Freq_Config freq;
+	Stim_Config stim;
+	Channel_Config input;
+	Channel_Config output;
+	Trig_Config trig;
+	Meas_Config meas;
+	Dwell_Config dwell;
+	FRST data;
+};
+
+
+class SocketSink : public ResultSink
+{
+public:
+	explicit SocketSink(LocalSocket& sock) : sock(sock), bFailed(false) {}
+	void Write(ResultRecord const& record) override;
+	bool Close() override;
+
+private:
+	LocalSocket& sock;
+	bool bFailed;
+};
+
+
+class SharedSink : public ResultSink
+{
+public:
+	SharedSink(Freq_Config const& freq, Stim_Config const& stim, Channel_Config const& input, Channel_Config const& output, Trig_Config const& trig, Meas_Config const& meas, Dwell_Config const& dwell);
+	~SharedSink();
+	SharedSink(SharedSink const&) = delete;
+	SharedSink& operator = (SharedSink const&) = delete;
+
+	bool Open(std::string name);
+	void Write(ResultRecord const& record) override;
+	bool Close() override;
+
+private:
+	HANDLE hMapping;
+	FRM_Header* header;
+	FRM_Slot* slots;
+	uint64_t next;		// number of the next point to publish
+	Freq_Config freq;
+	Stim_Config stim;
+	Channel_Config input;
+	Channel_Config output;
+	Trig_Config trig;
+	Meas_Config meas;
+	Dwell_Config dwell;
+
+	void SetState(FRM_State state, bool bNewSweep);
+};
+
+
+class ResultWriter
+{
+public:
+	ResultWriter();
+	~ResultWriter();
+	ResultWriter(ResultWriter const&) = delete;
+	ResultWriter& operator = (ResultWriter const&) = delete;
+
+	void AddSink(std::unique_ptr<ResultSink> sink);
+	void Start();
+	bool Stop();
+
+	// called on the measurement thread
+	void WriteText(char const* szText);
+	void WriteMessage(char const* szText);
+	void WritePoint(FRS const& point);
+
+private:
+	SpscQueue<ResultRecord, RESULT_QUEUE_SIZE> queue;
+	std::vector<std::unique_ptr<ResultSink>> sinks;
+	std::thread thread;
+	std::atomic<bool> bStopping;
+	bool bRunning;
+
+	ResultRecord* ReserveRecord();
+	void QueueText(char const* szText, bool bMessage);
+	void Run();
+	void Dispatch(ResultRecord const& record);
+};
+
+
+/*******************************************************************************
+* Copyright  2026 Kerry S. Martin, martin@wild-wood.net
+* Free for usage without warranty, expressed or implied; attribution required
+*******************************************************************************/
\ No newline at end of file
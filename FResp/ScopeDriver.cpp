@@ -0,0 +1,173 @@
+/*******************************************************************************
+* Copyright  2026 Kerry S. Martin, martin@wild-wood.net
+* Free for usage without warranty, expressed or implied; attribution required
+*
+* Filename   : ScopeDriver.cpp
+* Class      : ScopeDriver
+* Description:
+*   ScopeDriver is the interface FreqResp uses to control an oscilloscope, and
+*   the table of the supported models and their drivers.
+*
+* Created    : 10/16/2026
+* Modified   : 10/16/2026
+* Author     : Kerry S. Martin, martin@wild-wood.net
+*******************************************************************************/
+
+#include "ScopeDriver.h"
+#include "Oscilloscope.h"
+#include "Socket_Instrument.h"
+
+using namespace std;
+
+// driver constructors for the model table
+static ScopeDriver* CreateSiglentSDS() { return new Oscilloscope(); }
+
+
+/*******************************************************************************
+* Class      : ScopeDriver
+* Member     : ScopeModels table
+* Access     : private static constant
+* Arguments  : n/a
+* Returns    : n/a
+* Description:
+*   Supported models, matched in order against the *IDN? manufacturer
+*   (pattern found) and model (pattern matches all of it). The last entry
+*   matches any instrument.
+*/
+const ScopeDriver::ScopeModel ScopeDriver::ScopeModels[]
+{
+	// Siglent SDS1000X-E (SDS1104X-E, SDS1202X-E, ...)
+	{ "siglent", "SDS1[0-9]{3}X-E",	CAP_BINARY_WAVEFORM | CAP_MULTI_QUERY | CAP_SEGMENTED,	CreateSiglentSDS },
+
+	// any other model: the SDS1000X-E commands, with no optional capabilities
+	{ "",        ".*",				CAP_NONE,												CreateSiglentSDS }
+};
+
+
+/*******************************************************************************
+* Class      : ScopeDriver
+* Member     : nScopeModels constant
+* Access     : private static constant
+* Arguments  : n/a
+* Returns    : n/a
+* Description:
+*   Number of entries in the ScopeModels[] table
+*/
+const unsigned int ScopeDriver::nScopeModels{ sizeof(ScopeModels) / sizeof(ScopeModel) };
+
+
+/*******************************************************************************
+* Class      : ScopeDriver
+* Function   : ScopeDriver() constructor
+* Access     : public
+* Arguments  : none
+* Returns    : none
+* Description:
+*   Constructs a driver with no identification and no optional capabilities.
+*   Open() sets them from the model table.
+*/
+ScopeDriver::ScopeDriver() : ident(), caps(CAP_NONE)
+{
+}
+
+
+/*******************************************************************************
+* Class      : ScopeDriver
+* Function   : Open()
+* Access     : public static
+* Arguments  : resource = resource name string for instrument (ex/ "192.168.0.197:5025")
+* Returns    : the attached driver, or nullptr if the instrument could not be
+*              attached
+* Description:
+*   Connects to the oscilloscope at resource, identifies it on that connection,
+*   and creates the driver of its model, which takes over the connection. An
+*   instrument that does not answer *IDN?, or whose answer cannot be parsed,
+*   gets the driver of the last entry (no optional capabilities).
+*/
+std::unique_ptr<ScopeDriver> ScopeDriver::Open(std::string resource)
+{
+	Socket_Instrument connection;
+	vector<string> responses;
+	InstrumentIdent id;
+
+	if (!connection.Attach(resource))
+		return nullptr;
+
+	// the response is read up to its newline, however it is split between receives
+	if (!connection.QueryBatch({ "*IDN?" }, responses) || !id.Parse(responses[0]))
+	{
+		id = InstrumentIdent();
+
+		// an unanswered query leaves the connection unusable (see QueryBatch())
+		if (!connection.IsConnected() && !connection.Reconnect())
+			return nullptr;
+	}
+
+	for (unsigned int i = 0; i < nScopeModels; ++i)
+	{
+		if (id.Matches(ScopeModels[i].manufacturer, ScopeModels[i].model))
+		{
+			unique_ptr<ScopeDriver> driver(ScopeModels[i].create());
+			driver->ident = id;
+			driver->caps = ScopeModels[i].caps;
+
+			if (!driver->Attach(connection))
+				driver.reset();
+
+			return driver;
+		}
+	}
+
+	return nullptr;
+}
+
+
+/*******************************************************************************
+* Class      : ScopeDriver
+* Function   : Ident()
+* Access     : public
+* Arguments  : none
+* Returns    : identification of the attached model
+* Description:
+*   Returns the *IDN? fields read by Open()
+*/
+InstrumentIdent const& ScopeDriver::Ident() const
+{
+	return ident;
+}
+
+
+/*******************************************************************************
+* Class      : ScopeDriver
+* Function   : Caps()
+* Access     : public
+* Arguments  : none
+* Returns    : capabilities of the attached model (InstrCap flags)
+* Description:
+*   Returns the optional capabilities of the model
+*/
+unsigned int ScopeDriver::Caps() const
+{
+	return caps;
+}
+
+
+/*******************************************************************************
+* Class      : ScopeDriver
+* Function   : Supports()
+* Access     : public
+* Arguments  : cap = InstrCap flag(s)
+* Returns    : true if the model has every capability in cap
+* Description:
+*   Tests for optional capabilities of the model
+*/
+bool ScopeDriver::Supports(unsigned int cap) const
+{
+	return (caps & cap) == cap;
+}
+
+
+/*******************************************************************************
+* Copyright  2026 Kerry S. Martin, martin@wild-wood.net
+* Free for usage without warranty, expressed or implied; attribution required
+*******************************************************************************/
\ No newline at end of file
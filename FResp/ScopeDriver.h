@@ -0,0 +1,118 @@
+/*******************************************************************************
+* Copyright  2026 Kerry S. Martin, martin@wild-wood.net
+* Free for usage without warranty, expressed or implied; attribution required
+*
+* Filename   : ScopeDriver.h
+* Class      : ScopeDriver
+* Description:
+*   ScopeDriver is the interface FreqResp uses to control an oscilloscope.
+*   Each supported model has a driver implementing it (Oscilloscope is the
+*   driver for the Siglent SDS1000X-E).
+*
+*   Open() connects to the instrument once, reads its *IDN? on that
+*   connection, and creates the driver of the first matching entry of the
+*   model table, with the capabilities of that model (see InstrumentModel.h),
+*   which takes over the connection. A model that is not in the table, or
+*   that does not identify itself, is driven by the last entry, with no
+*   optional capabilities, so FreqResp only uses the measurements every model
+*   has.
+*
+* Created    : 10/16/2026
+* Modified   : 10/16/2026
+* Author     : Kerry S. Martin, martin@wild-wood.net
+*******************************************************************************/
+#pragma once
+#include "InstrumentModel.h"
+#include <limits>
+#include <memory>
+#include <string>
+#include <vector>
+
+class Socket_Instrument;
+
+class ScopeDriver
+{
+public:
+	ScopeDriver();
+	virtual ~ScopeDriver() {}
+
+	// creates and attaches the driver for the model at resource (nullptr on failure)
+	static std::unique_ptr<ScopeDriver> Open(std::string resource);
+
+	// model identification and capabilities
+	InstrumentIdent const& Ident() const;
+	unsigned int Caps() const;
+	bool Supports(unsigned int cap) const;
+
+	// many setting types
+	enum class Channel { CH1, CH2, CH3, CH4 };
+	enum class VoltsPerDiv { UNSPEC, V_500uV, V_1mV, V_2mV, V_5mV, V_10mV, V_20mV, V_50mV, V_100mV, V_200mV, V_500mV, V_1V, V_2V, V_5V, V_10V, V_20V, V_50V, V_100V }; // 500uV only at 1x, 100V at 10x
+	enum class BWLimit { UNSPEC, BWL_FULL, BWL_ON };
+	enum class ChInvert { UNSPEC, INV_OFF, INV_ON };
+	enum class Coupling { UNSPEC, DC, AC };
+	enum class ChAtten { UNSPEC, AT_1X, AT_10X };
+	enum class ChUnit { UNSPEC, V /*, A */ };  // for now, A is not supported TODO: support eventually
+	enum class EdgeType { RISING, FALLING };
+	enum class TriggerMode { STOP, AUTO, NORMAL, SINGLE };
+	enum class MeasParam { PKPK, MAX, MIN, AMPL, TOP, BASE, CMEAN, MEAN, RMS, CRMS, OVSN, FPRE, OVSP, RPRE, PER, FREQ, PWID, NWID, RISE, FALL, WID, DUTY, NDUTY };
+	enum class MeasDelParam { PHA, FRR, FRF, FFR, FFF, LRR, LRF, LFR, LFF, SKEW };
+	enum class MemDepth { UNSPEC, M_14K, M_140K, M_1_4M, M_14M };
+	enum class TimeDiv { UNSPEC, T_1nS, T_2nS, T_5nS, T_10nS, T_20nS, T_50nS, T_100nS, T_200nS, T_500nS, T_1uS, T_2uS, T_5uS, T_10uS, T_20uS, T_50uS, T_100uS, T_200uS, T_500uS, T_1mS, T_2mS, T_5mS, T_10mS, T_20mS, T_50mS, T_100mS, T_200mS, T_500mS, T_1S, T_2S, T_5S, T_10S, T_20S, T_50S, T_100S };
+	struct ScaleValues { double max; double min; double pp; double offset; double vdiv; };
+	struct ChBWLPair { Channel ch; BWLimit bwl; };
+	struct FrameMeas { double in; double out; double delay; };
+
+	// connection to an instrument
+	virtual bool Attach(std::string resource) = 0;
+	virtual bool Attach(Socket_Instrument& connection) = 0;		// takes over a connection (see Open())
+	virtual bool Detach() = 0;
+	virtual bool Reconnect() = 0;
+	virtual bool IsConnected() const = 0;
+
+	// channel configuration
+	virtual bool SetChannelEnable(Channel ch, bool enabled) = 0;
+	virtual bool SetChannelVoltsEx(Channel ch, double vdiv, double offset) = 0;
+	virtual bool SetChannelBWL(Channel ch, BWLimit bwl) = 0;
+	virtual bool SetChannelAtten(Channel ch, ChAtten atten) = 0;
+	virtual bool SetChannelCoupling(Channel ch, Coupling coup) = 0;
+	virtual int AdjustChannelVolts(Channel ch, int adjust, ScaleValues& scale) = 0;
+
+	// timebase configuration (delay NaN = no change)
+	virtual bool SetCapture(TimeDiv tdiv, MemDepth depth, double delay = std::numeric_limits<double>::quiet_NaN()) = 0;
+	virtual double FindTimebase(double tcapture, TimeDiv& tdiv) const = 0;
+	virtual MemDepth FindMemoryDepth(double tcapture, double rate) const = 0;
+
+	// trigger configuration
+	virtual bool SetTriggerMode(TriggerMode mode) = 0;
+	virtual bool SetEdgeTrigger(Channel ch, EdgeType edge, double voltage, Coupling coup, bool holdoff, double tHoldoff) = 0;
+	virtual double HoldoffMax() const = 0;
+
+	// measurements
+	// MeasureSet() reads both amplitudes and the delay together (CAP_MULTI_QUERY: in one transmission)
+	virtual double Measure(Channel ch, MeasParam param) = 0;
+	virtual double MeasureDelay(Channel ch1, Channel ch2, MeasDelParam param) = 0;
+	virtual bool MeasureSet(Channel chIn, Channel chOut, MeasParam param, MeasDelParam delParam, FrameMeas& meas) = 0;
+
+	// segmented (sequence) acquisition (CAP_SEGMENTED)
+	virtual bool SetSequence(unsigned int nSegments) = 0;
+	virtual bool WaitForStop(double timeout) = 0;
+	virtual bool MeasureFrames(unsigned int nFrames, Channel chIn, Channel chOut, MeasParam param, MeasDelParam delParam, std::vector<FrameMeas>& frames) = 0;
+
+	// waveform of the last capture, at most nPointsMax samples (CAP_BINARY_WAVEFORM)
+	virtual bool ReadWaveform(Channel ch, unsigned int nPointsMax, std::vector<double>& volts, double& tSample) = 0;
+
+protected:
+	InstrumentIdent ident;
+	unsigned int caps;
+
+private:
+	struct ScopeModel { char const* manufacturer; char const* model; unsigned int caps; ScopeDriver* (*create)(); };
+	static const ScopeModel ScopeModels[];
+	static const unsigned int nScopeModels;
+};
+
+
+/*******************************************************************************
+* Copyright  2026 Kerry S. Martin, martin@wild-wood.net
+* Free for usage without warranty, expressed or implied; attribution required
+*******************************************************************************/
\ No newline at end of file
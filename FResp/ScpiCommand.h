@@ -0,0 +1,180 @@
+/*******************************************************************************
+* Copyright  2026 Kerry S. Martin, martin@wild-wood.net
+* Free for usage without warranty, expressed or implied; attribution required
+*
+* Filename   : ScpiCommand.h
+* Class      : ScpiCommand, ScpiTemplate
+* Description:
+*   ScpiCommand formats an SCPI command into a fixed buffer, with no
+*   allocation. Each instrument owns one, so a command is built and sent
+*   without a temporary string for every part of it.
+*
+*   Commands are built from templates in which each {} is replaced by an
+*   argument in turn:
+*     static constexpr auto SOUR_FREQ = SCPI_TEMPLATE(":SOUR{}:FREQ {}");
+*     cmd.Format(SOUR_FREQ, "1", 1234.5678);   // ":SOUR1:FREQ 1234.5678"
+*   The number of fields is counted when the template is compiled, and a
+*   Format() call with the wrong number of arguments does not compile.
+*
+*   Arguments may be text (char const*, std::string, a single char) or
+*   numbers. Floating point values are written by std::to_chars with the
+*   fewest digits that read back exactly, so no precision is lost (unlike
+*   std::to_string, which rounds to 6 decimal places). A command too long
+*   for the buffer is marked as overflowed and is not sent.
+*
+* Created    : 10/16/2026
+* Modified   : 10/16/2026
+* Author     : Kerry S. Martin, martin@wild-wood.net
+*******************************************************************************/
+#pragma once
+#include <charconv>
+#include <cstddef>
+#include <cstring>
+#include <string>
+#include <type_traits>
+
+constexpr size_t SCPI_COMMAND_SIZE = 256;
+
+// number of {} fields in a command template
+constexpr size_t ScpiFields(char const* szTemplate)
+{
+	size_t n = 0;
+
+	for (; *szTemplate != 0; ++szTemplate)
+	{
+		if (szTemplate[0] == '{' && szTemplate[1] == '}')
+			++n;
+	}
+
+	return n;
+}
+
+// command template with its number of fields, see SCPI_TEMPLATE
+template<size_t N>
+struct ScpiTemplate
+{
+	char const* text;
+};
+
+#define SCPI_TEMPLATE(text) ScpiTemplate<ScpiFields(text)>{ text }
+
+
+class ScpiCommand
+{
+public:
+	ScpiCommand() : length(0), bOverflow(false) { buffer[0] = 0; }
+	ScpiCommand(ScpiCommand const&) = delete;
+	ScpiCommand& operator = (ScpiCommand const&) = delete;
+
+	// replace the command with the template and its arguments
+	template<size_t N, class... Args>
+	ScpiCommand& Format(ScpiTemplate<N> const& t, Args const&... args)
+	{
+		static_assert(sizeof...(Args) == N, "SCPI command template and arguments do not match");
+
+		Clear();
+		char const* p = t.text;
+		(void(p = AppendField(p, args)), ...);
+		return Append(p);
+	}
+
+	ScpiCommand& Clear()
+	{
+		length = 0;
+		bOverflow = false;
+		buffer[0] = 0;
+		return *this;
+	}
+
+	ScpiCommand& Append(char const* sz)
+	{
+		return AppendText(sz, strlen(sz));
+	}
+
+	ScpiCommand& Append(std::string const& str)
+	{
+		return AppendText(str.data(), str.size());
+	}
+
+	ScpiCommand& Append(char c)
+	{
+		return AppendText(&c, 1);
+	}
+
+	ScpiCommand& Append(double value)
+	{
+		return bOverflow ? *this : AppendResult(std::to_chars(buffer + length, buffer + SCPI_COMMAND_SIZE - 1, value));
+	}
+
+	template<class T, typename std::enable_if<std::is_integral<T>::value, int>::type = 0>
+	ScpiCommand& Append(T value)
+	{
+		return bOverflow ? *this : AppendResult(std::to_chars(buffer + length, buffer + SCPI_COMMAND_SIZE - 1, value));
+	}
+
+	// end the command with a newline, if it does not have one
+	ScpiCommand& Terminate()
+	{
+		return (length > 0 && buffer[length - 1] == '\n') ? *this : Append('\n');
+	}
+
+	char const* c_str() const { return buffer; }
+	size_t size() const { return length; }
+	bool Overflow() const { return bOverflow; }
+	std::string str() const { return std::string(buffer, length); }
+
+private:
+	char buffer[SCPI_COMMAND_SIZE];
+	size_t length;
+	bool bOverflow;
+
+	// copies the template up to its next field, then the argument in its place
+	template<class T>
+	char const* AppendField(char const* p, T const& arg)
+	{
+		char const* pField = strstr(p, "{}");
+
+		AppendText(p, size_t(pField - p));
+		Append(arg);
+
+		return pField + 2;
+	}
+
+	ScpiCommand& AppendText(char const* p, size_t n)
+	{
+		if (bOverflow || length + n >= SCPI_COMMAND_SIZE)
+		{
+			bOverflow = true;
+		}
+		else
+		{
+			memcpy(buffer + length, p, n);
+			length += n;
+			buffer[length] = 0;
+		}
+
+		return *this;
+	}
+
+	ScpiCommand& AppendResult(std::to_chars_result result)
+	{
+		if (result.ec != std::errc())
+		{
+			bOverflow = true;
+			buffer[length] = 0;
+		}
+		else
+		{
+			length = size_t(result.ptr - buffer);
+			buffer[length] = 0;
+		}
+
+		return *this;
+	}
+};
+
+
+/*******************************************************************************
+* Copyright  2026 Kerry S. Martin, martin@wild-wood.net
+* Free for usage without warranty, expressed or implied; attribution required
+*******************************************************************************/
\ No newline at end of file
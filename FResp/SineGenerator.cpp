@@ -9,7 +9,7 @@
 *   generate a sinusoidal waveform.
 *
 * Created    : 05/25/2020
-* Modified   : 01/02/2023
+* Modified   : 10/16/2026
 * Author     : Kerry S. Martin, martin@wild-wood.net
 *******************************************************************************/
 
@@ -19,6 +19,29 @@
 using namespace std;
 
 
+// most frequencies in a stepped sweep
+const unsigned int SineGenerator::SWEEP_STEPS_MAX{ 2048 };
+
+// command templates (see ScpiCommand.h), the first field is the channel
+static constexpr auto SOUR_FREQ = SCPI_TEMPLATE(":SOUR{}:FREQ {}");
+static constexpr auto SOUR_VOLT = SCPI_TEMPLATE(":SOUR{}:VOLT {}");
+static constexpr auto SOUR_VOLT_OFFS = SCPI_TEMPLATE(":SOUR{}:VOLT:OFFS {}");
+static constexpr auto SOUR_PHAS = SCPI_TEMPLATE(":SOUR{}:PHAS {}");
+static constexpr auto SOUR_PHAS_SYNC = SCPI_TEMPLATE(":SOUR{}:PHAS:SYNC");
+static constexpr auto OUTP = SCPI_TEMPLATE(":OUTP{} {}");
+static constexpr auto SWE_SPAC_STE = SCPI_TEMPLATE(":SOUR{}:SWE:SPAC STE");
+static constexpr auto SWE_STEP = SCPI_TEMPLATE(":SOUR{}:SWE:STEP {}");
+static constexpr auto FREQ_STAR = SCPI_TEMPLATE(":SOUR{}:FREQ:STAR {}");
+static constexpr auto FREQ_STOP = SCPI_TEMPLATE(":SOUR{}:FREQ:STOP {}");
+static constexpr auto SWE_TIME = SCPI_TEMPLATE(":SOUR{}:SWE:TIME {}");
+static constexpr auto SWE_HTIM_STAR = SCPI_TEMPLATE(":SOUR{}:SWE:HTIM:STAR 0");
+static constexpr auto SWE_HTIM_STOP = SCPI_TEMPLATE(":SOUR{}:SWE:HTIM:STOP 0");
+static constexpr auto SWE_RTIM = SCPI_TEMPLATE(":SOUR{}:SWE:RTIM 0");
+static constexpr auto SWE_TRIG_SOUR_MAN = SCPI_TEMPLATE(":SOUR{}:SWE:TRIG:SOUR MAN");
+static constexpr auto SWE_STAT = SCPI_TEMPLATE(":SOUR{}:SWE:STAT {}");
+static constexpr auto SWE_TRIG_IMM = SCPI_TEMPLATE(":SOUR{}:SWE:TRIG:IMM");
+
+
 /*******************************************************************************
 * Class      : SineGenerator
 * Function   : SineGenerator() constructor
@@ -68,6 +91,26 @@ bool SineGenerator::Attach(std::string resource)
 }
 
 
+/*******************************************************************************
+* Class      : SineGenerator
+* Function   : Attach()
+* Access     : public
+* Arguments  : connection = attached connection to the instrument
+* Returns    : true if successful (instrument was attached), false if not
+* Description:
+*   Takes over a connection to the instrument (see GeneratorDriver::Open())
+*/
+bool SineGenerator::Attach(Socket_Instrument& connection)
+{
+	bool bResult = false;
+
+	if (Socket_Instrument::Adopt(connection))
+		bResult = SetupSineGeneratorDefault();
+
+	return bResult;
+}
+
+
 #if 0
 /*******************************************************************************
 * Class      : SineGenerator
@@ -107,19 +150,55 @@ bool SineGenerator::Detach()
 
 /*******************************************************************************
 * Class      : SineGenerator
-* Function   : GetChannelString()
+* Function   : Reconnect()
+* Access     : public
+* Arguments  : none
+* Returns    : true if successful (instrument was re-attached), false if not
+* Description:
+*   Re-attaches to the instrument after a lost connection and puts it back in
+*   the default instrument state. The caller restores any other settings.
+*/
+bool SineGenerator::Reconnect()
+{
+	bool bResult = false;
+
+	if (Socket_Instrument::Reconnect())
+		bResult = SetupSineGeneratorDefault();
+
+	return bResult;
+}
+
+
+/*******************************************************************************
+* Class      : SineGenerator
+* Function   : IsConnected()
+* Access     : public
+* Arguments  : none
+* Returns    : true if attached and communicating, false otherwise
+* Description:
+*   Reports whether the connection to the instrument is healthy
+*/
+bool SineGenerator::IsConnected() const
+{
+	return Socket_Instrument::IsConnected();
+}
+
+
+/*******************************************************************************
+* Class      : SineGenerator
+* Function   : GetChannelName()
 * Access     : private static
 * Arguments  : ch = Channel enum
-* Returns    : string designation of channel
+* Returns    : designation of channel (static, not to be freed)
 * Description:
-*   Get the string designation for the given channel
+*   Get the designation for the given channel
 */
-string SineGenerator::GetChannelString(Channel ch)
+char const* SineGenerator::GetChannelName(Channel ch)
 {
 	switch (ch)
 	{
-	case Channel::CH1: default:		return string("1");
-	case Channel::CH2:				return string("2");
+	case Channel::CH1: default:		return "1";
+	case Channel::CH2:				return "2";
 	}
 }
 
@@ -180,33 +259,19 @@ bool SineGenerator::SetChannel(Channel ch, double freq, double Vpp, double Voffs
 {
 	bool bResult = true;
 
-	const string strCh = GetChannelString(ch);
-	string strCommand;
+	char const* const szCh = GetChannelName(ch);
 
 	if (!isnan(freq))
-	{
-		strCommand = ":SOUR" + strCh + ":FREQ " + std::to_string(freq);
-		bResult = Write(strCommand);
-	}
+		bResult = Write(cmd.Format(SOUR_FREQ, szCh, freq));
 
 	if (bResult && !isnan(Vpp))
-	{
-		strCommand = ":SOUR" + strCh + ":VOLT " + std::to_string(Vpp);
-		bResult = Write(strCommand);
-	}
+		bResult = Write(cmd.Format(SOUR_VOLT, szCh, Vpp));
 
 	if (bResult && !isnan(Voffs))
-	{
-		strCommand = ":SOUR" + strCh + ":VOLT:OFFS " + std::to_string(Voffs);
-		bResult = Write(strCommand);
-	}
+		bResult = Write(cmd.Format(SOUR_VOLT_OFFS, szCh, Voffs));
 
 	if (bResult && !isnan(phase))
-	{
-		phase = CoercePhase(phase);
-		strCommand = ":SOUR" + strCh + ":PHAS " + std::to_string(phase);
-		bResult = Write(strCommand);
-	}
+		bResult = Write(cmd.Format(SOUR_PHAS, szCh, CoercePhase(phase)));
 
 	return bResult;
 }
@@ -224,13 +289,48 @@ bool SineGenerator::SetChannel(Channel ch, double freq, double Vpp, double Voffs
 */
 bool SineGenerator::SetChannelFreq(Channel ch, double freq)
 {
-	const string strCh = GetChannelString(ch);
-	const string strCommand = ":SOUR" + strCh + ":FREQ " + std::to_string(freq);
-	bool bResult = Write(strCommand);
+	bool bResult = Write(cmd.Format(SOUR_FREQ, GetChannelName(ch), freq));
 	return bResult;
 }
 
 
+/*******************************************************************************
+* Class      : SineGenerator
+* Function   : FormatChannelFreq()
+* Access     : public
+* Arguments  : ch    = channel to set
+*              freq  = frequency (Hz)
+* Returns    : the command that sets the channel frequency
+* Description:
+*   Formats the frequency command so that it can be prepared in advance and
+*   sent later with SendCommand().
+*/
+std::string SineGenerator::FormatChannelFreq(Channel ch, double freq) const
+{
+	ScpiCommand command;
+
+	return command.Format(SOUR_FREQ, GetChannelName(ch), freq).str();
+}
+
+
+/*******************************************************************************
+* Class      : SineGenerator
+* Function   : SendCommand()
+* Access     : public
+* Arguments  : command = command prepared by one of the Format functions
+* Returns    : true if successful, false otherwise
+* Description:
+*   Sends a command that was formatted in advance
+*/
+bool SineGenerator::SendCommand(std::string const& command)
+{
+	if (command.empty())
+		return false;
+
+	return Write(command);
+}
+
+
 /*******************************************************************************
 * Class      : SineGenerator
 * Function   : SetChannelVpp()
@@ -243,9 +343,7 @@ bool SineGenerator::SetChannelFreq(Channel ch, double freq)
 */
 bool SineGenerator::SetChannelVpp(Channel ch, double Vpp)
 {
-	const string strCh = GetChannelString(ch);
-	const string strCommand = ":SOUR" + strCh + ":VOLT " + std::to_string(Vpp);
-	bool bResult = Write(strCommand);
+	bool bResult = Write(cmd.Format(SOUR_VOLT, GetChannelName(ch), Vpp));
 	return bResult;
 }
 
@@ -262,9 +360,7 @@ bool SineGenerator::SetChannelVpp(Channel ch, double Vpp)
 */
 bool SineGenerator::SetChannelVoffs(Channel ch, double Voffs)
 {
-	const string strCh = GetChannelString(ch);
-	const string strCommand = ":SOUR" + strCh + ":VOLT:OFFS " + std::to_string(Voffs);
-	bool bResult = Write(strCommand);
+	bool bResult = Write(cmd.Format(SOUR_VOLT_OFFS, GetChannelName(ch), Voffs));
 	return bResult;
 }
 
@@ -281,9 +377,7 @@ bool SineGenerator::SetChannelVoffs(Channel ch, double Voffs)
 */
 bool SineGenerator::SetChannelPhase(Channel ch, double phase)
 {
-	const string strCh = GetChannelString(ch);
-	const string strCommand = ":SOUR" + strCh + ":PHAS " + std::to_string(CoercePhase(phase));
-	bool bResult = Write(strCommand);
+	bool bResult = Write(cmd.Format(SOUR_PHAS, GetChannelName(ch), CoercePhase(phase)));
 	return bResult;
 }
 
@@ -299,9 +393,7 @@ bool SineGenerator::SetChannelPhase(Channel ch, double phase)
 */
 bool SineGenerator::AlignChannel(Channel ch)
 {
-	const string strCh = GetChannelString(ch);
-	const string strCommand = ":SOUR" + strCh + ":PHAS:SYNC";
-	bool bResult = Write(strCommand);
+	bool bResult = Write(cmd.Format(SOUR_PHAS_SYNC, GetChannelName(ch)));
 	return bResult;
 }
 
@@ -318,14 +410,101 @@ bool SineGenerator::AlignChannel(Channel ch)
 */
 bool SineGenerator::SetChannelOutput(Channel ch, bool output)
 {
-	const string strCh = GetChannelString(ch);
-	const string strOutput = output?"ON":"OFF";
-	const string strCommand = ":OUTP" + strCh + " " + strOutput;
-	bool bResult = Write(strCommand);
+	bool bResult = Write(cmd.Format(OUTP, GetChannelName(ch), output ? "ON" : "OFF"));
 	return bResult;
 }
 
 
+/*******************************************************************************
+* Class      : SineGenerator
+* Function   : SetStepSweep()
+* Access     : public
+* Arguments  : ch     = channel to sweep
+*              fStart = first frequency
+*              fStop  = last frequency
+*              nSteps = number of frequencies, evenly spaced (2 to SWEEP_STEPS_MAX)
+*              tSweep = time of the whole sweep (seconds), tSweep/nSteps per frequency
+* Returns    : true if successful, false otherwise
+* Description:
+*   Configures the generator's own stepped sweep. The sweep waits for
+*   TriggerSweep().
+*/
+bool SineGenerator::SetStepSweep(Channel ch, double fStart, double fStop, unsigned int nSteps, double tSweep)
+{
+	if (nSteps < 2 || nSteps > SWEEP_STEPS_MAX)
+		return false;
+
+	char const* const szCh = GetChannelName(ch);
+
+	bool bResult = Write(cmd.Format(SWE_SPAC_STE, szCh));
+	if (bResult)
+		bResult = Write(cmd.Format(SWE_STEP, szCh, nSteps));
+	if (bResult)
+		bResult = Write(cmd.Format(FREQ_STAR, szCh, fStart));
+	if (bResult)
+		bResult = Write(cmd.Format(FREQ_STOP, szCh, fStop));
+	if (bResult)
+		bResult = Write(cmd.Format(SWE_TIME, szCh, tSweep));
+	if (bResult)
+		bResult = Write(cmd.Format(SWE_HTIM_STAR, szCh));
+	if (bResult)
+		bResult = Write(cmd.Format(SWE_HTIM_STOP, szCh));
+	if (bResult)
+		bResult = Write(cmd.Format(SWE_RTIM, szCh));
+	if (bResult)
+		bResult = Write(cmd.Format(SWE_TRIG_SOUR_MAN, szCh));
+	if (bResult)
+		bResult = Write(cmd.Format(SWE_STAT, szCh, "ON"));
+
+	return bResult;
+}
+
+
+/*******************************************************************************
+* Class      : SineGenerator
+* Function   : TriggerSweep()
+* Access     : public
+* Arguments  : ch = channel to sweep
+* Returns    : true if successful, false otherwise
+* Description:
+*   Starts the sweep configured by SetStepSweep()
+*/
+bool SineGenerator::TriggerSweep(Channel ch)
+{
+	return Write(cmd.Format(SWE_TRIG_IMM, GetChannelName(ch)));
+}
+
+
+/*******************************************************************************
+* Class      : SineGenerator
+* Function   : StopSweep()
+* Access     : public
+* Arguments  : ch = channel to sweep
+* Returns    : true if successful, false otherwise
+* Description:
+*   Turns the sweep off; the channel returns to a fixed frequency
+*/
+bool SineGenerator::StopSweep(Channel ch)
+{
+	return Write(cmd.Format(SWE_STAT, GetChannelName(ch), "OFF"));
+}
+
+
+/*******************************************************************************
+* Class      : SineGenerator
+* Function   : SweepStepsMax()
+* Access     : public
+* Arguments  : none
+* Returns    : most frequencies in a stepped sweep
+* Description:
+*   Returns SWEEP_STEPS_MAX, the most frequencies SetStepSweep() accepts
+*/
+unsigned int SineGenerator::SweepStepsMax() const
+{
+	return SWEEP_STEPS_MAX;
+}
+
+
 /*******************************************************************************
 * Copyright  2023 Kerry S. Martin, martin@wild-wood.net
 * Free for usage without warranty, expressed or implied; attribution required
@@ -6,37 +6,53 @@
 * Class      : SineGenerator
 * Description:
 *   Implements an interface to a Rigol DG800 series signal generator used to
-*   generate a sinusoidal waveform.
+*   generate a sinusoidal waveform. This is the GeneratorDriver for that
+*   model (see GeneratorDriver.h).
 *
 * Created    : 05/25/2020
-* Modified   : 01/02/2023
+* Modified   : 10/16/2026
 * Author     : Kerry S. Martin, martin@wild-wood.net
 *******************************************************************************/
 #pragma once
+#include "GeneratorDriver.h"
 #include "Socket_Instrument.h"
 
 class SineGenerator :
-	protected Socket_Instrument
+	public GeneratorDriver, protected Socket_Instrument
 {
 public:
 	SineGenerator();
 	virtual ~SineGenerator();
-	virtual bool Attach(std::string resource);
+	bool Attach(std::string resource) override;
+	bool Attach(Socket_Instrument& connection) override;
 	//virtual bool Attach(std::regex pattern);
-	virtual bool Detach();
+	bool Detach() override;
+	bool Reconnect() override;
+	bool IsConnected() const override;
 
-	enum class Channel { CH1, CH2 };
-	bool SetChannel(Channel ch, double freq=DEFAULT_PARAM, double Vpp = DEFAULT_PARAM, double Voffs=DEFAULT_PARAM, double phase=DEFAULT_PARAM);
-	bool SetChannelFreq(Channel ch, double freq);
+	// Channel is that of GeneratorDriver
+	bool SetChannel(Channel ch, double freq=DEFAULT_PARAM, double Vpp = DEFAULT_PARAM, double Voffs=DEFAULT_PARAM, double phase=DEFAULT_PARAM) override;
+	bool SetChannelFreq(Channel ch, double freq) override;
 	bool SetChannelVpp(Channel ch, double Vpp);
 	bool SetChannelVoffs(Channel ch, double Voffs);
 	bool SetChannelPhase(Channel ch, double phase);
-	bool SetChannelOutput(Channel ch, bool output);
+	bool SetChannelOutput(Channel ch, bool output) override;
 	bool AlignChannel(Channel ch);
 
+	// native stepped frequency sweep
+	bool SetStepSweep(Channel ch, double fStart, double fStop, unsigned int nSteps, double tSweep) override;
+	bool TriggerSweep(Channel ch) override;
+	bool StopSweep(Channel ch) override;
+	unsigned int SweepStepsMax() const override;
+	static const unsigned int SWEEP_STEPS_MAX;
+
+	// commands prepared in advance and sent later
+	std::string FormatChannelFreq(Channel ch, double freq) const override;
+	bool SendCommand(std::string const& command) override;
+
 private:
 	bool SetupSineGeneratorDefault();
-	static std::string GetChannelString(Channel ch);
+	static char const* GetChannelName(Channel ch);
 	static double CoercePhase(double phase);
 };
 
@@ -9,7 +9,7 @@
 *   instrument over a LAN using Winsock
 *
 * Created    : 11/05/2021
-* Modified   : 01/02/2023
+* Modified   : 10/16/2026
 * Author     : Kerry S. Martin, martin@wild-wood.net
 *******************************************************************************/
 
@@ -20,6 +20,11 @@
 #pragma comment(lib, "Ws2_32.lib")
 
 constexpr auto RECV_BUFLEN = 256;
+constexpr auto RECV_TIMEOUT_MSEC = 10000;			// a query not answered within this time is treated as a lost connection
+constexpr auto CONNECT_TIMEOUT_MSEC = 2000;			// default time allowed to connect to each address of a resource
+constexpr auto RECONNECT_ATTEMPTS = 5;				// number of attempts made by Reconnect()
+constexpr auto RECONNECT_BACKOFF_MSEC = 250;		// delay before the second attempt, doubled for each subsequent attempt
+constexpr auto RECONNECT_BACKOFF_MAX_MSEC = 4000;	// upper limit for the delay between attempts
 
 
 using namespace std;
@@ -27,7 +32,8 @@ using namespace std;
 // define all static class variables
 const double Socket_Instrument::DEFAULT_PARAM{ numeric_limits<double>::quiet_NaN() };
 bool Socket_Instrument::bSocketsInitialized{ false };
-int Socket_Instrument::nInstrAttached{ 0 };
+std::atomic<int> Socket_Instrument::nInstrAttached{ 0 };
+std::atomic<unsigned long> Socket_Instrument::connectTimeout_msec{ CONNECT_TIMEOUT_MSEC };
 WSADATA Socket_Instrument::wsaData{};
 
 
@@ -105,6 +111,7 @@ Socket_Instrument::Socket_Instrument()
 	connected_socket = INVALID_SOCKET;
 
 	bAttached = false;
+	bConnectionLost = false;
 }
 
 
@@ -126,6 +133,87 @@ Socket_Instrument::~Socket_Instrument()
 }
 
 
+/*******************************************************************************
+* Class      : Socket_Instrument
+* Function   : SetConnectTimeout()
+* Access     : public static
+* Arguments  : msec = time allowed to connect to each address (milliseconds)
+* Returns    : none
+* Description:
+*   Sets the time Attach() and Reconnect() wait for an instrument to accept
+*   a connection before trying its next address or giving up
+*/
+void Socket_Instrument::SetConnectTimeout(unsigned long msec)
+{
+	connectTimeout_msec.store(msec);
+}
+
+
+/*******************************************************************************
+* Class      : Socket_Instrument
+* Function   : Connect()
+* Access     : private static
+* Arguments  : ptr          = resolved address to connect to
+*              timeout_msec = time allowed for the connection
+* Returns    : the connected socket, or INVALID_SOCKET on failure or timeout
+* Description:
+*   Connects without blocking for the operating system's connect timeout
+*   (~20 s when an instrument is powered off): the connection is started in
+*   non-blocking mode and waited for with select(). The socket is returned
+*   in blocking mode.
+*/
+SOCKET Socket_Instrument::Connect(struct addrinfo const* ptr, unsigned long timeout_msec)
+{
+	SOCKET sock = socket(ptr->ai_family, ptr->ai_socktype, ptr->ai_protocol);
+
+	if (sock == INVALID_SOCKET)
+		return INVALID_SOCKET;
+
+	bool bResult = false;
+	u_long nonblocking = 1;
+
+	if (ioctlsocket(sock, FIONBIO, &nonblocking) == 0)
+	{
+		if (connect(sock, ptr->ai_addr, int(ptr->ai_addrlen)) != SOCKET_ERROR)
+		{
+			bResult = true;
+		}
+		else if (WSAGetLastError() == WSAEWOULDBLOCK)
+		{
+			fd_set fdWrite, fdExcept;
+			FD_ZERO(&fdWrite);
+			FD_ZERO(&fdExcept);
+			FD_SET(sock, &fdWrite);
+			FD_SET(sock, &fdExcept);
+
+			timeval tv;
+			tv.tv_sec = long(timeout_msec / 1000);
+			tv.tv_usec = long((timeout_msec % 1000) * 1000);
+
+			// writable once connected, excepted if the connection was refused
+			if (select(0, nullptr, &fdWrite, &fdExcept, &tv) > 0 && FD_ISSET(sock, &fdWrite))
+			{
+				int error = 0;
+				int len = sizeof(error);
+				bResult = getsockopt(sock, SOL_SOCKET, SO_ERROR, (char*)&error, &len) == 0 && error == 0;
+			}
+		}
+	}
+
+	nonblocking = 0;
+	if (bResult && ioctlsocket(sock, FIONBIO, &nonblocking) != 0)
+		bResult = false;
+
+	if (!bResult)
+	{
+		closesocket(sock);
+		sock = INVALID_SOCKET;
+	}
+
+	return sock;
+}
+
+
 /*******************************************************************************
 * Class      : Socket_Instrument
 * Function   : Attach() using resource name
@@ -133,7 +221,8 @@ Socket_Instrument::~Socket_Instrument()
 * Arguments  : resource = resource name string for instrument (ex/ "192.168.0.197:5025")
 * Returns    : true if successful (instrument was attached), false if not
 * Description:
-*   Attaches to an instrument using the given resource name
+*   Attaches to an instrument using the given resource name. Each address the
+*   name resolves to is tried in turn, each for up to the connect timeout.
 */
 bool Socket_Instrument::Attach(string resource)
 {
@@ -152,17 +241,22 @@ bool Socket_Instrument::Attach(string resource)
 
 			if (getaddrinfo(addr.c_str(), port.c_str(), &hints, &result) == 0)
 			{
-				struct addrinfo* ptr = result;
-				connected_socket = socket(ptr->ai_family, ptr->ai_socktype, ptr->ai_protocol);
+				const unsigned long timeout_msec = connectTimeout_msec.load();
+
+				for (struct addrinfo* ptr = result; ptr != nullptr && connected_socket == INVALID_SOCKET; ptr = ptr->ai_next)
+					connected_socket = Socket_Instrument::Connect(ptr, timeout_msec);
 
 				if (connected_socket != INVALID_SOCKET)
-				{	// socket was created, connect to it
-					if (connect(connected_socket, ptr->ai_addr, int(ptr->ai_addrlen)) != SOCKET_ERROR)
-					{
-						bAttached = true;
-						Socket_Instrument::nInstrAttached += 1;
-						retval = true;
-					}
+				{
+					// bound the time a query may block so a silently dropped connection is detected
+					const DWORD dwTimeout = RECV_TIMEOUT_MSEC;
+					setsockopt(connected_socket, SOL_SOCKET, SO_RCVTIMEO, (char const*)&dwTimeout, sizeof(dwTimeout));
+
+					bAttached = true;
+					bConnectionLost = false;
+					strResource = resource;
+					Socket_Instrument::nInstrAttached += 1;
+					retval = true;
 				}
 
 				freeaddrinfo(result);
@@ -174,6 +268,40 @@ bool Socket_Instrument::Attach(string resource)
 }
 
 
+/*******************************************************************************
+* Class      : Socket_Instrument
+* Function   : Adopt()
+* Access     : public
+* Arguments  : connection = attached object whose connection is taken over
+* Returns    : true if the connection was taken over
+* Description:
+*   Attaches to the instrument connection made by another object, detaching
+*   from any instrument first. The other object is left detached, without
+*   closing the connection, and the number of attached instruments is
+*   unchanged. Open() of the instrument drivers identifies the model on a
+*   plain Socket_Instrument and hands its connection to the driver chosen, so
+*   the instrument is connected to only once.
+*/
+bool Socket_Instrument::Adopt(Socket_Instrument& connection)
+{
+	if (&connection == this || !connection.bAttached)
+		return false;
+
+	if (bAttached)
+		Detach();
+
+	connected_socket = connection.connected_socket;
+	strResource = connection.strResource;
+	bConnectionLost = connection.bConnectionLost;
+	bAttached = true;
+
+	connection.connected_socket = INVALID_SOCKET;
+	connection.bAttached = false;
+	connection.bConnectionLost = false;
+
+	return true;
+}
+
 
 /*******************************************************************************
 * Class      : Socket_Instrument
@@ -192,8 +320,10 @@ bool Socket_Instrument::Detach()
 	{
 		shutdown(connected_socket, SD_SEND);
 		closesocket(connected_socket);
+		connected_socket = INVALID_SOCKET;
 
 		bAttached = false;
+		bConnectionLost = false;
 		Socket_Instrument::nInstrAttached -= 1;
 	}
 
@@ -201,6 +331,58 @@ bool Socket_Instrument::Detach()
 }
 
 
+/*******************************************************************************
+* Class      : Socket_Instrument
+* Function   : IsConnected()
+* Access     : public
+* Arguments  : none
+* Returns    : true if attached and no communication failure has been detected
+* Description:
+*   Reports the health of the connection. A failed send, a connection closed by
+*   the instrument, or a query that times out marks the connection as lost.
+*/
+bool Socket_Instrument::IsConnected() const
+{
+	return bAttached && !bConnectionLost;
+}
+
+
+/*******************************************************************************
+* Class      : Socket_Instrument
+* Function   : Reconnect()
+* Access     : public
+* Arguments  : none
+* Returns    : true if the connection was re-established, false if not
+* Description:
+*   Re-attaches to the resource last passed to Attach(). The first attempt is
+*   made immediately, then up to RECONNECT_ATTEMPTS-1 more attempts are made
+*   with a doubling delay between them. Only the connection is restored; any
+*   instrument state must be restored by the caller or by the derived class.
+*/
+bool Socket_Instrument::Reconnect()
+{
+	bool retval = false;
+	const string resource = strResource;
+	DWORD dwBackoff = RECONNECT_BACKOFF_MSEC;
+
+	if (resource.empty())
+		return false;
+
+	for (int i = 0; i < RECONNECT_ATTEMPTS && !retval; ++i)
+	{
+		if (i > 0)
+		{
+			Sleep(dwBackoff);
+			dwBackoff = (2 * dwBackoff < RECONNECT_BACKOFF_MAX_MSEC) ? 2 * dwBackoff : RECONNECT_BACKOFF_MAX_MSEC;
+		}
+
+		retval = Socket_Instrument::Attach(resource);
+	}
+
+	return retval;
+}
+
+
 /*******************************************************************************
 * Class      : Socket_Instrument
 * Function   : Write()
@@ -212,13 +394,73 @@ bool Socket_Instrument::Detach()
 */
 bool Socket_Instrument::Write(std::string command)
 {
-	bool retval = false;
-
 	if (!EndsWithNewline(command))
 		command = command + '\n';
 
-	if (send(connected_socket, command.c_str(), (int)command.length(), 0) != SOCKET_ERROR)
+	return Send(command.c_str(), command.length());
+}
+
+
+/*******************************************************************************
+* Class      : Socket_Instrument
+* Function   : Write() using a fixed command
+* Access     : public
+* Arguments  : command = null terminated command to write to the instrument
+* Returns    : returns true if the write was successful
+* Description:
+*   Writes a fixed command (such as a literal) to the instrument without
+*   allocating. Appends \n if necessary.
+*/
+bool Socket_Instrument::Write(char const* command)
+{
+	ScpiCommand fixed;
+
+	return Write(fixed.Append(command));
+}
+
+
+/*******************************************************************************
+* Class      : Socket_Instrument
+* Function   : Write() using a ScpiCommand
+* Access     : public
+* Arguments  : command = formatted command to write to the instrument
+* Returns    : returns true if the write was successful
+* Description:
+*   Writes a command formatted by ScpiCommand from its own buffer. Appends \n
+*   to the command if necessary. A command that overflowed its buffer is not
+*   sent.
+*/
+bool Socket_Instrument::Write(ScpiCommand& command)
+{
+	if (command.Terminate().Overflow())
+		return false;
+
+	return Send(command.c_str(), command.size());
+}
+
+
+/*******************************************************************************
+* Class      : Socket_Instrument
+* Function   : Send()
+* Access     : private
+* Arguments  : pData   = data to write to the instrument
+*              nLength = number of bytes to write
+* Returns    : returns true if the write was successful
+* Description:
+*   Sends the data exactly as given. A failed send marks the connection as
+*   lost.
+*/
+bool Socket_Instrument::Send(char const* pData, size_t nLength)
+{
+	bool retval = false;
+
+	if (!bAttached)
+		return false;
+
+	if (send(connected_socket, pData, (int)nLength, 0) != SOCKET_ERROR)
 		retval = true;
+	else
+		bConnectionLost = true;
 
 	return retval;
 }
@@ -236,12 +478,7 @@ bool Socket_Instrument::Write(std::string command)
 */
 bool Socket_Instrument::WriteEx(std::string exact_command)
 {
-	bool retval = false;
-
-	if (send(connected_socket, exact_command.c_str(), (int)exact_command.length(), 0) != SOCKET_ERROR)
-		retval = true;
-
-	return retval;
+	return Send(exact_command.c_str(), exact_command.length());
 }
 
 
@@ -257,21 +494,210 @@ bool Socket_Instrument::WriteEx(std::string exact_command)
 *   Appends \n to the command if necessary.
 */
 bool Socket_Instrument::Query(std::string command, std::string& response)
+{
+	return Write(command) && Receive(response);
+}
+
+
+/*******************************************************************************
+* Class      : Socket_Instrument
+* Function   : Query() using a ScpiCommand
+* Access     : public
+* Arguments  : command  = formatted query to write to the instrument
+*              response = (reference) receives the response from the instrument
+* Returns    : returns true if the query was successful
+* Description:
+*   Writes a query formatted by ScpiCommand, and receives the response.
+*/
+bool Socket_Instrument::Query(ScpiCommand& command, std::string& response)
+{
+	return Write(command) && Receive(response);
+}
+
+
+/*******************************************************************************
+* Class      : Socket_Instrument
+* Function   : Receive()
+* Access     : private
+* Arguments  : response = (reference) receives the response from the instrument
+* Returns    : returns true if a response was received
+* Description:
+*   Receives the response to a query. A connection closed by the instrument,
+*   or no response within the receive timeout, marks the connection as lost.
+*/
+bool Socket_Instrument::Receive(std::string& response)
 {
 	bool retval = false;
 	char recv_buffer[RECV_BUFLEN];
 
-	if (Write(command))
+	int bytes_received = recv(connected_socket, recv_buffer, RECV_BUFLEN, 0);
+	if (bytes_received > 0)
+	{
+		response.assign(recv_buffer, bytes_received);
+		retval = true;
+	}
+	else
+	{	// 0 = closed by the instrument, SOCKET_ERROR = failure or timeout
+		bConnectionLost = true;
+	}
+
+	return retval;
+}
+
+
+/*******************************************************************************
+* Class      : Socket_Instrument
+* Function   : QueryBatch()
+* Access     : public
+* Arguments  : commands  = queries (and commands) to write to the instrument
+*              responses = (reference) receives one response line per query
+* Returns    : returns true if every query was answered
+* Description:
+*   Pipelines a batch of queries: all of them are written in a single send,
+*   and the responses are then split at the newlines as they arrive, so the
+*   batch costs about one round trip instead of one per query. Appends \n to
+*   each command if necessary. Each response keeps its terminating \n, as with
+*   Query(). Commands without a ? (no response) may be mixed in, for example
+*   to select what the queries that follow them read.
+*
+*   A query the instrument does not answer ends the batch at the receive
+*   timeout and marks the connection as lost, as Receive() does: a late
+*   answer would otherwise be read as the response to the next query.
+*/
+bool Socket_Instrument::QueryBatch(std::vector<std::string> const& commands, std::vector<std::string>& responses)
+{
+	string strBatch;
+	string strPending;
+	char recv_buffer[RECV_BUFLEN];
+
+	size_t nQueries = 0;
+
+	responses.clear();
+	if (commands.empty())
+		return true;
+
+	for (auto const& command : commands)
+	{
+		strBatch += command;
+		if (!EndsWithNewline(command))
+			strBatch += '\n';
+		if (command.find('?') != string::npos)
+			++nQueries;
+	}
+
+	if (!WriteEx(strBatch))
+		return false;
+
+	while (responses.size() < nQueries)
 	{
+		const size_t pos = strPending.find('\n');
+		if (pos != string::npos)
+		{
+			responses.push_back(strPending.substr(0, pos + 1));
+			strPending.erase(0, pos + 1);
+			continue;
+		}
+
 		int bytes_received = recv(connected_socket, recv_buffer, RECV_BUFLEN, 0);
 		if (bytes_received > 0)
 		{
-			response = std::string(recv_buffer, bytes_received);
-			retval = true;
+			strPending.append(recv_buffer, bytes_received);
+		}
+		else
+		{	// 0 = closed by the instrument, SOCKET_ERROR = failure or timeout
+			bConnectionLost = true;
+			return false;
 		}
 	}
 
-	return retval;
+	return true;
+}
+
+/*******************************************************************************
+* Class      : Socket_Instrument
+* Function   : QueryBlock()
+* Access     : public
+* Arguments  : command     = query to write to the instrument
+*              block       = (reference) receives the data of the block
+*              nTerminator = bytes the instrument sends after the block (ex/ the
+*                            SDS1000X-E ends a waveform with two LF)
+* Returns    : returns true if the whole block was received
+* Description:
+*   Reads a response holding an IEEE 488.2 definite length block
+*   (#<n><length><data>), such as a waveform. Anything before the # (a command
+*   header) is skipped, and the data is received in as many pieces as it takes,
+*   so the block may be longer than a single receive. The terminator is read
+*   too, however it is split between receives, so that no part of it is taken
+*   as the response to the next query.
+*/
+bool Socket_Instrument::QueryBlock(std::string command, std::string& block, size_t nTerminator)
+{
+	string strPending;
+	char recv_buffer[RECV_BUFLEN];
+	size_t start = string::npos;
+	size_t length = 0;
+
+	block.clear();
+
+	if (!Write(command))
+		return false;
+
+	for (;;)
+	{
+		// header: # then one digit n, then n digits of length
+		if (start == string::npos)
+		{
+			const size_t pos = strPending.find('#');
+			if (pos != string::npos && strPending.length() > pos + 1)
+			{
+				const int nDigits = strPending[pos + 1] - '0';
+				if (nDigits < 1 || nDigits > 9)
+					return false;   // indefinite length blocks are not supported
+				if (strPending.length() >= pos + 2 + nDigits)
+				{
+					length = stoul(strPending.substr(pos + 2, nDigits));
+					start = pos + 2 + nDigits;
+				}
+			}
+		}
+
+		if (start != string::npos && strPending.length() >= start + length)
+		{
+			block.assign(strPending, start, length);
+			break;
+		}
+
+		int bytes_received = recv(connected_socket, recv_buffer, RECV_BUFLEN, 0);
+		if (bytes_received > 0)
+		{
+			strPending.append(recv_buffer, bytes_received);
+		}
+		else
+		{	// 0 = closed by the instrument, SOCKET_ERROR = failure or timeout
+			bConnectionLost = true;
+			return false;
+		}
+	}
+
+	// read the rest of the terminator (some of it may have arrived with the block)
+	size_t nReceived = strPending.length() - (start + length);
+
+	while (nReceived < nTerminator)
+	{
+		int bytes_received = recv(connected_socket, recv_buffer, RECV_BUFLEN, 0);
+		if (bytes_received > 0)
+		{
+			nReceived += bytes_received;
+		}
+		else
+		{	// the block itself is complete, but a late terminator would be read as
+			// the response to the next query
+			bConnectionLost = true;
+			break;
+		}
+	}
+
+	return true;
 }
 
 
@@ -9,13 +9,15 @@
 *   instrument over a LAN using Winsock
 *
 * Created    : 11/05/2021
-* Modified   : 01/02/2023
+* Modified   : 10/16/2026
 * Author     : Kerry S. Martin, martin@wild-wood.net
 *******************************************************************************/
 #pragma once
+#include <atomic>
 #include <string>
 #include <vector>
 #include <regex>
+#include "ScpiCommand.h"
 #include <winsock2.h>
 #include <ws2tcpip.h>
 
@@ -30,7 +32,9 @@ private:
 	// data type definition
 	struct addrinfo hints;
 	bool bAttached;
+	bool bConnectionLost;
 	SOCKET connected_socket;
+	std::string strResource;
 
 public:
 	// Construction and destruction
@@ -47,25 +51,52 @@ public:
 	virtual bool Attach(std::string resource);
 	virtual bool Detach();
 
+	// time allowed for a connection to each address of a resource (applies to all instruments)
+	// Attach() is safe to call concurrently on different instruments
+	static void SetConnectTimeout(unsigned long msec);
+
+	// takes over the connection of another object (left detached), so a driver for
+	// the model can be chosen from a query made on the connection it will use
+	bool Adopt(Socket_Instrument& connection);
+
+	// connection health and recovery
+	// a failed send, a closed connection, or a receive timeout marks the connection as lost
+	// Reconnect() re-attaches to the last resource with a bounded number of attempts and backoff
+	bool IsConnected() const;
+	virtual bool Reconnect();
+
 	// these are to be hidden/protected in any derived class
 	// command will be appended with a newline character if it is not already present
 	// exact_command will be written exactly as passed, with no added newline
+	// a ScpiCommand is sent from its own buffer (an overflowed command is not sent)
 	bool Write(std::string command);
+	bool Write(char const* command);
+	bool Write(ScpiCommand& command);
 	bool WriteEx(std::string exact_command);
 	bool Query(std::string command, std::string& response);
+	bool Query(ScpiCommand& command, std::string& response);
+	bool QueryBatch(std::vector<std::string> const& commands, std::vector<std::string>& responses);
+	bool QueryBlock(std::string command, std::string& block, size_t nTerminator = 1);
 
 protected:
+	// command buffer for the derived instrument drivers
+	ScpiCommand cmd;
+
 	//static bool FindInstrument(std::regex pattern, std::string& ident, std::string& resource);
 	static bool EndsWithNewline(std::string const input);
 	static bool Extract_Addr_Port(std::string const resource, std::string& addr, std::string& port);
 
 private:
 	static bool bSocketsInitialized;
-	static int nInstrAttached;
+	static std::atomic<int> nInstrAttached;
+	static std::atomic<unsigned long> connectTimeout_msec;
 	static WSADATA wsaData;
 
 	static bool InitSockets();
 	static bool CleanupSockets();
+	static SOCKET Connect(struct addrinfo const* ptr, unsigned long timeout_msec);
+	bool Send(char const* pData, size_t nLength);
+	bool Receive(std::string& response);
 };
 
 
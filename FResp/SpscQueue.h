@@ -0,0 +1,81 @@
+/*******************************************************************************
+* Copyright  2026 Kerry S. Martin, martin@wild-wood.net
+* Free for usage without warranty, expressed or implied; attribution required
+*
+* Filename   : SpscQueue.h
+* Class      : SpscQueue
+* Description:
+*   SpscQueue is a fixed-capacity, lock-free ring buffer for exactly one
+*   producer thread and one consumer thread. The slots are preallocated and
+*   are filled and read in place: the producer obtains a free slot with
+*   Reserve(), fills it, and publishes it with Commit(); the consumer obtains
+*   the oldest published slot with Peek() and returns it with Release().
+*
+*   No call blocks or allocates. Reserve() returns nullptr when the queue is
+*   full and Peek() returns nullptr when it is empty.
+*
+* Created    : 10/16/2026
+* Modified   : 10/16/2026
+* Author     : Kerry S. Martin, martin@wild-wood.net
+*******************************************************************************/
+#pragma once
+#include <atomic>
+#include <cstddef>
+
+template<class T, size_t N>
+class SpscQueue
+{
+	static_assert(N >= 2 && (N & (N - 1)) == 0, "SpscQueue capacity must be a power of two");
+
+public:
+	SpscQueue() : head(0), tail(0) {}
+	SpscQueue(SpscQueue const&) = delete;
+	SpscQueue& operator = (SpscQueue const&) = delete;
+
+	// producer: next free slot, or nullptr if the queue is full
+	T* Reserve()
+	{
+		const size_t t = tail.load(std::memory_order_relaxed);
+		if (t - head.load(std::memory_order_acquire) >= N)
+			return nullptr;
+		return &slots[t & (N - 1)];
+	}
+
+	// producer: publish the slot returned by Reserve()
+	void Commit()
+	{
+		tail.store(tail.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+	}
+
+	// consumer: oldest published slot, or nullptr if the queue is empty
+	T* Peek()
+	{
+		const size_t h = head.load(std::memory_order_relaxed);
+		if (h == tail.load(std::memory_order_acquire))
+			return nullptr;
+		return &slots[h & (N - 1)];
+	}
+
+	// consumer: return the slot returned by Peek() to the producer
+	void Release()
+	{
+		head.store(head.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+	}
+
+	bool Empty() const
+	{
+		return head.load(std::memory_order_acquire) == tail.load(std::memory_order_acquire);
+	}
+
+private:
+	// head and tail on separate cache lines so the two threads do not contend
+	alignas(64) std::atomic<size_t> head;
+	alignas(64) std::atomic<size_t> tail;
+	alignas(64) T slots[N];
+};
+
+
+/*******************************************************************************
+* Copyright  2026 Kerry S. Martin, martin@wild-wood.net
+* Free for usage without warranty, expressed or implied; attribution required
+*******************************************************************************/
\ No newline at end of file
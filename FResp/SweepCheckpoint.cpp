@@ -0,0 +1,406 @@
+/*******************************************************************************
+* Copyright  2026 Kerry S. Martin, martin@wild-wood.net
+* Free for usage without warranty, expressed or implied; attribution required
+*
+* Filename   : SweepCheckpoint.cpp
+* Class      : SweepCheckpoint
+* Description:
+*   SweepCheckpoint writes the progress of a frequency response sweep to an
+*   append-only text file so an interrupted sweep can be resumed.
+*
+*   File format (one record per line, fields separated by spaces):
+*     FRESP_CHECKPOINT version
+*     FREQ   fStart fStop sweep Npoints
+*     STIM   ch vtStim vstim vdc vlevel vmax
+*     INPUT  ch coup atten bwl
+*     OUTPUT ch coup atten bwl
+*     TRIG   ch edge coup vTrig
+*     MEAS   vtMeas ttMeas nAvgMax tolGain_dB tolPhase_deg is_harmonics
+*     DWELL  stable_screens minDwell_msec
+*     POINT  freq mag_in mag_out dBgain time tunit fNext sd_dBgain sd_time count vstim
+*            fund h2 h3 h4 h5 thd thdn *
+*            (one per point)
+*   Enumerations are written as their integer values. The trailing * marks a
+*   point record as completely written. Version 1 files, without the averaging
+*   fields, version 2 files, without the leveling fields, and version 3 files,
+*   without the harmonic fields, are still read.
+*
+* Created    : 10/16/2026
+* Modified   : 10/16/2026
+* Author     : Kerry S. Martin, martin@wild-wood.net
+*******************************************************************************/
+
+#include "SweepCheckpoint.h"
+#include <sstream>
+#include <iomanip>
+#include <iterator>
+#include <limits>
+#include <cstdlib>
+
+using namespace std;
+
+const char* const SweepCheckpoint::FILE_ID{ "FRESP_CHECKPOINT" };
+const int SweepCheckpoint::FILE_VERSION{ 4 };
+
+// number of significant digits needed to read back a double exactly
+constexpr auto CHECKPOINT_PRECISION = numeric_limits<double>::max_digits10;
+
+
+/*******************************************************************************
+* Function   : operator >> (istream, CheckpointValue)
+* Arguments  : is    = stream to read from
+*              value = receives the value
+* Returns    : the stream
+* Description:
+*   Reads one double field. Unlike the standard extractor, this accepts the
+*   nan and inf text written for failed measurements.
+*/
+struct CheckpointValue { double& value; };
+
+static istream& operator >> (istream& is, CheckpointValue cv)
+{
+	string strToken;
+
+	if (is >> strToken)
+	{
+		char* pEnd = nullptr;
+		cv.value = strtod(strToken.c_str(), &pEnd);
+		if (pEnd == strToken.c_str() || *pEnd != 0)
+			is.setstate(ios::failbit);
+	}
+
+	return is;
+}
+
+
+/*******************************************************************************
+* Class      : SweepCheckpoint
+* Function   : SweepCheckpoint() constructor
+* Access     : public
+* Arguments  : none
+* Returns    : none
+* Description:
+*   Constructs a SweepCheckpoint object with no file open
+*/
+SweepCheckpoint::SweepCheckpoint()
+{
+}
+
+
+/*******************************************************************************
+* Class      : SweepCheckpoint
+* Function   : ~SweepCheckpoint() destructor
+* Access     : public
+* Arguments  : none
+* Returns    : none
+* Description:
+*   Destroys a SweepCheckpoint object, closing the file if it is open
+*/
+SweepCheckpoint::~SweepCheckpoint()
+{
+	Close();
+}
+
+
+/*******************************************************************************
+* Class      : SweepCheckpoint
+* Function   : Create()
+* Access     : public
+* Arguments  : filename = checkpoint file to create (an existing file is replaced)
+*              freq, stim, input, output, trig, meas, dwell = sweep configuration
+* Returns    : true if the file was created and the configuration written
+* Description:
+*   Starts a new checkpoint file and writes the sweep configuration to it.
+*/
+bool SweepCheckpoint::Create(std::string filename, Freq_Config const& freq, Stim_Config const& stim, Channel_Config const& input, Channel_Config const& output, Trig_Config const& trig, Meas_Config const& meas, Dwell_Config const& dwell)
+{
+	Close();
+
+	file.open(filename, ios::out | ios::trunc);
+	if (!file.is_open())
+		return false;
+
+	file << setprecision(CHECKPOINT_PRECISION);
+	file << FILE_ID << " " << FILE_VERSION << "\n";
+	file << "FREQ " << freq.fStart << " " << freq.fStop << " " << int(freq.sweep) << " " << freq.Npoints << "\n";
+	file << "STIM " << stim.ch << " " << int(stim.vtStim) << " " << stim.vstim << " " << stim.vdc << " " << stim.vlevel << " " << stim.vmax << "\n";
+	file << "INPUT " << input.ch << " " << int(input.coup) << " " << input.atten << " " << int(input.bwl) << "\n";
+	file << "OUTPUT " << output.ch << " " << int(output.coup) << " " << output.atten << " " << int(output.bwl) << "\n";
+	file << "TRIG " << trig.ch << " " << int(trig.edge) << " " << int(trig.coup) << " " << trig.vTrig << "\n";
+	file << "MEAS " << int(meas.vtMeas) << " " << int(meas.ttMeas) << " " << meas.nAvgMax << " " << meas.tolGain_dB << " " << meas.tolPhase_deg << " " << int(meas.is_harmonics) << "\n";
+	file << "DWELL " << dwell.stable_screens << " " << dwell.minDwell_msec << "\n";
+	file.flush();
+
+	return file.good();
+}
+
+
+/*******************************************************************************
+* Class      : SweepCheckpoint
+* Function   : Append()
+* Access     : public
+* Arguments  : filename = existing checkpoint file
+* Returns    : true if the file was opened for append
+* Description:
+*   Opens an existing checkpoint file so that a resumed sweep continues to
+*   record its progress in the same file. A record left partly written when
+*   the sweep was interrupted is removed first, so that the next point does
+*   not run on from it.
+*/
+bool SweepCheckpoint::Append(std::string filename)
+{
+	Close();
+
+	// truncate the file to its last complete line
+	{
+		ifstream infile(filename, ios::in | ios::binary);
+		if (!infile.is_open())
+			return false;
+
+		const string strContents((istreambuf_iterator<char>(infile)), istreambuf_iterator<char>());
+		infile.close();
+
+		if (!strContents.empty() && strContents.back() != '\n')
+		{
+			const size_t end = strContents.find_last_of('\n');
+			if (end == string::npos)
+				return false;	// not even the identification line is complete
+
+			ofstream outfile(filename, ios::out | ios::binary | ios::trunc);
+			outfile.write(strContents.data(), end + 1);
+			if (!outfile.good())
+				return false;
+		}
+	}
+
+	file.open(filename, ios::out | ios::app);
+	if (!file.is_open())
+		return false;
+
+	file << setprecision(CHECKPOINT_PRECISION);
+
+	return file.good();
+}
+
+
+/*******************************************************************************
+* Class      : SweepCheckpoint
+* Function   : WritePoint()
+* Access     : public
+* Arguments  : point = completed frequency point
+*              fNext = next frequency to be measured
+* Returns    : true if the point was written
+* Description:
+*   Appends one completed point and flushes it to the file.
+*/
+bool SweepCheckpoint::WritePoint(FRS const& point, double fNext)
+{
+	if (!file.is_open())
+		return false;
+
+	file << "POINT " << point.freq << " " << point.mag_in << " " << point.mag_out << " " << point.dBgain << " " << point.time << " " << int(point.tunit) << " " << fNext << " " << point.sd_dBgain << " " << point.sd_time << " " << point.count << " " << point.vstim
+		<< " " << point.fund << " " << point.h2 << " " << point.h3 << " " << point.h4 << " " << point.h5 << " " << point.thd << " " << point.thdn << " *\n";
+	file.flush();
+
+	return file.good();
+}
+
+
+/*******************************************************************************
+* Class      : SweepCheckpoint
+* Function   : IsOpen()
+* Access     : public
+* Arguments  : none
+* Returns    : true if a checkpoint file is open
+* Description:
+*   Reports whether points are being recorded to a checkpoint file
+*/
+bool SweepCheckpoint::IsOpen() const
+{
+	return file.is_open();
+}
+
+
+/*******************************************************************************
+* Class      : SweepCheckpoint
+* Function   : Close()
+* Access     : public
+* Arguments  : none
+* Returns    : none
+* Description:
+*   Closes the checkpoint file if it is open
+*/
+void SweepCheckpoint::Close()
+{
+	if (file.is_open())
+		file.close();
+	file.clear();
+}
+
+
+/*******************************************************************************
+* Class      : SweepCheckpoint
+* Function   : Load()
+* Access     : public static
+* Arguments  : filename = checkpoint file to read
+*              freq, stim, input, output, trig, meas, dwell = receive the sweep configuration
+*              data     = receives the completed points
+*              fNext    = receives the next frequency to be measured
+* Returns    : true if the file contained a complete configuration
+* Description:
+*   Reads back a checkpoint file. Reading stops at the first line that cannot
+*   be parsed, which discards a point that was only partially written.
+*   If no points were completed, fNext is set to the start frequency.
+*/
+bool SweepCheckpoint::Load(std::string filename, Freq_Config& freq, Stim_Config& stim, Channel_Config& input, Channel_Config& output, Trig_Config& trig, Meas_Config& meas, Dwell_Config& dwell, FRST& data, double& fNext)
+{
+	ifstream infile(filename);
+	string strLine;
+	int nConfig = 0;   // number of configuration records read (7 expected)
+	int version = 0;
+
+	data = FRST();
+
+	if (!infile.is_open())
+		return false;
+
+	// identification line
+	if (getline(infile, strLine))
+	{
+		istringstream iss(strLine);
+		string strId;
+		if (!(iss >> strId >> version) || strId != FILE_ID || version > FILE_VERSION)
+			return false;
+	}
+	else
+	{
+		return false;
+	}
+
+	while (getline(infile, strLine))
+	{
+		istringstream iss(strLine);
+		string strRecord;
+		int e1 = 0, e2 = 0, e3 = 0;
+		bool bParsed = false;
+
+		if (!(iss >> strRecord))
+			break;
+
+		if (strRecord == "FREQ")
+		{
+			bParsed = bool(iss >> freq.fStart >> freq.fStop >> e1 >> freq.Npoints);
+			freq.sweep = Sweep_t(e1);
+		}
+		else if (strRecord == "STIM")
+		{
+			bParsed = bool(iss >> stim.ch >> e1 >> stim.vstim >> stim.vdc);
+			stim.vtStim = Vtype_t(e1);
+
+			// leveling settings (version 3), no leveling if absent
+			if (!(iss >> CheckpointValue{ stim.vlevel } >> CheckpointValue{ stim.vmax }))
+			{
+				stim.vlevel = numeric_limits<double>::quiet_NaN();
+				stim.vmax = numeric_limits<double>::quiet_NaN();
+			}
+		}
+		else if (strRecord == "INPUT" || strRecord == "OUTPUT")
+		{
+			Channel_Config& chan = (strRecord == "INPUT") ? input : output;
+			bParsed = bool(iss >> chan.ch >> e1 >> chan.atten >> e2);
+			chan.coup = Ctype_t(e1);
+			chan.bwl = (e2 != 0);
+		}
+		else if (strRecord == "TRIG")
+		{
+			bParsed = bool(iss >> trig.ch >> e1 >> e2 >> trig.vTrig);
+			trig.edge = Etype_t(e1);
+			trig.coup = Ctype_t(e2);
+		}
+		else if (strRecord == "MEAS")
+		{
+			bParsed = bool(iss >> e1 >> e2);
+			meas.vtMeas = Vtype_t(e1);
+			meas.ttMeas = Ttype_t(e2);
+			meas.is_hwsweep = false;	// a resumed sweep continues point by point
+			meas.search = SEARCH_NONE;
+			meas.is_harmonics = false;
+			meas.fit = { 0, 0, 0.0 };	// a model is not fitted to a resumed sweep
+
+			// averaging settings (version 2), a single reading if absent
+			if (!(iss >> meas.nAvgMax >> meas.tolGain_dB >> meas.tolPhase_deg))
+				meas.nAvgMax = 1;
+			else if (iss >> e3)	// harmonic analysis (version 4)
+				meas.is_harmonics = (e3 != 0);
+		}
+		else if (strRecord == "DWELL")
+		{
+			bParsed = bool(iss >> dwell.stable_screens >> dwell.minDwell_msec);
+		}
+		else if (strRecord == "POINT")
+		{
+			FRS point;
+			double f;
+			string strEnd;
+
+			point.sd_dBgain = 0.0;
+			point.sd_time = 0.0;
+			point.count = 1;
+			point.vstim = numeric_limits<double>::quiet_NaN();
+			point.is_harmonics = meas.is_harmonics;
+			point.fund = point.h2 = point.h3 = point.h4 = point.h5 = point.thd = point.thdn = numeric_limits<double>::quiet_NaN();
+
+			if (iss >> CheckpointValue{ point.freq } >> CheckpointValue{ point.mag_in } >> CheckpointValue{ point.mag_out } >> CheckpointValue{ point.dBgain } >> CheckpointValue{ point.time } >> e3 >> CheckpointValue{ f } >> strEnd)
+			{	// a version 1 point ends here; a version 2 point has the averaging fields
+				// first (a resumed version 1 file can hold points of both versions)
+				if (strEnd != "*")
+				{
+					istringstream issEnd(strEnd);
+					if (!(issEnd >> CheckpointValue{ point.sd_dBgain } && iss >> CheckpointValue{ point.sd_time } >> point.count >> strEnd))
+						strEnd.clear();
+				}
+
+				// a version 3 point has the stimulus amplitude last
+				if (!strEnd.empty() && strEnd != "*")
+				{
+					istringstream issEnd(strEnd);
+					if (!(issEnd >> CheckpointValue{ point.vstim } && iss >> strEnd))
+						strEnd.clear();
+				}
+
+				// a version 4 point has the harmonic analysis last
+				if (!strEnd.empty() && strEnd != "*")
+				{
+					istringstream issEnd(strEnd);
+					if (!(issEnd >> CheckpointValue{ point.fund } && iss >> CheckpointValue{ point.h2 } >> CheckpointValue{ point.h3 } >> CheckpointValue{ point.h4 }
+						>> CheckpointValue{ point.h5 } >> CheckpointValue{ point.thd } >> CheckpointValue{ point.thdn } >> strEnd))
+						strEnd.clear();
+				}
+			}
+
+			if (strEnd == "*")
+			{
+				point.tunit = TUNIT(e3);
+				data.push_back(point);
+				fNext = f;
+				continue;
+			}
+		}
+
+		if (!bParsed)
+			break;   // incomplete or unknown record
+
+		nConfig = nConfig + 1;
+	}
+
+	if (data.empty())
+		fNext = freq.fStart;
+
+	return nConfig == 7;
+}
+
+
+/*******************************************************************************
+* Copyright  2026 Kerry S. Martin, martin@wild-wood.net
+* Free for usage without warranty, expressed or implied; attribution required
+*******************************************************************************/
\ No newline at end of file
@@ -0,0 +1,55 @@
+/*******************************************************************************
+* Copyright  2026 Kerry S. Martin, martin@wild-wood.net
+* Free for usage without warranty, expressed or implied; attribution required
+*
+* Filename   : SweepCheckpoint.h
+* Class      : SweepCheckpoint
+* Description:
+*   SweepCheckpoint writes the progress of a frequency response sweep to an
+*   append-only text file: the sweep configuration once, followed by one line
+*   for each completed frequency point. Every line is flushed as it is written,
+*   so a sweep interrupted by a crash or power loss can be resumed from the
+*   last completed point.
+*
+*   Values are written with enough significant digits to be read back exactly.
+*   An incomplete last line (interrupted write) is ignored by Load().
+*
+* Created    : 10/16/2026
+* Modified   : 10/16/2026
+* Author     : Kerry S. Martin, martin@wild-wood.net
+*******************************************************************************/
+#pragma once
+#include "FreqResp.h"
+#include <fstream>
+#include <string>
+
+class SweepCheckpoint
+{
+public:
+	SweepCheckpoint();
+	~SweepCheckpoint();
+	SweepCheckpoint(SweepCheckpoint const&) = delete;
+	SweepCheckpoint& operator = (SweepCheckpoint const&) = delete;
+
+	// start a new checkpoint file, or continue appending to an existing one
+	bool Create(std::string filename, Freq_Config const& freq, Stim_Config const& stim, Channel_Config const& input, Channel_Config const& output, Trig_Config const& trig, Meas_Config const& meas, Dwell_Config const& dwell);
+	bool Append(std::string filename);
+	bool WritePoint(FRS const& point, double fNext);
+	bool IsOpen() const;
+	void Close();
+
+	// read back the configuration and completed points of a checkpoint file
+	static bool Load(std::string filename, Freq_Config& freq, Stim_Config& stim, Channel_Config& input, Channel_Config& output, Trig_Config& trig, Meas_Config& meas, Dwell_Config& dwell, FRST& data, double& fNext);
+
+private:
+	std::ofstream file;
+
+	static const char* const FILE_ID;
+	static const int FILE_VERSION;
+};
+
+
+/*******************************************************************************
+* Copyright  2026 Kerry S. Martin, martin@wild-wood.net
+* Free for usage without warranty, expressed or implied; attribution required
+*******************************************************************************/
\ No newline at end of file
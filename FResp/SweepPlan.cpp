@@ -0,0 +1,320 @@
+/*******************************************************************************
+* Copyright  2026 Kerry S. Martin, martin@wild-wood.net
+* Free for usage without warranty, expressed or implied; attribution required
+*
+* Filename   : SweepPlan.cpp
+* Class      : SweepPlan
+* Description:
+*   SweepPlan is the precomputed table of steps for a frequency response
+*   sweep.
+*
+* Created    : 10/16/2026
+* Modified   : 10/16/2026
+* Author     : Kerry S. Martin, martin@wild-wood.net
+*******************************************************************************/
+
+#include "SweepPlan.h"
+#include <cmath>
+
+using namespace std;
+
+// a frequency within this factor of fStop is still part of the sweep
+const double SweepPlan::FREQ_FUDGE{ 1.001 };
+
+// number of stimulus cycles in one oscilloscope capture, for each capture level
+const double SweepPlan::CAPTURE_CYCLES[SWEEP_CAPTURE_LEVELS]{ 1.0, 2.0, 4.0, 8.0, 16.0 };
+
+// capture level used until the signal has been measured (4 cycles)
+const size_t SweepPlan::CAPTURE_DEFAULT{ 2 };
+
+// samples per stimulus cycle wanted for the amplitude and phase measurements
+const double SweepPlan::SAMPLES_PER_CYCLE{ 5000.0 };
+
+// typical time per point for the measurement queries (used only for estimates)
+const double SweepPlan::EST_OVERHEAD_SEC{ 0.25 };
+
+
+/*******************************************************************************
+* Class      : SweepPlan
+* Function   : SweepPlan() constructor
+* Access     : public
+* Arguments  : none
+* Returns    : none
+* Description:
+*   Constructs an empty plan. Use Build() to compute the steps.
+*/
+SweepPlan::SweepPlan() : freq(), dwell()
+{
+}
+
+
+/*******************************************************************************
+* Class      : SweepPlan
+* Function   : Build()
+* Access     : public
+* Arguments  : freq      = config of frequency sweep
+*              dwell     = config of algorithm dwell time at each frequency
+*              scope     = oscilloscope driver (its timebases and memory depths)
+*              gen       = generator driver (its frequency command)
+*              sgChannel = generator channel receiving the frequency commands
+* Returns    : true if the plan has at least one step
+* Description:
+*   Computes every step of the sweep: the frequencies from fStart up to (and
+*   within FREQ_FUDGE of) fStop, and for each capture level the timebase
+*   capturing CAPTURE_CYCLES cycles, the memory depth, and the dwell time.
+*   The oscilloscope commands are composed by ScopeDriver::SetCapture(),
+*   which sends only the settings that change from one point to the next.
+*   The dwell scales with the capture, so a shorter capture settles sooner.
+*/
+bool SweepPlan::Build(Freq_Config const& _freq, Dwell_Config const& _dwell, ScopeDriver const& scope, GeneratorDriver const& gen, GeneratorDriver::Channel sgChannel)
+{
+	freq = _freq;
+	dwell = _dwell;
+	steps.clear();
+
+	if (isnan(freq.fStart) || isnan(freq.fStop) || freq.fStart <= 0.0)
+		return false;
+
+	for (size_t k = 0; ; ++k)
+	{
+		const double f = Frequency(k);
+
+		// the first point is always measured
+		if (k > 0 && !(f <= FREQ_FUDGE * freq.fStop && f > steps.back().freq))
+			break;
+
+		steps.push_back(Step(f, scope, gen, sgChannel));
+	}
+
+	return !steps.empty();
+}
+
+
+/*******************************************************************************
+* Class      : SweepPlan
+* Function   : Step()
+* Access     : public
+* Arguments  : f         = stimulus frequency (Hz)
+*              scope     = oscilloscope driver (its timebases and memory depths)
+*              gen       = generator driver (its frequency command)
+*              sgChannel = generator channel receiving the frequency command
+* Returns    : the step measuring f
+* Description:
+*   Computes one step with the dwell configuration of the plan. Build() uses
+*   it for each frequency of the sweep; a search (FreqResp::Search) uses it
+*   for the frequencies it chooses while measuring.
+*/
+SweepStep SweepPlan::Step(double f, ScopeDriver const& scope, GeneratorDriver const& gen, GeneratorDriver::Channel sgChannel) const
+{
+	SweepStep step;
+	step.freq = f;
+	step.strFreqCommand = gen.FormatChannelFreq(sgChannel, f);
+
+	for (size_t i = 0; i < SWEEP_CAPTURE_LEVELS; ++i)
+	{
+		SweepCapture& capture = step.capture[i];
+		capture.tcapture = scope.FindTimebase(CAPTURE_CYCLES[i] / f, capture.tdiv);
+		capture.dwell_msec = (unsigned long)(1000 * (dwell.stable_screens * capture.tcapture));
+		if (capture.dwell_msec < dwell.minDwell_msec)
+			capture.dwell_msec = dwell.minDwell_msec;
+		capture.mdepth = scope.FindMemoryDepth(capture.tcapture, SAMPLES_PER_CYCLE * f);
+	}
+
+	return step;
+}
+
+
+/*******************************************************************************
+* Class      : SweepPlan
+* Function   : Clear()
+* Access     : public
+* Arguments  : none
+* Returns    : none
+* Description:
+*   Removes all steps
+*/
+void SweepPlan::Clear()
+{
+	steps.clear();
+}
+
+
+/*******************************************************************************
+* Class      : SweepPlan
+* Function   : Size(), Empty(), operator [], begin(), end()
+* Access     : public
+* Description:
+*   Access to the steps of the plan
+*/
+size_t SweepPlan::Size() const
+{
+	return steps.size();
+}
+
+bool SweepPlan::Empty() const
+{
+	return steps.empty();
+}
+
+SweepStep const& SweepPlan::operator [] (size_t i) const
+{
+	return steps[i];
+}
+
+std::vector<SweepStep>::const_iterator SweepPlan::begin() const
+{
+	return steps.cbegin();
+}
+
+std::vector<SweepStep>::const_iterator SweepPlan::end() const
+{
+	return steps.cend();
+}
+
+
+/*******************************************************************************
+* Class      : SweepPlan
+* Function   : FreqConfig(), DwellConfig()
+* Access     : public
+* Description:
+*   The configuration the plan was built from
+*/
+Freq_Config const& SweepPlan::FreqConfig() const
+{
+	return freq;
+}
+
+Dwell_Config const& SweepPlan::DwellConfig() const
+{
+	return dwell;
+}
+
+
+/*******************************************************************************
+* Class      : SweepPlan
+* Function   : Frequency()
+* Access     : public
+* Arguments  : k = step index (may be past the last step)
+* Returns    : frequency of step k
+* Description:
+*   Computes the frequency of step k directly from the sweep configuration.
+*   A sweep with too few points to define a step has only the start frequency.
+*/
+double SweepPlan::Frequency(size_t k) const
+{
+	if (freq.sweep == Sweep_t::LOG && freq.Npoints > 0)
+		return freq.fStart * pow(10.0, double(k) / freq.Npoints);
+	else if (freq.sweep == Sweep_t::LIN && freq.Npoints > 1)
+		return freq.fStart + double(k) * (freq.fStop - freq.fStart) / (freq.Npoints - 1);
+	else
+		return (k == 0) ? freq.fStart : HUGE_VAL;
+}
+
+
+/*******************************************************************************
+* Class      : SweepPlan
+* Function   : FindStep()
+* Access     : public
+* Arguments  : f = frequency
+* Returns    : index of the step nearest to f, Size() if f lies past the last step
+* Description:
+*   Locates a frequency within the plan, for example the frequency to resume
+*   from that was recorded in a checkpoint.
+*/
+size_t SweepPlan::FindStep(double f) const
+{
+	size_t iBest = steps.size();
+	double dBest = fabs(Frequency(steps.size()) - f);
+
+	for (size_t i = 0; i < steps.size(); ++i)
+	{
+		const double d = fabs(steps[i].freq - f);
+		if (d < dBest)
+		{
+			dBest = d;
+			iBest = i;
+		}
+	}
+
+	return iBest;
+}
+
+
+/*******************************************************************************
+* Class      : SweepPlan
+* Function   : EstimateDuration()
+* Access     : public
+* Arguments  : none
+* Returns    : estimated sweep duration (seconds)
+* Description:
+*   Estimates the time to execute the plan: the dwell and one capture per
+*   step at the default capture length, plus a typical measurement overhead.
+*   Extra captures needed when the vertical scale is adjusted, and changes to
+*   the capture length while sweeping, are not included.
+*/
+double SweepPlan::EstimateDuration() const
+{
+	double t = 0.0;
+
+	for (auto const& step : steps)
+		t += step.capture[CAPTURE_DEFAULT].dwell_msec / 1000.0 + step.capture[CAPTURE_DEFAULT].tcapture + EST_OVERHEAD_SEC;
+
+	return t;
+}
+
+/*******************************************************************************
+* Class      : SweepPlan
+* Function   : CoarseToFine()
+* Access     : public
+* Arguments  : none
+* Returns    : the indexes of the steps, coarse to fine
+* Description:
+*   Orders the steps so that the points measured so far always span the
+*   whole sweep, at a spacing that halves as the sweep proceeds: both ends
+*   first, then the middle of each interval between the steps already
+*   ordered, breadth first. A model fitted while sweeping sees every part
+*   of the response early.
+*/
+std::vector<size_t> SweepPlan::CoarseToFine() const
+{
+	vector<size_t> order;
+	vector<pair<size_t, size_t>> intervals;
+
+	if (steps.empty())
+		return order;
+
+	order.push_back(0);
+	if (steps.size() > 1)
+	{
+		order.push_back(steps.size() - 1);
+		intervals.push_back({ 0, steps.size() - 1 });
+	}
+
+	// each pass splits every interval of the previous pass at its middle
+	while (!intervals.empty())
+	{
+		vector<pair<size_t, size_t>> halves;
+
+		for (auto const& interval : intervals)
+		{
+			if (interval.second - interval.first < 2)
+				continue;
+
+			const size_t middle = (interval.first + interval.second) / 2;
+			order.push_back(middle);
+			halves.push_back({ interval.first, middle });
+			halves.push_back({ middle, interval.second });
+		}
+
+		intervals.swap(halves);
+	}
+
+	return order;
+}
+
+
+
+/*******************************************************************************
+* Copyright  2026 Kerry S. Martin, martin@wild-wood.net
+* Free for usage without warranty, expressed or implied; attribution required
+*******************************************************************************/
\ No newline at end of file
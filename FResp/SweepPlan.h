@@ -0,0 +1,91 @@
+/*******************************************************************************
+* Copyright  2026 Kerry S. Martin, martin@wild-wood.net
+* Free for usage without warranty, expressed or implied; attribution required
+*
+* Filename   : SweepPlan.h
+* Class      : SweepPlan
+* Description:
+*   SweepPlan is the precomputed table of steps for a frequency response
+*   sweep. Each step holds its exact frequency, the generator command
+*   prepared in advance, and for each capture length in CAPTURE_CYCLES[] the
+*   oscilloscope timebase, memory depth and dwell time, so that measuring a
+*   point only executes the step. The capture length is chosen while
+*   sweeping. The acquisition memory depth of each capture is the smallest
+*   that samples SAMPLES_PER_CYCLE points per stimulus cycle.
+*
+*   Frequencies are computed directly from the step index rather than
+*   accumulated, so there is no drift over long sweeps:
+*     LOG: fStart * 10^(k/Npoints)      (Npoints per decade)
+*     LIN: fStart + k*(fStop-fStart)/(Npoints-1)
+*
+*   A plan is a value: it can be inspected, copied, and reused for any
+*   number of sweeps with the same frequency and dwell configuration.
+*
+* Created    : 10/16/2026
+* Modified   : 10/16/2026
+* Author     : Kerry S. Martin, martin@wild-wood.net
+*******************************************************************************/
+#pragma once
+#include "FreqResp.h"
+#include <string>
+#include <vector>
+
+// number of capture lengths prepared for each step (see SweepPlan::CAPTURE_CYCLES)
+constexpr size_t SWEEP_CAPTURE_LEVELS = 5;
+
+struct SweepCapture
+{
+	ScopeDriver::TimeDiv tdiv;			// oscilloscope time/division
+	double tcapture;					// capture time of the chosen timebase (s)
+	unsigned long dwell_msec;			// settling time after changing frequency
+	ScopeDriver::MemDepth mdepth;		// acquisition memory depth
+};
+
+struct SweepStep
+{
+	double freq;						// stimulus frequency (Hz)
+	std::string strFreqCommand;			// generator command setting freq
+	SweepCapture capture[SWEEP_CAPTURE_LEVELS];	// one per CAPTURE_CYCLES level
+};
+
+class SweepPlan
+{
+public:
+	SweepPlan();
+
+	bool Build(Freq_Config const& freq, Dwell_Config const& dwell, ScopeDriver const& scope, GeneratorDriver const& gen, GeneratorDriver::Channel sgChannel);
+	void Clear();
+	SweepStep Step(double f, ScopeDriver const& scope, GeneratorDriver const& gen, GeneratorDriver::Channel sgChannel) const;
+
+	// inspection
+	size_t Size() const;
+	bool Empty() const;
+	SweepStep const& operator [] (size_t i) const;
+	std::vector<SweepStep>::const_iterator begin() const;
+	std::vector<SweepStep>::const_iterator end() const;
+	Freq_Config const& FreqConfig() const;
+	Dwell_Config const& DwellConfig() const;
+
+	double Frequency(size_t k) const;
+	size_t FindStep(double f) const;
+	double EstimateDuration() const;
+	std::vector<size_t> CoarseToFine() const;
+
+	// constant settings
+	static const double FREQ_FUDGE;
+	static const double CAPTURE_CYCLES[SWEEP_CAPTURE_LEVELS];
+	static const size_t CAPTURE_DEFAULT;
+	static const double SAMPLES_PER_CYCLE;
+	static const double EST_OVERHEAD_SEC;
+
+private:
+	std::vector<SweepStep> steps;
+	Freq_Config freq;
+	Dwell_Config dwell;
+};
+
+
+/*******************************************************************************
+* Copyright  2026 Kerry S. Martin, martin@wild-wood.net
+* Free for usage without warranty, expressed or implied; attribution required
+*******************************************************************************/
\ No newline at end of file
@@ -0,0 +1,483 @@
+/*******************************************************************************
+* Copyright  2026 Kerry S. Martin, martin@wild-wood.net
+* Free for usage without warranty, expressed or implied; attribution required
+*
+* Filename   : TransferFit.cpp
+* Class      : TransferFit
+* Description:
+*   TransferFit fits a rational transfer function to the measured points of
+*   a sweep, and detects when the fit has converged.
+*
+* Created    : 10/16/2026
+* Modified   : 10/16/2026
+* Author     : Kerry S. Martin, martin@wild-wood.net
+*******************************************************************************/
+
+#include "TransferFit.h"
+#include <cmath>
+#include <limits>
+
+using namespace std;
+
+constexpr double PI = 3.14159265358979323846;
+
+// highest order of the numerator and denominator
+const unsigned int TransferFit::ORDER_MAX{ 8 };
+
+// most Sanathanan-Koerner reweightings of one fit
+const unsigned int TransferFit::SK_ITERATIONS{ 10 };
+
+// successive fits within the tolerance for the model to have converged
+const unsigned int TransferFit::STABLE_FITS{ 3 };
+
+// roots nearer the origin than this fraction of the center frequency are
+// compared by their distance relative to it, rather than to themselves
+const double TransferFit::ROOT_FLOOR{ 1e-3 };
+
+
+/*******************************************************************************
+* Class      : TransferFit
+* Function   : TransferFit() constructor
+* Access     : public
+* Arguments  : config = orders of the model and the convergence tolerance
+* Returns    : none
+* Description:
+*   Constructs a fit with no model yet
+*/
+TransferFit::TransferFit(Fit_Config const& config) : config(config), model(), previous(), bFitted(false), nStable(0)
+{
+}
+
+
+/*******************************************************************************
+* Class      : TransferFit
+* Function   : Update()
+* Access     : public
+* Arguments  : points = points measured so far (any order)
+* Returns    : true once the model has converged
+* Description:
+*   Refits the model with the points measured so far, typically after each
+*   new point, and compares it with the previous fit
+*/
+bool TransferFit::Update(FRST const& points)
+{
+	const FR_Model last = model;
+	const bool bHadFit = bFitted;
+
+	if (!Fit(points))
+	{
+		nStable = 0;
+		return false;
+	}
+
+	// compare at the center frequency of this fit
+	double fMin = HUGE_VAL, fMax = 0.0;
+	for (auto const& point : points)
+	{
+		if (point.freq < fMin)
+			fMin = point.freq;
+		if (point.freq > fMax)
+			fMax = point.freq;
+	}
+	const double w0 = 2.0 * PI * sqrt(fMin * fMax);
+
+	if (bHadFit && Unchanged(model, last, w0))
+		nStable = nStable + 1;
+	else
+		nStable = 0;
+
+	previous = last;
+	model.converged = (nStable >= STABLE_FITS);
+
+	return model.converged;
+}
+
+
+/*******************************************************************************
+* Class      : TransferFit
+* Function   : Fit()
+* Access     : public
+* Arguments  : points = points to fit (any order; points that failed to
+*                       measure are skipped)
+* Returns    : true if the model was fitted
+* Description:
+*   Fits the model by the Sanathanan-Koerner iteration. There must be more
+*   equations (two per point, real and imaginary) than coefficients.
+*/
+bool TransferFit::Fit(FRST const& points)
+{
+	const size_t nNum = config.nZeros + 1;
+	const size_t nDen = config.nPoles;
+	const size_t nCols = nNum + nDen;
+
+	vector<double> f;
+	vector<complex<double>> h;
+
+	bFitted = false;
+
+	for (auto const& point : points)
+	{
+		const double phase = (point.tunit == TUNIT::PHASE) ? point.time : -360.0 * point.freq * point.time;
+		if (point.freq > 0.0 && isfinite(point.dBgain) && isfinite(phase))
+		{
+			f.push_back(point.freq);
+			h.push_back(polar(pow(10.0, point.dBgain / 20.0), phase * PI / 180.0));
+		}
+	}
+
+	const size_t nRows = 2 * f.size();
+	if (nRows < nCols + 2 || config.nPoles > ORDER_MAX || config.nZeros > ORDER_MAX)
+		return false;
+
+	// scale the frequencies to their geometric center
+	double fMin = f[0], fMax = f[0];
+	for (double fk : f)
+	{
+		if (fk < fMin)
+			fMin = fk;
+		if (fk > fMax)
+			fMax = fk;
+	}
+	const double w0 = 2.0 * PI * sqrt(fMin * fMax);
+
+	vector<complex<double>> s(f.size());
+	for (size_t k = 0; k < f.size(); ++k)
+		s[k] = complex<double>(0.0, 2.0 * PI * f[k] / w0);
+
+	vector<double> num(nNum, 0.0);
+	vector<double> den(nDen + 1, 0.0);
+	den[0] = 1.0;
+
+	for (unsigned int iter = 0; iter < SK_ITERATIONS; ++iter)
+	{
+		vector<double> a(nRows * nCols);
+		vector<double> b(nRows);
+		vector<double> x;
+
+		// num(s)/|den'(s)| - H.(den(s)-1)/|den'(s)| = H/|den'(s)|, den' from the last iteration
+		for (size_t k = 0; k < f.size(); ++k)
+		{
+			const double weight = 1.0 / abs(Evaluate(den, s[k]));
+			complex<double> sPow = weight;
+
+			for (size_t i = 0; i < nNum || i <= nDen; ++i)
+			{
+				if (i < nNum)
+				{
+					a[(2 * k) * nCols + i] = sPow.real();
+					a[(2 * k + 1) * nCols + i] = sPow.imag();
+				}
+				if (i >= 1 && i <= nDen)
+				{
+					const complex<double> term = -h[k] * sPow;
+					a[(2 * k) * nCols + nNum + i - 1] = term.real();
+					a[(2 * k + 1) * nCols + nNum + i - 1] = term.imag();
+				}
+				sPow *= s[k];
+			}
+
+			b[2 * k] = (h[k] * weight).real();
+			b[2 * k + 1] = (h[k] * weight).imag();
+		}
+
+		if (!SolveLeastSquares(a, nRows, nCols, b, x))
+			return false;
+
+		double change = 0.0;
+		for (size_t i = 1; i <= nDen; ++i)
+		{
+			change = max(change, abs(x[nNum + i - 1] - den[i]) / max(abs(x[nNum + i - 1]), 1.0));
+			den[i] = x[nNum + i - 1];
+		}
+		for (size_t i = 0; i < nNum; ++i)
+			num[i] = x[i];
+
+		if (change < 1e-9)
+			break;
+	}
+
+	// poles and zeros, back in rad/s
+	if (!Roots(num, model.zeros) || !Roots(den, model.poles))
+		return false;
+	for (auto& zero : model.zeros)
+		zero *= w0;
+	for (auto& pole : model.poles)
+		pole *= w0;
+
+	// fit error
+	double sum_dB = 0.0, sum_deg = 0.0;
+	for (size_t k = 0; k < f.size(); ++k)
+	{
+		const complex<double> ratio = Evaluate(num, s[k]) / Evaluate(den, s[k]) / h[k];
+		sum_dB += pow(20.0 * log10(abs(ratio)), 2);
+		sum_deg += pow(arg(ratio) * 180.0 / PI, 2);
+	}
+
+	// coefficients, back in rad/s
+	double scale = 1.0;
+	model.num.assign(nNum, 0.0);
+	model.den.assign(nDen + 1, 0.0);
+	for (size_t i = 0; i < nNum || i <= nDen; ++i)
+	{
+		if (i < nNum)
+			model.num[i] = num[i] / scale;
+		if (i <= nDen)
+			model.den[i] = den[i] / scale;
+		scale *= w0;
+	}
+
+	model.rms_dB = sqrt(sum_dB / f.size());
+	model.rms_deg = sqrt(sum_deg / f.size());
+	model.nPoints = (unsigned int)f.size();
+	model.converged = false;
+	bFitted = true;
+
+	return true;
+}
+
+
+/*******************************************************************************
+* Class      : TransferFit
+* Function   : Model(), Converged()
+* Access     : public
+* Description:
+*   The last model fitted, and whether it has converged
+*/
+FR_Model const& TransferFit::Model() const
+{
+	return model;
+}
+
+bool TransferFit::Converged() const
+{
+	return bFitted && model.converged;
+}
+
+
+/*******************************************************************************
+* Class      : TransferFit
+* Function   : Unchanged()
+* Access     : private
+* Arguments  : a, b = models to compare
+*              w0   = center frequency of the fit (rad/s)
+* Returns    : true if the poles, zeros and gain at w0 are within the tolerance
+* Description:
+*   Compares two successive fits
+*/
+bool TransferFit::Unchanged(FR_Model const& a, FR_Model const& b, double w0) const
+{
+	const complex<double> s0(0.0, w0);
+	const double gainA = abs(Evaluate(a.num, s0) / Evaluate(a.den, s0));
+	const double gainB = abs(Evaluate(b.num, s0) / Evaluate(b.den, s0));
+
+	return RootsMatch(a.poles, b.poles, config.tolerance, ROOT_FLOOR * w0)
+		&& RootsMatch(a.zeros, b.zeros, config.tolerance, ROOT_FLOOR * w0)
+		&& abs(gainA - gainB) <= config.tolerance * gainB;
+}
+
+
+/*******************************************************************************
+* Class      : TransferFit
+* Function   : Evaluate()
+* Access     : private static
+* Arguments  : coeffs = polynomial coefficients, ascending powers
+*              s      = point to evaluate at
+* Returns    : the value of the polynomial at s (Horner's method)
+*/
+std::complex<double> TransferFit::Evaluate(std::vector<double> const& coeffs, std::complex<double> s)
+{
+	complex<double> value = 0.0;
+
+	for (size_t i = coeffs.size(); i-- > 0;)
+		value = value * s + coeffs[i];
+
+	return value;
+}
+
+
+/*******************************************************************************
+* Class      : TransferFit
+* Function   : SolveLeastSquares()
+* Access     : private static
+* Arguments  : a    = matrix, rows x cols, row-major (overwritten)
+*              rows = rows of a (rows >= cols)
+*              cols = columns of a
+*              b    = right hand side, rows (overwritten)
+*              x    = receives the solution, cols
+* Returns    : true if a has full column rank
+* Description:
+*   Minimizes |a.x - b| by Householder QR, which does not square the
+*   condition number of a as the normal equations would
+*/
+bool TransferFit::SolveLeastSquares(std::vector<double>& a, size_t rows, size_t cols, std::vector<double>& b, std::vector<double>& x)
+{
+	vector<double> diag(cols);
+
+	for (size_t k = 0; k < cols; ++k)
+	{
+		double norm = 0.0;
+		for (size_t i = k; i < rows; ++i)
+			norm += a[i * cols + k] * a[i * cols + k];
+		norm = sqrt(norm);
+
+		if (!(norm > 0.0))
+			return false;
+
+		// reflect column k onto -sign(akk).norm.e1
+		const double alpha = (a[k * cols + k] > 0.0) ? -norm : norm;
+		const double vnorm2 = 2.0 * norm * (norm + abs(a[k * cols + k]));
+		a[k * cols + k] -= alpha;
+
+		for (size_t j = k + 1; j < cols; ++j)
+		{
+			double dot = 0.0;
+			for (size_t i = k; i < rows; ++i)
+				dot += a[i * cols + k] * a[i * cols + j];
+			const double factor = 2.0 * dot / vnorm2;
+			for (size_t i = k; i < rows; ++i)
+				a[i * cols + j] -= factor * a[i * cols + k];
+		}
+
+		double dot = 0.0;
+		for (size_t i = k; i < rows; ++i)
+			dot += a[i * cols + k] * b[i];
+		const double factor = 2.0 * dot / vnorm2;
+		for (size_t i = k; i < rows; ++i)
+			b[i] -= factor * a[i * cols + k];
+
+		diag[k] = alpha;
+	}
+
+	if (!(abs(diag[cols - 1]) > 1e-12 * abs(diag[0])))
+		return false;
+
+	// back substitution through R
+	x.assign(cols, 0.0);
+	for (size_t k = cols; k-- > 0;)
+	{
+		double sum = b[k];
+		for (size_t j = k + 1; j < cols; ++j)
+			sum -= a[k * cols + j] * x[j];
+		x[k] = sum / diag[k];
+	}
+
+	return true;
+}
+
+
+/*******************************************************************************
+* Class      : TransferFit
+* Function   : Roots()
+* Access     : private static
+* Arguments  : coeffs = polynomial coefficients, ascending powers
+*              roots  = receives the roots
+* Returns    : true if the roots were found
+* Description:
+*   Finds all the roots of a polynomial at once by the Durand-Kerner
+*   iteration. A leading coefficient of zero (the fit needed a lower order)
+*   fails, since the roots would not be comparable from fit to fit.
+*/
+bool TransferFit::Roots(std::vector<double> const& coeffs, std::vector<std::complex<double>>& roots)
+{
+	const size_t n = coeffs.size() - 1;
+	double largest = 0.0;
+
+	roots.clear();
+	if (n == 0)
+		return true;
+
+	for (double c : coeffs)
+		largest = max(largest, abs(c));
+	if (!(abs(coeffs[n]) > 1e-12 * largest))
+		return false;
+
+	// monic, and start on a circle that holds every root
+	vector<complex<double>> monic(coeffs.size());
+	double radius = 0.0;
+	for (size_t i = 0; i <= n; ++i)
+	{
+		monic[i] = coeffs[i] / coeffs[n];
+		if (i < n)
+			radius = max(radius, abs(monic[i]));
+	}
+	radius = 1.0 + radius;
+
+	for (size_t k = 0; k < n; ++k)
+		roots.push_back(polar(0.5 * radius, 2.0 * PI * k / n + 0.4));
+
+	for (int iter = 0; iter < 500; ++iter)
+	{
+		double change = 0.0;
+
+		for (size_t k = 0; k < n; ++k)
+		{
+			complex<double> value = 0.0;
+			for (size_t i = n + 1; i-- > 0;)
+				value = value * roots[k] + monic[i];
+
+			complex<double> product = 1.0;
+			for (size_t j = 0; j < n; ++j)
+			{
+				if (j != k)
+					product *= roots[k] - roots[j];
+			}
+
+			const complex<double> step = value / product;
+			roots[k] -= step;
+			change = max(change, abs(step) / (1.0 + abs(roots[k])));
+		}
+
+		if (change < 1e-14)
+			break;
+	}
+
+	for (auto const& root : roots)
+	{
+		if (!isfinite(root.real()) || !isfinite(root.imag()))
+			return false;
+	}
+
+	return true;
+}
+
+
+/*******************************************************************************
+* Class      : TransferFit
+* Function   : RootsMatch()
+* Access     : private static
+* Arguments  : a, b      = roots of two fits
+*              tolerance = largest relative movement of a root
+*              floor     = magnitude below which a root's movement is taken
+*                          relative to floor instead
+* Returns    : true if every root of a is within the tolerance of its own
+*              root of b
+*/
+bool TransferFit::RootsMatch(std::vector<std::complex<double>> const& a, std::vector<std::complex<double>> const& b, double tolerance, double floor)
+{
+	if (a.size() != b.size())
+		return false;
+
+	vector<bool> used(b.size(), false);
+
+	for (auto const& root : a)
+	{
+		size_t iBest = b.size();
+		for (size_t j = 0; j < b.size(); ++j)
+		{
+			if (!used[j] && (iBest == b.size() || abs(root - b[j]) < abs(root - b[iBest])))
+				iBest = j;
+		}
+
+		if (abs(root - b[iBest]) > tolerance * max(abs(b[iBest]), floor))
+			return false;
+		used[iBest] = true;
+	}
+
+	return true;
+}
+
+
+/*******************************************************************************
+* Copyright  2026 Kerry S. Martin, martin@wild-wood.net
+* Free for usage without warranty, expressed or implied; attribution required
+*******************************************************************************/
\ No newline at end of file
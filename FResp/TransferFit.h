@@ -0,0 +1,67 @@
+/*******************************************************************************
+* Copyright  2026 Kerry S. Martin, martin@wild-wood.net
+* Free for usage without warranty, expressed or implied; attribution required
+*
+* Filename   : TransferFit.h
+* Class      : TransferFit
+* Description:
+*   TransferFit fits a rational model H(s) = num(s)/den(s) of given orders to
+*   the points of a sweep as they are measured, and tells when the model has
+*   stopped changing, so a sweep of a circuit of known topology can end after
+*   a fraction of its points.
+*
+*   The fit is the Sanathanan-Koerner iteration: the linearized problem
+*   num(s) - H.den(s) = 0 is solved by least squares (Householder QR),
+*   weighted each time by 1/|den(s)| of the previous solution, which
+*   converges to the fit of the relative error of H. Frequencies are scaled
+*   to the geometric center of the points fitted for conditioning. den(0) is
+*   1, so a pole at the origin (an integrator) cannot be modelled.
+*
+*   Update() refits after each new point. The model has converged once its
+*   poles, zeros and gain have each moved less than the tolerance between
+*   STABLE_FITS successive fits.
+*
+* Created    : 10/16/2026
+* Modified   : 10/16/2026
+* Author     : Kerry S. Martin, martin@wild-wood.net
+*******************************************************************************/
+#pragma once
+#include "FreqResp.h"
+#include <complex>
+#include <vector>
+
+class TransferFit
+{
+public:
+	explicit TransferFit(Fit_Config const& config);
+
+	bool Update(FRST const& points);
+	bool Fit(FRST const& points);
+	FR_Model const& Model() const;
+	bool Converged() const;
+
+	// constant settings
+	static const unsigned int ORDER_MAX;
+	static const unsigned int SK_ITERATIONS;
+	static const unsigned int STABLE_FITS;
+	static const double ROOT_FLOOR;
+
+private:
+	Fit_Config config;
+	FR_Model model;
+	FR_Model previous;
+	bool bFitted;
+	unsigned int nStable;		// successive fits within the tolerance
+
+	bool Unchanged(FR_Model const& a, FR_Model const& b, double w0) const;
+	static std::complex<double> Evaluate(std::vector<double> const& coeffs, std::complex<double> s);
+	static bool SolveLeastSquares(std::vector<double>& a, size_t rows, size_t cols, std::vector<double>& b, std::vector<double>& x);
+	static bool Roots(std::vector<double> const& coeffs, std::vector<std::complex<double>>& roots);
+	static bool RootsMatch(std::vector<std::complex<double>> const& a, std::vector<std::complex<double>> const& b, double tolerance, double floor);
+};
+
+
+/*******************************************************************************
+* Copyright  2026 Kerry S. Martin, martin@wild-wood.net
+* Free for usage without warranty, expressed or implied; attribution required
+*******************************************************************************/
\ No newline at end of file